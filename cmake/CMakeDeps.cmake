@@ -3,6 +3,7 @@
 # ============================
 
 find_package(Vulkan REQUIRED)
+find_package(Threads REQUIRED)
 add_subdirectory(${CMAKE_CURRENT_SOURCE_DIR}/vendor/VulkanMemoryAllocator)
 if(WULKAN_ENABLE_GLFW)
     set(GLFW_BUILD_DOCS OFF CACHE BOOL "" FORCE)
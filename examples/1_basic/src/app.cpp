@@ -91,13 +91,44 @@ int App::_init_vulkan() {
     _surface = wk::ext::glfw::Surface(_instance.handle(), _window);
 
     // ---------- device ----------
-    VkPhysicalDeviceFeatures2 physical_device_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+    VkPhysicalDeviceSynchronization2Features synchronization2_features = wk::PhysicalDeviceSynchronization2Features{}
+        .set_synchronization2(VK_TRUE)
+        .to_vk();
+    VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_features = wk::PhysicalDeviceDynamicRenderingFeatures{}
+        .set_p_next(&synchronization2_features)
+        .set_dynamic_rendering(VK_TRUE)
+        .to_vk();
+    VkPhysicalDeviceFeatures2 physical_device_features = wk::PhysicalDeviceFeatures2{}
+        .set_p_next(&dynamic_rendering_features)
+        .to_vk();
+    // Per-frame bindings are pushed straight into the command buffer
+    std::vector<const char*> device_extensions = wk::GetRequiredDeviceExtensions();
+    device_extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
     _physical_device = wk::PhysicalDevice(_instance.handle(), _surface.handle(),
-        wk::GetRequiredDeviceExtensions(), &physical_device_features,
+        device_extensions, &physical_device_features,
         &wk::DefaultPhysicalDeviceFeatureScorer
     );
     wk::PhysicalDeviceSurfaceSupport physical_device_support = wk::GetPhysicalDeviceSurfaceSupport(_physical_device.handle(), _surface.handle());
     wk::DeviceQueueFamilyIndices queue_family_indices = _physical_device.queue_family_indices();
+    // enable every core feature the selected device has, as pEnabledFeatures did
+    physical_device_features.features = _physical_device.features();
+
+    // Present pacing is optional, enabled on top of the selected device
+    std::vector<const char*> enabled_device_extensions = _physical_device.extensions();
+    bool is_present_wait_supported = wk::IsPresentWaitSupported(_physical_device.handle());
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    present_wait_features.presentWait = VK_TRUE;
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    present_id_features.pNext = &present_wait_features;
+    present_id_features.presentId = VK_TRUE;
+    if (is_present_wait_supported) {
+        enabled_device_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        enabled_device_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        present_wait_features.pNext = physical_device_features.pNext;
+        physical_device_features.pNext = &present_id_features;
+    }
 
     const float QUEUE_PRIORITY = 1.0f;
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos = {
@@ -118,11 +149,15 @@ int App::_init_vulkan() {
 
     _device = wk::Device(_physical_device.handle(), queue_family_indices,
         wk::DeviceCreateInfo{}
-            .set_p_enabled_features(&_physical_device.features())
-            .set_enabled_extensions(_physical_device.extensions().size(),
-                                    _physical_device.extensions().data())
+            .set_p_next(&physical_device_features)
+            .set_enabled_extensions(enabled_device_extensions.size(),
+                                    enabled_device_extensions.data())
             .set_queue_create_infos(queue_create_infos.size(), queue_create_infos.data())
             .to_vk());
+    _device_functions = wk::LoadDeviceFunctions(_device.handle(),
+        std::min<uint32_t>(VK_API_VERSION_1_3, _physical_device.properties().apiVersion), enabled_device_extensions);
+    _present_controller = wk::PresentController(_device.handle(), _device_functions, is_present_wait_supported,
+        static_cast<uint32_t>(_MAX_FRAMES_IN_FLIGHT), wk::LatencyMode::Balanced);
 
     // ---------- Command pool ----------
     _command_pool = wk::CommandPool(_device.handle(),
@@ -160,7 +195,7 @@ int App::_init_vulkan() {
     _swapchain = wk::Swapchain(_device.handle(),
         wk::SwapchainCreateInfo{}
             .set_surface(_surface.handle())
-            .set_present_mode(wk::ChooseSurfacePresentationMode(physical_device_support.present_modes))
+            .set_present_mode(_present_controller.choose_present_mode(physical_device_support.present_modes))
             .set_min_image_count(std::clamp(
                 physical_device_support.capabilities.minImageCount + 1,
                 physical_device_support.capabilities.minImageCount,
@@ -176,76 +211,17 @@ int App::_init_vulkan() {
             .to_vk()
     );
 
-    // ---------- Render pass ----------
+    // ---------- Depth attachments ----------
     VkFormat depth_format = wk::ChooseDepthFormat(_physical_device.handle(), _DEPTH_FORMATS);
-
-    VkAttachmentDescription attachments[2] = {
-        wk::AttachmentDescription{}
-            .set_flags(0)
-            .set_format(image_format)
-            .set_samples(VK_SAMPLE_COUNT_1_BIT)
-            .set_load_op(VK_ATTACHMENT_LOAD_OP_CLEAR)
-            .set_store_op(VK_ATTACHMENT_STORE_OP_STORE)
-            .set_stencil_load_op(VK_ATTACHMENT_LOAD_OP_DONT_CARE)
-            .set_stencil_store_op(VK_ATTACHMENT_STORE_OP_DONT_CARE)
-            .set_initial_layout(VK_IMAGE_LAYOUT_UNDEFINED)
-            .set_final_layout(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
-            .to_vk(),
-        wk::AttachmentDescription{}
-            .set_flags(0)
-            .set_format(depth_format)
-            .set_samples(VK_SAMPLE_COUNT_1_BIT)
-            .set_load_op(VK_ATTACHMENT_LOAD_OP_CLEAR)
-            .set_store_op(VK_ATTACHMENT_STORE_OP_DONT_CARE)
-            .set_stencil_load_op(VK_ATTACHMENT_LOAD_OP_CLEAR)
-            .set_stencil_store_op(VK_ATTACHMENT_STORE_OP_DONT_CARE)
-            .set_initial_layout(VK_IMAGE_LAYOUT_UNDEFINED)
-            .set_final_layout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-            .to_vk()
-    };
-    
-    VkAttachmentReference color_attachment_ref = wk::AttachmentReference{}
-        .set_attachment(0)
-        .set_layout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-        .to_vk();
-
-    VkAttachmentReference depth_attachment_ref = wk::AttachmentReference{}
-        .set_attachment(1)
-        .set_layout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-        .to_vk();
-
-    VkSubpassDescription subpass = wk::SubpassDescription{}
-        .set_pipeline_bind_point(VK_PIPELINE_BIND_POINT_GRAPHICS)
-        .set_color_attachments(1, &color_attachment_ref)
-        .set_depth_stencil_attachment(&depth_attachment_ref)
-        .to_vk();
-
-    VkSubpassDependency dependency = wk::SubpassDependency{}
-        .set_src_subpass(VK_SUBPASS_EXTERNAL)
-        .set_dst_subpass(0)
-        .set_src_stage_mask(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
-        .set_dst_stage_mask(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
-        .set_src_access_mask(0)
-        .set_dst_access_mask(VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT)
-        .to_vk();
-
-    _render_pass = wk::RenderPass(_device.handle(),
-        wk::RenderPassCreateInfo{}
-            .set_attachments(2, attachments)
-            .set_subpasses(1, &subpass)
-            .set_dependencies(1, &dependency)
-            .to_vk()
-    );
+    _depth_format = depth_format;
 
     _depth_images.clear();
     _depth_image_views.clear();
-    _framebuffers.clear();
     _depth_images.reserve(_swapchain.image_views().size());
     _depth_image_views.reserve(_swapchain.image_views().size());
-    _framebuffers.reserve(_swapchain.image_views().size());
 
     for (size_t i = 0; i < _swapchain.image_views().size(); ++i) {
-        // Depth image per framebuffer
+        // Depth image per swapchain image
         _depth_images.emplace_back(
             _allocator.handle(),
             wk::ImageCreateInfo{}
@@ -284,72 +260,40 @@ int App::_init_vulkan() {
                 )
                 .to_vk()
         );
-
-        // Framebuffer (color + depth)
-        std::vector<VkImageView> attachments = {
-            _swapchain.image_views()[i],
-            _depth_image_views.back().handle()
-        };
-
-        _framebuffers.emplace_back(
-            _device.handle(),
-            wk::FramebufferCreateInfo{}
-                .set_render_pass(_render_pass.handle())
-                .set_attachments(static_cast<uint32_t>(attachments.size()), attachments.data())
-                .set_extent(_swapchain.extent())
-                .set_layers(1)
-                .to_vk()
-        );
     }
 
     // ---------- Graphics pipeline ----------
-    VkDescriptorSetLayoutBinding bindings[] = {
-        wk::DescriptorSetLayoutBinding{}
-            .set_binding(0)
-            .set_descriptor_type(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-            .set_descriptor_count(1)
-            .set_stage_flags(VK_SHADER_STAGE_VERTEX_BIT)
-            .to_vk()
-    };
-    
-    wk::DescriptorSetLayout descriptor_set_layout(_device.handle(),
-        wk::DescriptorSetLayoutCreateInfo{}
-            .set_bindings(1, bindings)
-            .to_vk()
-    );
-    
-    VkDescriptorSetLayout layouts[] = { descriptor_set_layout.handle() };
+    _shader_pack = wk::ShaderPack("build/bin/example1_basic/Debug/shaders/shaders.wkpack");
+    const wk::ShaderPackEntry& vert_spv = _shader_pack.at("triangle.vert.spv");
+    const wk::ShaderPackEntry& frag_spv = _shader_pack.at("triangle.frag.spv");
 
-    _pipeline_layout = wk::PipelineLayout(_device.handle(), 
-        wk::PipelineLayoutCreateInfo{}
-            .set_set_layouts(1, layouts)
-            .set_push_constant_ranges(0, nullptr)
-            .to_vk()
-    );
+    VkShaderModuleCreateInfo vert_ci = vert_spv.module_create_info();
+    VkShaderModuleCreateInfo frag_ci = frag_spv.module_create_info();
 
-    std::vector<uint8_t> vert_byte_code = wk::ReadSpirvShader("build/bin/example1_basic/Debug/shaders/triangle.vert.spv");
-    std::vector<uint8_t> frag_byte_code = wk::ReadSpirvShader("build/bin/example1_basic/Debug/shaders/triangle.frag.spv");
+    _shader_modules = wk::ShaderModuleCache(_device.handle());
+    VkShaderModule vert = _shader_modules.get(vert_spv);
+    VkShaderModule frag = _shader_modules.get(frag_spv);
 
-    wk::ShaderModule vert(_device.handle(),
-        wk::ShaderModuleCreateInfo{}
-            .set_byte_code(vert_byte_code.size(), vert_byte_code.data())
-            .to_vk()
-    );
-    wk::ShaderModule frag(_device.handle(),
-        wk::ShaderModuleCreateInfo{}
-            .set_byte_code(frag_byte_code.size(), frag_byte_code.data())
-            .to_vk()
-    );
+    // Layouts come from the shaders themselves
+    wk::ShaderReflection stage_reflections[2] = {
+        wk::ReflectShaderModule(vert_ci),
+        wk::ReflectShaderModule(frag_ci)
+    };
+    wk::ShaderReflection program_reflection = wk::MergeShaderReflections(2, stage_reflections);
+
+    _layout_cache = wk::LayoutCache(_device.handle());
+    std::vector<VkDescriptorSetLayout> layouts = _layout_cache.descriptor_set_layouts(program_reflection, 1, 0);
+    _pipeline_layout = _layout_cache.pipeline_layout(program_reflection, 1, 0);
 
     VkPipelineShaderStageCreateInfo shader_stages[2] = {
         wk::PipelineShaderStageCreateInfo{}
             .set_stage(VK_SHADER_STAGE_VERTEX_BIT)
-            .set_module(vert.handle())
+            .set_module(vert)
             .set_p_name("main")
             .to_vk(),
         wk::PipelineShaderStageCreateInfo{}
             .set_stage(VK_SHADER_STAGE_FRAGMENT_BIT)
-            .set_module(frag.handle())
+            .set_module(frag)
             .set_p_name("main")
             .to_vk()
     };
@@ -439,13 +383,38 @@ int App::_init_vulkan() {
         .set_attachments(1, &color_blend_attachment)
         .to_vk();
     
-    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    // Cull and depth state are set while recording where the device allows
+    // it, so variants that only differ there share one pipeline
+    wk::ExtendedDynamicStateSupport dynamic_state_support;
+    wk::QueryExtendedDynamicStateSupport(_physical_device.handle(), dynamic_state_support);
+    VkDynamicState wanted_dynamic_states[] = {
+        VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_CULL_MODE, VK_DYNAMIC_STATE_FRONT_FACE,
+        VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP
+    };
+    std::vector<VkDynamicState> dynamic_states = wk::FilterSupportedDynamicStates(dynamic_state_support,
+        static_cast<uint32_t>(std::size(wanted_dynamic_states)), wanted_dynamic_states);
+    _is_raster_state_dynamic = dynamic_states.size() == std::size(wanted_dynamic_states);
     VkPipelineDynamicStateCreateInfo dynamic_ci = wk::PipelineDynamicStateCreateInfo{}
-        .set_dynamic_states(2, dynamic_states)
+        .set_dynamic_states(static_cast<uint32_t>(dynamic_states.size()), dynamic_states.data())
         .to_vk();
 
-    _pipeline = wk::Pipeline(_device.handle(), 
+    VkFormat color_formats[] = { _swapchain.image_format() };
+    VkPipelineRenderingCreateInfo rendering_ci = wk::PipelineRenderingCreateInfo{}
+        .set_color_attachment_formats(1, color_formats)
+        .set_depth_attachment_format(depth_format)
+        .to_vk();
+
+#ifdef WLK_PRINT_PIPELINE_REPORT
+    wk::PipelineCreationReport pipeline_report;
+    wk::PipelineCreationReport* p_pipeline_report = &pipeline_report;
+#else
+    wk::PipelineCreationReport* p_pipeline_report = nullptr;
+#endif
+    _pipelines = wk::GraphicsPipelineCache(_device.handle());
+    _pipeline = _pipelines.get(
         wk::PipelineCreateInfo{}
+            .set_p_next(&rendering_ci)
             .set_stages(2, shader_stages)
             .set_p_vertex_input_state(&vertex_input_ci)
             .set_p_input_assembly_state(&input_assembly_ci)
@@ -455,11 +424,13 @@ int App::_init_vulkan() {
             .set_p_depth_stencil_state(&depth_stencil_ci)
             .set_p_color_blend_state(&color_blend_state_ci)
             .set_p_dynamic_state(&dynamic_ci)
-            .set_layout(_pipeline_layout.handle())
-            .set_render_pass(_render_pass.handle())
-            .set_subpass(0)
-            .to_vk()
+            .set_layout(_pipeline_layout)
+            .to_vk(),
+        p_pipeline_report, "triangle"
     );
+#ifdef WLK_PRINT_PIPELINE_REPORT
+    pipeline_report.print(std::cout);
+#endif
 
     // ---------- Geometry buffers ----------
     _vertex_buffer = wk::Buffer(_allocator.handle(),
@@ -570,50 +541,9 @@ int App::_init_vulkan() {
         );
     }
 
-    // ---------- Descriptor pool ----------
-    VkDescriptorPoolSize pool_sizes[] = {
-        wk::DescriptorPoolSize{}
-            .set_type(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-            .set_descriptor_count(static_cast<uint32_t>(_MAX_FRAMES_IN_FLIGHT))
-            .to_vk()
-    };
-
-    _descriptor_pool = wk::DescriptorPool(_device.handle(),
-        wk::DescriptorPoolCreateInfo{}
-            .set_max_sets(_MAX_FRAMES_IN_FLIGHT)
-            .set_flags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
-            .set_pool_sizes(1, pool_sizes)
-            .to_vk()
-    );
-
-    // ---------- Descriptor sets ----------
-    _descriptor_sets.clear();
-    _descriptor_sets.reserve(_MAX_FRAMES_IN_FLIGHT);
-
-    for (size_t i = 0; i < _MAX_FRAMES_IN_FLIGHT; ++i) {
-        _descriptor_sets.emplace_back(_device.handle(),
-            wk::DescriptorSetAllocateInfo{}
-                .set_descriptor_pool(_descriptor_pool.handle())
-                .set_set_layouts(1, layouts)
-                .to_vk()
-        );
-
-        VkDescriptorBufferInfo db_info = wk::DescriptorBufferInfo{}
-            .set_buffer(_uniform_buffers[i].handle())
-            .set_offset(0)
-            .set_range(sizeof(UniformBufferObject))
-            .to_vk();
-
-        VkWriteDescriptorSet write_descriptor_set = wk::WriteDescriptorSet{}
-            .set_dst_set(_descriptor_sets[i].handle())
-            .set_dst_binding(0)
-            .set_descriptor_type(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-            .set_descriptor_count(1)
-            .set_p_buffer_info(&db_info)
-            .to_vk();
-
-        vkUpdateDescriptorSets(_device.handle(), 1, &write_descriptor_set, 0, nullptr);
-    }
+    // ---------- Push descriptors ----------
+    _frame_descriptor_template = wk::TypedDescriptorUpdateTemplate<FrameDescriptors>(_device.handle(),
+        layouts[0], VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline_layout, 0, FRAME_DESCRIPTOR_ENTRIES);
 
     // ---------- Sync & Command buffers ----------
     _command_buffers.clear();
@@ -641,6 +571,7 @@ int App::_init_vulkan() {
                 .set_flags(VK_FENCE_CREATE_SIGNALED_BIT)
                 .to_vk());
     }
+    _deletion_queue = wk::DeletionQueue(static_cast<uint32_t>(_MAX_FRAMES_IN_FLIGHT));
     return 0;
 }
 
@@ -651,6 +582,10 @@ int App::_init_geometry() {
 int App::_main_loop() {
     size_t current_frame_in_flight = 0;
     while (!glfwWindowShouldClose(_window)) {
+        // frames in flight may change from frame to frame; a timed out wait
+        // is retried next frame and acquire reports an out of date swapchain
+        _present_controller.wait_for_frame(_swapchain.handle());
+        current_frame_in_flight %= _present_controller.frames_in_flight();
         vkWaitForFences(_device.handle(), 1, &_frame_in_flight_fences[current_frame_in_flight].handle(), VK_TRUE, UINT64_MAX);
         glfwPollEvents();
 
@@ -669,6 +604,14 @@ int App::_main_loop() {
         }
 
         vkResetFences(_device.handle(), 1, &_frame_in_flight_fences[current_frame_in_flight].handle());
+        _deletion_queue.begin_frame();
+
+        FrameDescriptors frame_descriptors{};
+        frame_descriptors.ubo = wk::DescriptorBufferInfo{}
+            .set_buffer(_uniform_buffers[current_frame_in_flight].handle())
+            .set_offset(0)
+            .set_range(sizeof(UniformBufferObject))
+            .to_vk();
         vkResetCommandBuffer(_command_buffers[current_frame_in_flight].handle(), 0);
 
         VkCommandBufferBeginInfo cb_begin_info = wk::CommandBufferBeginInfo{}.to_vk();
@@ -678,24 +621,56 @@ int App::_main_loop() {
             return 1;
         }
 
-        // Clear screen
-        VkClearValue color_clear{};  color_clear.color        = {{0.0f, 0.0f, 0.0f, 1.0f}};
-        VkClearValue depth_clear{};  depth_clear.depthStencil = {1.0f, 0};
-        std::vector<VkClearValue> clear_values = { color_clear, depth_clear };
+        wk::CommandEncoder encoder(_command_buffers[current_frame_in_flight].handle(), &_device_functions);
+
+        // Transition attachments for rendering
+        VkImageMemoryBarrier2 begin_barriers[2] = {
+            wk::ImageMemoryBarrier2{}
+                .set_src_stage(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT)
+                .set_dst_stage(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT)
+                .set_dst_access(VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT)
+                .set_old_layout(VK_IMAGE_LAYOUT_UNDEFINED)
+                .set_new_layout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+                .set_image(_swapchain.images()[available_image_index])
+                .to_vk(),
+            wk::ImageMemoryBarrier2{}
+                .set_src_stage(VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT)
+                .set_src_access(VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
+                .set_dst_stage(VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT)
+                .set_dst_access(VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
+                .set_old_layout(VK_IMAGE_LAYOUT_UNDEFINED)
+                .set_new_layout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+                .set_image(_depth_images[available_image_index].handle())
+                .set_aspect(wk::GetAspectFlags(_depth_format)) // both aspects when the format has stencil
+                .to_vk()
+        };
+        encoder.pipeline_barrier(wk::DependencyInfo{}
+            .set_image_barriers(2, begin_barriers)
+            .to_vk());
 
-        VkRenderPassBeginInfo rp_begin_info = wk::RenderPassBeginInfo{}
-            .set_render_pass(_render_pass.handle())
-            .set_framebuffer(_framebuffers[available_image_index].handle())
-            .set_render_area({ { 0, 0 }, _swapchain.extent() })
-            .set_clear_values(static_cast<uint32_t>(clear_values.size()), clear_values.data())
+        // Clear screen
+        VkRenderingAttachmentInfo color_attachment = wk::RenderingAttachmentInfo{}
+            .set_image_view(_swapchain.image_views()[available_image_index])
+            .set_image_layout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+            .set_load_op(VK_ATTACHMENT_LOAD_OP_CLEAR)
+            .set_store_op(VK_ATTACHMENT_STORE_OP_STORE)
+            .set_clear_value(wk::ClearValue{}.set_color(0.0f, 0.0f, 0.0f, 1.0f).to_vk())
+            .to_vk();
+        VkRenderingAttachmentInfo depth_attachment = wk::RenderingAttachmentInfo{}
+            .set_image_view(_depth_image_views[available_image_index].handle())
+            .set_image_layout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+            .set_load_op(VK_ATTACHMENT_LOAD_OP_CLEAR)
+            .set_store_op(VK_ATTACHMENT_STORE_OP_DONT_CARE)
+            .set_clear_value(wk::ClearValue{}.set_depth_stencil(1.0f, 0).to_vk())
             .to_vk();
 
-        vkCmdBeginRenderPass(_command_buffers[current_frame_in_flight].handle(), 
-            &rp_begin_info,
-            VK_SUBPASS_CONTENTS_INLINE
-        );
+        encoder.begin_rendering(wk::RenderingInfo{}
+            .set_render_area({ { 0, 0 }, _swapchain.extent() })
+            .set_color_attachments(1, &color_attachment)
+            .set_p_depth_attachment(&depth_attachment)
+            .to_vk());
 
-        vkCmdBindPipeline(_command_buffers[current_frame_in_flight].handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline.handle());
+        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
 
         // Build viewport/scissor
         VkViewport viewport = wk::Viewport{}
@@ -708,8 +683,15 @@ int App::_main_loop() {
             .set_offset({0,0})
             .set_extent(_swapchain.extent())
             .to_vk();
-        vkCmdSetViewport(_command_buffers[current_frame_in_flight].handle(), 0, 1, &viewport);
-        vkCmdSetScissor(_command_buffers[current_frame_in_flight].handle(), 0, 1, &scissor);
+        encoder.set_viewport(viewport)
+               .set_scissor(scissor);
+        if (_is_raster_state_dynamic) {
+            encoder.set_cull_mode(VK_CULL_MODE_BACK_BIT)
+                   .set_front_face(VK_FRONT_FACE_COUNTER_CLOCKWISE)
+                   .set_depth_test_enable(VK_TRUE)
+                   .set_depth_write_enable(VK_TRUE)
+                   .set_depth_compare_op(VK_COMPARE_OP_LESS);
+        }
 
         // UBO update
         UniformBufferObject ubo{};
@@ -728,19 +710,27 @@ int App::_main_loop() {
         memcpy(data, &ubo, sizeof(ubo));
         vmaUnmapMemory(_allocator.handle(), _uniform_buffers[current_frame_in_flight].allocation());
 
-        vkCmdBindDescriptorSets(
-            _command_buffers[current_frame_in_flight].handle(), VK_PIPELINE_BIND_POINT_GRAPHICS,
-            _pipeline_layout.handle(),
-            0, 1, &_descriptor_sets[current_frame_in_flight].handle(),
-            0, nullptr
-        );
+        encoder.push_descriptors(_frame_descriptor_template, frame_descriptors);
 
         VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(_command_buffers[current_frame_in_flight].handle(), 0, 1, &_vertex_buffer.handle(), &offset);
-        vkCmdBindIndexBuffer(_command_buffers[current_frame_in_flight].handle(), _index_buffer.handle(), 0, VK_INDEX_TYPE_UINT16);
-        vkCmdDrawIndexed(_command_buffers[current_frame_in_flight].handle(), static_cast<uint32_t>(_INDICES.size()), 1, 0, 0, 0);
-        
-        vkCmdEndRenderPass(_command_buffers[current_frame_in_flight].handle());
+        encoder.bind_vertex_buffers(0, 1, &_vertex_buffer.handle(), &offset)
+               .bind_index_buffer(_index_buffer.handle(), 0, VK_INDEX_TYPE_UINT16)
+               .draw_indexed(static_cast<uint32_t>(_INDICES.size()));
+
+        encoder.end_rendering();
+
+        VkImageMemoryBarrier2 present_barrier = wk::ImageMemoryBarrier2{}
+            .set_src_stage(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT)
+            .set_src_access(VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT)
+            .set_dst_stage(VK_PIPELINE_STAGE_2_NONE)
+            .set_old_layout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+            .set_new_layout(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+            .set_image(_swapchain.images()[available_image_index])
+            .to_vk();
+        encoder.pipeline_barrier(wk::DependencyInfo{}
+            .set_image_barriers(1, &present_barrier)
+            .to_vk());
+
         result = vkEndCommandBuffer(_command_buffers[current_frame_in_flight].handle());
         if (result != VK_SUCCESS) {
             throw std::runtime_error("failed to end command buffer");
@@ -769,6 +759,7 @@ int App::_main_loop() {
             .set_swapchains(static_cast<uint32_t>(pq_swapchains.size()), pq_swapchains.data())
             .set_image_indices(pq_image_indices.data())
             .set_wait_semaphores(static_cast<uint32_t>(gq_signal_semaphores.size()), gq_signal_semaphores.data())
+            .set_p_next(_present_controller.chain_present_id())
             .to_vk();
         result = vkQueuePresentKHR(_device.present_queue().handle(), &present_info);
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
@@ -779,23 +770,29 @@ int App::_main_loop() {
             return 1;
         }
         
-        current_frame_in_flight = (current_frame_in_flight + 1) % _MAX_FRAMES_IN_FLIGHT;
+        current_frame_in_flight = (current_frame_in_flight + 1) % _present_controller.frames_in_flight();
     }
     return 0;
 }
 
 void App::_rebuild_swapchain() {
-    vkDeviceWaitIdle(_device.handle());
-    
+    // no device wait: the old swapchain and depth buffers are retired and
+    // destroyed once the frames still using them have finished; the old
+    // swapchain's pending presents are assumed done by then (see
+    // Swapchain::recreate)
     wk::PhysicalDeviceSurfaceSupport physical_device_support = wk::GetPhysicalDeviceSurfaceSupport(_physical_device.handle(), _surface.handle());
     VkSurfaceFormatKHR surface_format = wk::ChooseSurfaceFormat(physical_device_support.formats);
     VkExtent2D surface_extent = wk::ChooseSurfaceExtent(_WIDTH, _HEIGHT, physical_device_support.capabilities);
     VkFormat depth_format = wk::ChooseDepthFormat(_physical_device.handle(), _DEPTH_FORMATS);
+    _depth_format = depth_format;
 
-    wk::Swapchain new_swapchain = wk::Swapchain(_device.handle(),
+    VkExtent2D old_extent = _swapchain.extent();
+    uint32_t old_image_count = _swapchain.image_count();
+    _present_controller.reset(); // present ids start over with the new swapchain
+    _deletion_queue.retire(_swapchain.recreate(
         wk::SwapchainCreateInfo{}
             .set_surface(_surface.handle())
-            .set_present_mode(wk::ChooseSurfacePresentationMode(physical_device_support.present_modes))
+            .set_present_mode(_present_controller.choose_present_mode(physical_device_support.present_modes))
             .set_min_image_count(std::clamp(
                 physical_device_support.capabilities.minImageCount + 1,
                 physical_device_support.capabilities.minImageCount,
@@ -808,20 +805,23 @@ void App::_rebuild_swapchain() {
             .set_image_sharing_mode(_swapchain.image_sharing_mode())
             .set_queue_family_indices(_swapchain.queue_family_indices().size(),
                                       _swapchain.queue_family_indices().data())
-            .set_old_swapchain(_swapchain.handle())
             .to_vk()
-    );
-    _swapchain = std::move(new_swapchain);
+    ));
 
+    // depth buffers only depend on the extent and image count
+    if (_swapchain.extent().width == old_extent.width && _swapchain.extent().height == old_extent.height
+        && _swapchain.image_count() == old_image_count) {
+        return;
+    }
+    _deletion_queue.retire(std::move(_depth_image_views));
+    _deletion_queue.retire(std::move(_depth_images));
     _depth_images.clear();
     _depth_image_views.clear();
-    _framebuffers.clear();
     _depth_images.reserve(_swapchain.image_views().size());
     _depth_image_views.reserve(_swapchain.image_views().size());
-    _framebuffers.reserve(_swapchain.image_views().size());
 
     for (size_t i = 0; i < _swapchain.image_views().size(); ++i) {
-        // Depth image per framebuffer
+        // Depth image per swapchain image
         _depth_images.emplace_back(
             _allocator.handle(),
             wk::ImageCreateInfo{}
@@ -860,26 +860,11 @@ void App::_rebuild_swapchain() {
                 )
                 .to_vk()
         );
-
-        // Framebuffer (color + depth)
-        std::vector<VkImageView> attachments = {
-            _swapchain.image_views()[i],
-            _depth_image_views.back().handle()
-        };
-
-        _framebuffers.emplace_back(
-            _device.handle(),
-            wk::FramebufferCreateInfo{}
-                .set_render_pass(_render_pass.handle())
-                .set_attachments(static_cast<uint32_t>(attachments.size()), attachments.data())
-                .set_extent(_swapchain.extent())
-                .set_layers(1)
-                .to_vk()
-        );
     }
 }
 
 void App::_cleanup() {
     vkDeviceWaitIdle(_device.handle());
+    _deletion_queue.flush();
     glfwTerminate();
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define BASIC_1_APP_HPP
 
 #define WLK_ENABLE_VALIDATION_LAYERS
+// uncomment to print pipeline creation feedback
+// #define WLK_PRINT_PIPELINE_REPORT
 #include <wk/wulkan.hpp>
 #include <wk/ext/glfw/glfw_internal.hpp>
 #include <wk/ext/glfw/surface.hpp>
@@ -10,6 +12,7 @@
 #include <glm/glm.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 
 struct Vertex {
@@ -23,6 +26,15 @@ struct UniformBufferObject {
     glm::mat4 proj;
 };
 
+// Contents of descriptor set 0, pushed with one template per frame
+struct FrameDescriptors {
+    VkDescriptorBufferInfo ubo;
+};
+
+constexpr std::array FRAME_DESCRIPTOR_ENTRIES = {
+    WLK_DESCRIPTOR_UPDATE_ENTRY(FrameDescriptors, ubo, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER),
+};
+
 class App {
 public:
     App();
@@ -64,7 +76,7 @@ private:
     };
 
     // ---------- renderer constants ----------
-    const size_t _MAX_FRAMES_IN_FLIGHT = 2;
+    const size_t _MAX_FRAMES_IN_FLIGHT = 3; // upper bound, the present controller picks the actual count
     int _WIDTH = 900;
     int _HEIGHT = 600;
 
@@ -81,32 +93,39 @@ private:
     wk::ext::glfw::Surface _surface;
     wk::PhysicalDevice _physical_device;
     wk::Device _device;
+    wk::DeviceFunctions _device_functions;
 
     wk::CommandPool _command_pool;
     wk::Allocator _allocator;
 
-    wk::RenderPass _render_pass;
-
     wk::Swapchain _swapchain;
+    wk::PresentController _present_controller;
 
+    VkFormat _depth_format = VK_FORMAT_UNDEFINED;
     std::vector<wk::Image> _depth_images;
     std::vector<wk::ImageView> _depth_image_views;
-    std::vector<wk::Framebuffer> _framebuffers;
 
-    wk::PipelineLayout _pipeline_layout;
-    wk::Pipeline _pipeline;
+    wk::ShaderPack _shader_pack; // the module cache borrows its SPIR-V
+    wk::ShaderModuleCache _shader_modules;
+    wk::LayoutCache _layout_cache;
+    VkPipelineLayout _pipeline_layout = VK_NULL_HANDLE;
+    wk::GraphicsPipelineCache _pipelines;
+    VkPipeline _pipeline = VK_NULL_HANDLE;
+    bool _is_raster_state_dynamic = false;
 
     wk::Buffer _vertex_buffer;
     wk::Buffer _index_buffer;
     std::vector<wk::Buffer> _uniform_buffers;
 
-    wk::DescriptorPool _descriptor_pool;
-    std::vector<wk::DescriptorSet> _descriptor_sets;
+    wk::TypedDescriptorUpdateTemplate<FrameDescriptors> _frame_descriptor_template;
 
     std::vector<wk::CommandBuffer> _command_buffers;
     std::vector<wk::Semaphore> _image_available_semaphores{};
     std::vector<wk::Semaphore> _render_finished_semaphores{};
     std::vector<wk::Fence> _frame_in_flight_fences{};
+
+    // resources replaced while frames may still be in flight
+    wk::DeletionQueue _deletion_queue;
 };
 
 #endif // BASIC_1_APP_HPP
\ No newline at end of file
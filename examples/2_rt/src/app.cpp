@@ -4,6 +4,9 @@
 #include <wk/ext/rt/rt_internal.hpp>
 
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
 #include <cstring>
 #include <algorithm>
 
@@ -112,6 +115,16 @@ int App::_init_vulkan() {
     wk::DeviceQueueFamilyIndices queue_family_indices = _physical_device.queue_family_indices();
 
     wk::ext::rt::FeatureChain rt_feature_chain = wk::ext::rt::MakeFeatureChain();
+    // timeline semaphores drive the frame capture readback
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+    timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timeline_features.timelineSemaphore = VK_TRUE;
+    rt_feature_chain.rtf.pNext = &timeline_features;
+    // BLAS compaction resets its size queries on the host
+    VkPhysicalDeviceHostQueryResetFeatures host_query_reset_features{};
+    host_query_reset_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES;
+    host_query_reset_features.hostQueryReset = VK_TRUE;
+    timeline_features.pNext = &host_query_reset_features;
 
     const float QUEUE_PRIORITY = 1.0f;
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos = {
@@ -195,6 +208,8 @@ int App::_init_vulkan() {
 
     if (_build_storage_img()) return 1;
     
+    _deletion_queue = wk::DeletionQueue(static_cast<uint32_t>(_MAX_FRAMES_IN_FLIGHT));
+
     if (_build_blas(queue_family_indices.graphics_family.value())) return 1;
     if (_build_tlas(queue_family_indices.graphics_family.value())) return 1;
 
@@ -230,6 +245,11 @@ int App::_init_vulkan() {
                 .to_vk());
     }
 
+    // ---------- Capture ----------
+    // room for one rgba8 capture up to 4k per frame in flight
+    _readback = wk::Readback(_device.handle(), _allocator.handle(), static_cast<uint32_t>(_MAX_FRAMES_IN_FLIGHT),
+        VkDeviceSize(3840) * 2160 * 4);
+
     return 0;
 }
 
@@ -414,67 +434,17 @@ int App::_build_blas(uint32_t graphics_family_index) {
         )
         .to_vk();
 
-    VkAccelerationStructureBuildGeometryInfoKHR accel_build_info = wk::ext::rt::AccelerationStructureBuildGeometryInfo{}
-        .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
-        .set_mode(VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
-        .set_geometries(1, &accel_geometry)
+    VkAccelerationStructureBuildRangeInfoKHR range = wk::ext::rt::AccelerationStructureBuildRangeInfo{}
+        .set_primitive_count(static_cast<uint32_t>(_INDICES.size() / 3))
         .to_vk();
 
-    uint32_t primitive_count = static_cast<uint32_t>(_INDICES.size() / 3);
-    VkAccelerationStructureBuildSizesInfoKHR sizes = wk::ext::rt::AccelerationStructureBuildSizesInfo{}.to_vk();
-    _device_functions.vkGetAccelerationStructureBuildSizesKHR(_device.handle(),
-        VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
-        &accel_build_info,
-        &primitive_count,
-        &sizes
-    );
-
-    _blas_buffer = wk::Buffer(_allocator.handle(),
-        wk::BufferCreateInfo{}
-            .set_size(sizes.accelerationStructureSize)
-            .set_usage(VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
-                       VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
-            .to_vk(),
-        wk::AllocationCreateInfo{}
-            .set_usage(VMA_MEMORY_USAGE_GPU_ONLY)
-            .to_vk()
-    );
-
-    _blas = wk::ext::rt::AccelerationStructure(_device.handle(), _device_functions,
-        wk::ext::rt::AccelerationStructureCreateInfo{}
-            .set_buffer(_blas_buffer.handle())
-            .set_offset(0)
-            .set_size(sizes.accelerationStructureSize)
-            .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
-            .to_vk()
-    );
-
-    // ---------- Scratch buffer ----------
-    wk::Buffer scratch_buffer = wk::Buffer(_allocator.handle(),
-        wk::BufferCreateInfo{}
-            .set_size(std::max(sizes.buildScratchSize,
-                               sizes.updateScratchSize))
-            .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-                       VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
-            .to_vk(),
-        wk::AllocationCreateInfo{}
-            .set_usage(VMA_MEMORY_USAGE_GPU_ONLY)
-            .to_vk()
-    );
-
-    VkBufferDeviceAddressInfo scratch_address_info = wk::BufferDeviceAddressInfo{}
-        .set_buffer(scratch_buffer.handle())
-        .to_vk();
-    VkDeviceAddress scratch_address = vkGetBufferDeviceAddress(_device.handle(),
-        &scratch_address_info
-    );
+    // every mesh of a scene goes through the same builder and is built in
+    // a handful of batched commands
+    _blas_builder = wk::ext::rt::BlasBuilder(_device.handle(), _physical_device.handle(),
+        _allocator.handle(), _device_functions);
+    _blas_builder.add(wk::ext::rt::BlasInput{ { accel_geometry }, { range } });
 
     // ---------- Build command ----------
-    VkAccelerationStructureBuildRangeInfoKHR range = wk::ext::rt::AccelerationStructureBuildRangeInfo{}
-        .set_primitive_count(primitive_count)
-        .to_vk();
-    const VkAccelerationStructureBuildRangeInfoKHR* ranges[] = { &range };
-
     wk::CommandBuffer command_buffer(
         _device.handle(),
         wk::CommandBufferAllocateInfo{}
@@ -486,20 +456,7 @@ int App::_build_blas(uint32_t graphics_family_index) {
         .set_flags(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT)
         .to_vk();
     vkBeginCommandBuffer(command_buffer.handle(), &begin_info);
-
-    VkAccelerationStructureBuildGeometryInfoKHR build_info = wk::ext::rt::AccelerationStructureBuildGeometryInfo{}
-        .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
-        .set_mode(VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
-        .set_geometries(1, &accel_geometry)
-        .set_dst_acceleration_structure(_blas.handle())
-        .set_scratch_data(
-            wk::DeviceOrHostAddress{}
-                .set_device_address(scratch_address)
-                .to_vk()
-        )
-        .to_vk();
-    _device_functions.vkCmdBuildAccelerationStructuresKHR(command_buffer.handle(), 1, &build_info, ranges);
-
+    _blas_builder.record(command_buffer.handle());
     vkEndCommandBuffer(command_buffer.handle());
 
     VkSubmitInfo gq_submit_info = wk::SubmitInfo{}
@@ -511,6 +468,33 @@ int App::_build_blas(uint32_t graphics_family_index) {
         VK_NULL_HANDLE
     );
 
+    vkQueueWaitIdle(_device.graphics_queue().handle());
+    _blas_builder.release_scratch();
+
+    // ---------- Compaction ----------
+    // the sizes are in now that the build finished; the uncompacted
+    // originals go to the deletion queue and outlive the copies
+    wk::CommandBuffer compact_command_buffer(
+        _device.handle(),
+        wk::CommandBufferAllocateInfo{}
+            .set_command_pool(_command_pool.handle())
+            .to_vk()
+    );
+
+    vkBeginCommandBuffer(compact_command_buffer.handle(), &begin_info);
+    _blas_builder.compact(compact_command_buffer.handle(), _deletion_queue);
+    vkEndCommandBuffer(compact_command_buffer.handle());
+
+    VkSubmitInfo compact_submit_info = wk::SubmitInfo{}
+        .set_command_buffers(1, &compact_command_buffer.handle())
+        .to_vk();
+    vkQueueSubmit(_device.graphics_queue().handle(),
+        1,
+        &compact_submit_info,
+        VK_NULL_HANDLE
+    );
+
+    // the command buffer is freed on return
     vkQueueWaitIdle(_device.graphics_queue().handle());
 
     return 0;
@@ -521,7 +505,7 @@ int App::_build_blas(uint32_t graphics_family_index) {
 int App::_build_tlas(uint32_t graphics_family_index) {
     // BLAS device address
     VkAccelerationStructureDeviceAddressInfoKHR accel_device_address_info = wk::ext::rt::AccelerationStructureDeviceAddressInfo{}
-        .set_acceleration_structure(_blas.handle())
+        .set_acceleration_structure(_blas_builder.acceleration_structure(0).handle())
         .to_vk();
     VkDeviceAddress blas_address = _device_functions.vkGetAccelerationStructureDeviceAddressKHR(_device.handle(), &accel_device_address_info);
 
@@ -737,13 +721,13 @@ int App::_build_pipeline() {
             .to_vk()
     };
 
-    wk::DescriptorSetLayout descriptor_set_layout(_device.handle(),
+    _descriptor_set_layout = wk::DescriptorSetLayout(_device.handle(),
         wk::DescriptorSetLayoutCreateInfo{}
             .set_bindings(2, binds)
             .to_vk()
     );
 
-    VkDescriptorSetLayout layouts[] = { descriptor_set_layout.handle() };
+    VkDescriptorSetLayout layouts[] = { _descriptor_set_layout.handle() };
 
     _pipeline_layout = wk::PipelineLayout(_device.handle(), 
         wk::PipelineLayoutCreateInfo{}
@@ -752,39 +736,26 @@ int App::_build_pipeline() {
             .to_vk()
     );
 
-    std::vector<uint8_t> rgen_byte_code = wk::ReadSpirvShader("shaders/rt.rgen.spv");
-    std::vector<uint8_t> rmiss_byte_code = wk::ReadSpirvShader("shaders/rt.rmiss.spv");
-    std::vector<uint8_t> rchit_byte_code = wk::ReadSpirvShader("shaders/rt.rchit.spv");
+    _shader_pack = wk::ShaderPack("shaders/shaders.wkpack");
 
-    wk::ShaderModule rgen(_device.handle(), 
-        wk::ShaderModuleCreateInfo{}
-            .set_byte_code(rgen_byte_code.size(), rgen_byte_code.data())
-            .to_vk()
-    );
-    wk::ShaderModule rmiss(_device.handle(), 
-        wk::ShaderModuleCreateInfo{}
-            .set_byte_code(rmiss_byte_code.size(), rmiss_byte_code.data())
-            .to_vk()
-    );
-    wk::ShaderModule rchit(_device.handle(), 
-        wk::ShaderModuleCreateInfo{}
-            .set_byte_code(rchit_byte_code.size(), rchit_byte_code.data())
-            .to_vk()
-    );
+    _shader_modules = wk::ShaderModuleCache(_device.handle());
+    VkShaderModule rgen = _shader_modules.get(_shader_pack.at("rt.rgen.spv"));
+    VkShaderModule rmiss = _shader_modules.get(_shader_pack.at("rt.rmiss.spv"));
+    VkShaderModule rchit = _shader_modules.get(_shader_pack.at("rt.rchit.spv"));
 
     VkPipelineShaderStageCreateInfo stages[] = {
         wk::PipelineShaderStageCreateInfo{}
             .set_stage(VK_SHADER_STAGE_RAYGEN_BIT_KHR)
-            .set_module(rgen.handle())
+            .set_module(rgen)
             .set_p_name("main").to_vk(),
         wk::PipelineShaderStageCreateInfo{}
             .set_stage(VK_SHADER_STAGE_MISS_BIT_KHR)
-            .set_module(rmiss.handle())
+            .set_module(rmiss)
             .set_p_name("main")
             .to_vk(),
         wk::PipelineShaderStageCreateInfo{}
             .set_stage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR)
-            .set_module(rchit.handle())
+            .set_module(rchit)
             .set_p_name("main")
             .to_vk()
     };
@@ -822,66 +793,50 @@ int App::_build_pipeline() {
             .to_vk()
     );
 
+    const uint32_t set_count = static_cast<uint32_t>(_MAX_FRAMES_IN_FLIGHT);
     VkDescriptorPoolSize pool_sizes[] = {
         wk::DescriptorPoolSize{}
             .set_type(VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR)
-            .set_descriptor_count(1)
+            .set_descriptor_count(set_count)
             .to_vk(),
         wk::DescriptorPoolSize{}
             .set_type(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
-            .set_descriptor_count(1)
+            .set_descriptor_count(set_count)
             .to_vk()
     };
 
     _descriptor_pool = wk::DescriptorPool(_device.handle(),
         wk::DescriptorPoolCreateInfo{}
             .set_flags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
-            .set_max_sets(1)
+            .set_max_sets(set_count)
             .set_pool_sizes(2, pool_sizes)
             .to_vk()
     );
 
-    _descriptor_set = wk::DescriptorSet(_device.handle(),
-        wk::DescriptorSetAllocateInfo{}
-            .set_descriptor_pool(_descriptor_pool.handle())
-            .set_set_layouts(1, layouts)
-            .to_vk()
-    );
-
-    // AS write (pNext)
-    VkWriteDescriptorSetAccelerationStructureKHR accel_write = wk::ext::rt::WriteDescriptorSetAccelerationStructure{}
-        .set_acceleration_structures(1, (VkAccelerationStructureKHR*)&_tlas.handle())
-        .to_vk();
-
-    VkWriteDescriptorSet w0 = wk::WriteDescriptorSet{}
-        .set_dst_set(_descriptor_set.handle())
-        .set_dst_binding(0)
-        .set_descriptor_type(VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR)
-        .set_descriptor_count(1)
-        .set_p_next(&accel_write)
-        .to_vk();
-
-    // storage image
-    VkDescriptorImageInfo img = wk::DescriptorImageInfo{}
-        .set_image_layout(VK_IMAGE_LAYOUT_GENERAL)
-        .set_image_view(_rt_image_view.handle())
-        .set_sampler(VK_NULL_HANDLE)
-        .to_vk();
-
-    VkWriteDescriptorSet w1 = wk::WriteDescriptorSet{}
-        .set_dst_set(_descriptor_set.handle())
-        .set_dst_binding(1)
-        .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
-        .set_descriptor_count(1)
-        .set_p_image_info(&img)
-        .to_vk();
-
-    std::array<VkWriteDescriptorSet,2> writes{w0,w1};
-    vkUpdateDescriptorSets(_device.handle(), (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    _descriptor_sets.clear();
+    _descriptor_sets.reserve(set_count);
+    for (uint32_t i = 0; i < set_count; ++i) {
+        _descriptor_sets.emplace_back(_device.handle(),
+            wk::DescriptorSetAllocateInfo{}
+                .set_descriptor_pool(_descriptor_pool.handle())
+                .set_set_layouts(1, layouts)
+                .to_vk()
+        );
+        _write_descriptor_set(i);
+    }
+    _is_descriptor_set_stale.assign(set_count, false);
 
     return 0;
 }
 
+void App::_write_descriptor_set(size_t frame) {
+    wk::DescriptorWriter writer;
+    writer.write_acceleration_structure(_descriptor_sets[frame].handle(), 0, 0, _tlas.handle())
+          .write_image(_descriptor_sets[frame].handle(), 1, 0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+              _rt_image_view.handle(), VK_IMAGE_LAYOUT_GENERAL);
+    writer.flush(_device.handle());
+}
+
 // ------------------------- SBT -------------------------
 
 int App::_build_shader_binding_table() {
@@ -1013,6 +968,19 @@ int App::_main_loop() {
         }
 
         vkResetFences(_device.handle(), 1, &_frame_in_flight_fences[current_frame_in_flight].handle());
+        _deletion_queue.begin_frame();
+        if (_is_descriptor_set_stale[current_frame_in_flight]) {
+            // the frame that last bound this set has finished
+            _write_descriptor_set(current_frame_in_flight);
+            _is_descriptor_set_stale[current_frame_in_flight] = false;
+        }
+        uint64_t readback_value = _readback.begin_frame(static_cast<uint32_t>(current_frame_in_flight));
+        _write_captures();
+
+        // F12 captures the traced image without stalling the frame
+        bool capture_key_down = glfwGetKey(_window, GLFW_KEY_F12) == GLFW_PRESS;
+        bool capture = capture_key_down && !_capture_key_down;
+        _capture_key_down = capture_key_down;
         vkResetCommandBuffer(_command_buffers[current_frame_in_flight].handle(), 0);
         
         VkCommandBufferBeginInfo cb_begin_info = wk::CommandBufferBeginInfo{}.to_vk();
@@ -1058,7 +1026,7 @@ int App::_main_loop() {
             VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, _pipeline.handle());
         vkCmdBindDescriptorSets(_command_buffers[current_frame_in_flight].handle(),
             VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, _pipeline_layout.handle(), 0, 1,
-            &_descriptor_set.handle(), 0, nullptr);
+            &_descriptor_sets[current_frame_in_flight].handle(), 0, nullptr);
 
         _device_functions.vkCmdTraceRaysKHR(_command_buffers[current_frame_in_flight].handle(),
             &_rgen, &_miss, &_hit, &_call,
@@ -1078,6 +1046,20 @@ int App::_main_loop() {
             VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_TRANSFER_BIT,
             0, 0,nullptr, 0,nullptr, 1, &b2);
 
+        wk::CommandEncoder encoder(_command_buffers[current_frame_in_flight].handle());
+        VkExtent2D capture_extent = _swapchain.extent();
+        if (capture && VkDeviceSize(capture_extent.width) * capture_extent.height * 4 > _readback.bytes_per_frame()) {
+            std::cerr << "window too large to capture" << std::endl;
+        } else if (capture) {
+            VkImageSubresourceLayers capture_sub{};
+            capture_sub.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            capture_sub.layerCount = 1;
+            _captures.emplace_back(capture_extent, _readback.read_image(encoder, _rt_image.handle(),
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, capture_sub, VkOffset3D{ 0, 0, 0 },
+                wk::Extent(capture_extent).to_vk(), 4));
+        }
+        _readback.end_frame(encoder);
+
         // copy rt -> swapchain
         VkImageSubresourceLayers sub{}; sub.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; sub.layerCount = 1;
         VkImageCopy region{};
@@ -1113,8 +1095,13 @@ int App::_main_loop() {
         std::vector<VkCommandBuffer> gq_command_buffers = { _command_buffers[current_frame_in_flight].handle() };
         std::vector<VkSemaphore> gq_wait_semaphores = { _image_available_semaphores[current_frame_in_flight].handle() };
         std::vector<VkPipelineStageFlags> gq_wait_stage_flags = { VK_PIPELINE_STAGE_TRANSFER_BIT };
-        std::vector<VkSemaphore> gq_signal_semaphores = { _render_finished_semaphores[current_frame_in_flight].handle() };
+        std::vector<VkSemaphore> gq_signal_semaphores = { _render_finished_semaphores[current_frame_in_flight].handle(), _readback.semaphore() };
+        std::vector<uint64_t> gq_signal_values = { 0, readback_value };
+        VkTimelineSemaphoreSubmitInfo gq_timeline_info = wk::TimelineSemaphoreSubmitInfo{}
+            .set_signal_semaphore_values(static_cast<uint32_t>(gq_signal_values.size()), gq_signal_values.data())
+            .to_vk();
         VkSubmitInfo gq_submit_info = wk::SubmitInfo{}
+            .set_p_next(&gq_timeline_info)
             .set_command_buffers(static_cast<uint32_t>(gq_command_buffers.size()), gq_command_buffers.data())
             .set_wait_semaphores(static_cast<uint32_t>(gq_wait_semaphores.size()), gq_wait_semaphores.data())
             .set_wait_dst_stage_masks(static_cast<uint32_t>(gq_wait_stage_flags.size()), gq_wait_stage_flags.data())
@@ -1131,7 +1118,7 @@ int App::_main_loop() {
         VkPresentInfoKHR present_info = wk::PresentInfo{}
             .set_swapchains(static_cast<uint32_t>(pq_swapchains.size()), pq_swapchains.data())
             .set_image_indices(pq_image_indices.data())
-            .set_wait_semaphores(static_cast<uint32_t>(gq_signal_semaphores.size()), gq_signal_semaphores.data())
+            .set_wait_semaphores(1, &gq_signal_semaphores[0])
             .to_vk();
         result = vkQueuePresentKHR(_device.present_queue().handle(), &present_info);
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
@@ -1147,16 +1134,38 @@ int App::_main_loop() {
     return 0;
 }
 
+// ------------------------- capture -------------------------
+
+void App::_write_captures() {
+    while (!_captures.empty() && _captures.front().second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        VkExtent2D extent = _captures.front().first;
+        std::vector<uint8_t> rgba = _captures.front().second.get();
+        _captures.pop_front();
+
+        // rgba8 -> binary ppm
+        std::string path = "capture_" + std::to_string(_capture_count++) + ".ppm";
+        std::ofstream file(path, std::ios::binary);
+        file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+        for (size_t i = 0; i + 3 < rgba.size(); i += 4) {
+            file.write(reinterpret_cast<const char*>(&rgba[i]), 3);
+        }
+        std::cout << "wrote " << path << std::endl;
+    }
+}
+
 // ------------------------- swapchain rebuild -------------------------
 
 void App::_rebuild_swapchain() {
-    vkDeviceWaitIdle(_device.handle());
-
+    // no device wait: the old swapchain and storage image are retired and
+    // destroyed once the frames still using them have finished; the old
+    // swapchain's pending presents are assumed done by then (see
+    // Swapchain::recreate)
     wk::PhysicalDeviceSurfaceSupport physical_device_support = wk::GetPhysicalDeviceSurfaceSupport(_physical_device.handle(), _surface.handle());
     VkSurfaceFormatKHR surface_format = wk::ChooseSurfaceFormat(physical_device_support.formats);
     VkExtent2D e = wk::ChooseSurfaceExtent(_WIDTH, _HEIGHT, physical_device_support.capabilities);
 
-    wk::Swapchain new_swapchain = wk::Swapchain(_device.handle(),
+    VkExtent2D old_extent = _swapchain.extent();
+    _deletion_queue.retire(_swapchain.recreate(
         wk::SwapchainCreateInfo{}
             .set_surface(_surface.handle())
             .set_present_mode(wk::ChooseSurfacePresentationMode(physical_device_support.present_modes))
@@ -1172,14 +1181,19 @@ void App::_rebuild_swapchain() {
             .set_image_sharing_mode(_swapchain.image_sharing_mode())
             .set_queue_family_indices((uint32_t)_swapchain.queue_family_indices().size(),
                                       _swapchain.queue_family_indices().data())
-            .set_old_swapchain(_swapchain.handle())
             .to_vk()
-    );
-    _swapchain = std::move(new_swapchain);
+    ));
     _is_swapchain_image_initialized.assign(_swapchain.image_count(), false);
 
-    // recreate storage image
+    // the storage image only depends on the extent
+    if (_swapchain.extent().width == old_extent.width && _swapchain.extent().height == old_extent.height) {
+        return;
+    }
+    _deletion_queue.retire(std::move(_rt_image_view));
+    _deletion_queue.retire(std::move(_rt_image));
     _build_storage_img();
+    // each set is rewritten once its frame slot comes around
+    _is_descriptor_set_stale.assign(_descriptor_sets.size(), true);
 }
 
 // ------------------------- cleanup -------------------------
@@ -1187,5 +1201,6 @@ void App::_rebuild_swapchain() {
 void App::_cleanup() {
     if (!_device.handle()) return;
     vkDeviceWaitIdle(_device.handle());
+    _deletion_queue.flush();
     glfwTerminate();
 }
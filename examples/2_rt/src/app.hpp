@@ -7,6 +7,7 @@
 #include <wk/ext/glfw/surface.hpp>
 
 #include <wk/ext/rt/acceleration_structure.hpp>
+#include <wk/ext/rt/blas_builder.hpp>
 #include <wk/ext/rt/ray_tracing_pipeline.hpp>
 #include <wk/ext/rt/deferred_operation.hpp>
 
@@ -15,6 +16,7 @@
 
 #include <vector>
 #include <array>
+#include <deque>
 
 struct Vertex {
     glm::vec3 position;
@@ -47,6 +49,8 @@ private:
     // int _build_descriptors();
     int _build_shader_binding_table();
     int record_trace_copy_commands_(uint32_t frame, uint32_t swap_img_index);
+    void _write_captures();
+    void _write_descriptor_set(size_t frame);
 
 private:
     // ---------- geometry ----------
@@ -97,16 +101,22 @@ private:
 
     wk::Buffer _vertex_buffer, _index_buffer;
 
-    wk::Buffer _blas_buffer, _tlas_buffer;
-    wk::ext::rt::AccelerationStructure _blas, _tlas;
+    wk::ext::rt::BlasBuilder _blas_builder;
+    wk::Buffer _tlas_buffer;
+    wk::ext::rt::AccelerationStructure _tlas;
 
     wk::Buffer _instance_buffer;
 
+    wk::ShaderPack _shader_pack; // the module cache borrows its SPIR-V
+    wk::ShaderModuleCache _shader_modules;
     wk::PipelineLayout _pipeline_layout;
     wk::ext::rt::RayTracingPipeline _pipeline;
 
+    wk::DescriptorSetLayout _descriptor_set_layout;
     wk::DescriptorPool _descriptor_pool;
-    wk::DescriptorSet  _descriptor_set;
+    // one per frame in flight, so a resize can rewrite a set once its frame is done
+    std::vector<wk::DescriptorSet> _descriptor_sets;
+    std::vector<bool> _is_descriptor_set_stale;
 
     wk::Buffer _shader_binding_table_buffer;
     VkStridedDeviceAddressRegionKHR _rgen{0,0,0}, _miss{0,0,0}, _hit{0,0,0}, _call{0,0,0};
@@ -115,6 +125,15 @@ private:
     std::vector<wk::Semaphore> _image_available_semaphores;
     std::vector<wk::Semaphore> _render_finished_semaphores;
     std::vector<wk::Fence> _frame_in_flight_fences;
+
+    // ---------- capture ----------
+    wk::Readback _readback;
+    std::deque<std::pair<VkExtent2D, wk::ReadbackFuture>> _captures;
+    uint32_t _capture_count = 0;
+    bool _capture_key_down = false;
+
+    // resources replaced while frames may still be in flight
+    wk::DeletionQueue _deletion_queue;
 };
 
 #endif // BASIC_2_APP_HPP
\ No newline at end of file
@@ -0,0 +1,349 @@
+#ifndef wulkan_wk_BINDLESS_HEAP_HPP
+#define wulkan_wk_BINDLESS_HEAP_HPP
+
+#include "wulkan_internal.hpp"
+#include "descriptor_pool.hpp"
+#include "descriptor_set_layout.hpp"
+#include "descriptor_buffer.hpp"
+#include "buffer.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+
+namespace wk {
+
+// The binding each resource type lives at in the bindless set, e.g. in GLSL:
+//   layout(set = 0, binding = 0) uniform texture2D textures[];
+//   layout(set = 0, binding = 1) uniform sampler samplers[];
+//   layout(set = 0, binding = 2) buffer Buffers { uint data[]; } buffers[];
+//   layout(set = 0, binding = 3, rgba8) uniform image2D images[];
+enum class BindlessResourceType : uint32_t {
+    SampledImage = 0,
+    Sampler = 1,
+    StorageBuffer = 2,
+    StorageImage = 3,
+};
+constexpr uint32_t BINDLESS_RESOURCE_TYPE_COUNT = 4;
+
+// Free-list of array indices. Released indices may still be read by frames in
+// flight, so they only return to the free list when that frame retires.
+class BindlessIndexAllocator {
+public:
+    BindlessIndexAllocator() = default;
+    BindlessIndexAllocator(uint32_t capacity, uint32_t frame_count)
+        : _capacity(capacity), _pending(frame_count) {}
+
+    uint32_t allocate() {
+        if (!_free.empty()) {
+            uint32_t index = _free.back();
+            _free.pop_back();
+            return index;
+        }
+        if (_next == _capacity) {
+            throw std::runtime_error("bindless heap is full");
+        }
+        return _next++;
+    }
+
+    void release(uint32_t index, uint32_t frame_index) {
+        _pending.at(frame_index).push_back(index);
+    }
+
+    void retire_frame(uint32_t frame_index) {
+        std::vector<uint32_t>& pending = _pending.at(frame_index);
+        _free.insert(_free.end(), pending.begin(), pending.end());
+        pending.clear();
+    }
+
+    uint32_t capacity() const { return _capacity; }
+
+private:
+    uint32_t _capacity = 0;
+    uint32_t _next = 0;
+    std::vector<uint32_t> _free;
+    std::vector<std::vector<uint32_t>> _pending; // per frame in flight
+};
+
+// One UPDATE_AFTER_BIND descriptor set holding large partially bound arrays of
+// every resource type. Resources get a stable index that shaders use
+// directly, so a whole frame binds this set once. Needs the descriptor
+// indexing features (see PhysicalDeviceDescriptorIndexingFeatures).
+//
+// Constructed from a DescriptorBuffer, the same arrays live in that buffer's
+// persistent region instead; bind it with set_descriptor_buffer_offsets at
+// descriptor_buffer_offset(). The add/update/release API is unchanged.
+class BindlessHeap {
+public:
+    BindlessHeap() : _mutex(std::make_unique<std::mutex>()) {}
+    BindlessHeap(VkDevice device, uint32_t frame_count,
+        uint32_t max_sampled_images, uint32_t max_samplers,
+        uint32_t max_storage_buffers, uint32_t max_storage_images,
+        VkShaderStageFlags stage_flags = VK_SHADER_STAGE_ALL)
+        : _device(device),
+          _mutex(std::make_unique<std::mutex>())
+    {
+        const std::array<uint32_t, BINDLESS_RESOURCE_TYPE_COUNT> capacities = {
+            max_sampled_images, max_samplers, max_storage_buffers, max_storage_images
+        };
+        _init_layout(DescriptorBackend::DescriptorSets, capacities, frame_count, stage_flags);
+
+        std::vector<VkDescriptorPoolSize> pool_sizes;
+        for (uint32_t i = 0; i < BINDLESS_RESOURCE_TYPE_COUNT; ++i) {
+            if (capacities[i] > 0) {
+                pool_sizes.push_back(DescriptorPoolSize{}
+                    .set_type(DescriptorType(static_cast<BindlessResourceType>(i)))
+                    .set_descriptor_count(capacities[i])
+                    .to_vk());
+            }
+        }
+
+        _pool = DescriptorPool(_device,
+            DescriptorPoolCreateInfo{}
+                .set_flags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+                .set_max_sets(1)
+                .set_pool_sizes(static_cast<uint32_t>(pool_sizes.size()), pool_sizes.data())
+                .to_vk()
+        );
+
+        VkDescriptorSetAllocateInfo ai{};
+        ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        ai.descriptorPool = _pool.handle();
+        ai.descriptorSetCount = 1;
+        ai.pSetLayouts = &_layout.handle();
+        if (vkAllocateDescriptorSets(_device, &ai, &_set) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate bindless descriptor set");
+        }
+    }
+
+    BindlessHeap(VkDevice device, DescriptorBuffer& descriptor_buffer, uint32_t frame_count,
+        uint32_t max_sampled_images, uint32_t max_samplers,
+        uint32_t max_storage_buffers, uint32_t max_storage_images,
+        VkShaderStageFlags stage_flags = VK_SHADER_STAGE_ALL)
+        : _device(device),
+          _mutex(std::make_unique<std::mutex>()),
+          _descriptor_buffer(&descriptor_buffer)
+    {
+        _init_layout(DescriptorBackend::DescriptorBuffer,
+            { max_sampled_images, max_samplers, max_storage_buffers, max_storage_images },
+            frame_count, stage_flags);
+        _allocation = descriptor_buffer.allocate_persistent(_layout.handle());
+    }
+
+    BindlessHeap(const BindlessHeap&) = delete;
+    BindlessHeap& operator=(const BindlessHeap&) = delete;
+    BindlessHeap(BindlessHeap&&) noexcept = default;
+    BindlessHeap& operator=(BindlessHeap&&) noexcept = default;
+
+    uint32_t add_sampled_image(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        uint32_t index = _allocate(BindlessResourceType::SampledImage);
+        update_sampled_image(index, view, layout);
+        return index;
+    }
+
+    uint32_t add_sampler(VkSampler sampler) {
+        uint32_t index = _allocate(BindlessResourceType::Sampler);
+        update_sampler(index, sampler);
+        return index;
+    }
+
+    uint32_t add_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE) {
+        uint32_t index = _allocate(BindlessResourceType::StorageBuffer);
+        update_storage_buffer(index, buffer, offset, range);
+        return index;
+    }
+
+    // VK_WHOLE_SIZE is resolved against buffer.size(), which the descriptor
+    // buffer backend needs since its descriptors hold a plain address range.
+    uint32_t add_storage_buffer(const Buffer& buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE) {
+        return add_storage_buffer(buffer.handle(), offset, _resolve_range(buffer, offset, range));
+    }
+
+    uint32_t add_storage_image(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) {
+        uint32_t index = _allocate(BindlessResourceType::StorageImage);
+        update_storage_image(index, view, layout);
+        return index;
+    }
+
+    void update_sampled_image(uint32_t index, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        VkDescriptorImageInfo info{ VK_NULL_HANDLE, view, layout };
+        _write(BindlessResourceType::SampledImage, index, &info, nullptr);
+    }
+
+    void update_sampler(uint32_t index, VkSampler sampler) {
+        VkDescriptorImageInfo info{ sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+        _write(BindlessResourceType::Sampler, index, &info, nullptr);
+    }
+
+    void update_storage_buffer(uint32_t index, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE) {
+        VkDescriptorBufferInfo info{ buffer, offset, range };
+        _write(BindlessResourceType::StorageBuffer, index, nullptr, &info);
+    }
+
+    void update_storage_buffer(uint32_t index, const Buffer& buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE) {
+        update_storage_buffer(index, buffer.handle(), offset, _resolve_range(buffer, offset, range));
+    }
+
+    void update_storage_image(uint32_t index, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL) {
+        VkDescriptorImageInfo info{ VK_NULL_HANDLE, view, layout };
+        _write(BindlessResourceType::StorageImage, index, &info, nullptr);
+    }
+
+    // The index is handed out again once frame_index has retired.
+    void release(BindlessResourceType type, uint32_t index, uint32_t frame_index) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _indices[static_cast<uint32_t>(type)].release(index, frame_index);
+    }
+
+    // Call once the frame's fence has signalled.
+    void retire_frame(uint32_t frame_index) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        for (BindlessIndexAllocator& indices : _indices) {
+            indices.retire_frame(frame_index);
+        }
+    }
+
+    uint32_t capacity(BindlessResourceType type) const { return _indices[static_cast<uint32_t>(type)].capacity(); }
+
+    const VkDescriptorSetLayout& layout() const { return _layout.handle(); }
+    const VkDescriptorSet& set() const { return _set; }
+    DescriptorBackend backend() const { return _backend; }
+    // Only meaningful with the descriptor buffer backend.
+    VkDeviceSize descriptor_buffer_offset() const { return _allocation.offset; }
+
+    static VkDescriptorType DescriptorType(BindlessResourceType type) {
+        switch (type) {
+            case BindlessResourceType::SampledImage: return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            case BindlessResourceType::Sampler: return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case BindlessResourceType::StorageBuffer: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            case BindlessResourceType::StorageImage: return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        }
+        return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+    }
+
+private:
+    // The layout and index allocators both backends share; the set or the
+    // descriptor buffer region is the constructor's job.
+    void _init_layout(DescriptorBackend backend, const std::array<uint32_t, BINDLESS_RESOURCE_TYPE_COUNT>& capacities,
+        uint32_t frame_count, VkShaderStageFlags stage_flags)
+    {
+        _backend = backend;
+
+        std::array<VkDescriptorSetLayoutBinding, BINDLESS_RESOURCE_TYPE_COUNT> bindings{};
+        std::array<VkDescriptorBindingFlags, BINDLESS_RESOURCE_TYPE_COUNT> binding_flags{};
+        for (uint32_t i = 0; i < BINDLESS_RESOURCE_TYPE_COUNT; ++i) {
+            bindings[i] = DescriptorSetLayoutBinding{}
+                .set_binding(i)
+                .set_descriptor_type(DescriptorType(static_cast<BindlessResourceType>(i)))
+                .set_descriptor_count(capacities[i])
+                .set_stage_flags(stage_flags)
+                .to_vk();
+            binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+            // descriptor buffer memory is written directly, so update-after-bind does not apply
+            if (backend == DescriptorBackend::DescriptorSets) {
+                binding_flags[i] |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+                    | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+            }
+            _indices[i] = BindlessIndexAllocator(capacities[i], frame_count);
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flags_ci{};
+        flags_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        flags_ci.bindingCount = BINDLESS_RESOURCE_TYPE_COUNT;
+        flags_ci.pBindingFlags = binding_flags.data();
+
+        _layout = DescriptorSetLayout(_device,
+            DescriptorSetLayoutCreateInfo{}
+                .set_p_next(&flags_ci)
+                .set_flags(backend == DescriptorBackend::DescriptorSets
+                    ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT
+                    : DescriptorBackendLayoutFlags(backend))
+                .set_bindings(BINDLESS_RESOURCE_TYPE_COUNT, bindings.data())
+                .to_vk()
+        );
+    }
+
+    static VkDeviceSize _resolve_range(const Buffer& buffer, VkDeviceSize offset, VkDeviceSize range) {
+        if (range != VK_WHOLE_SIZE) {
+            return range;
+        }
+        if (offset > buffer.size()) {
+            throw std::runtime_error("storage buffer offset is past the end of the buffer");
+        }
+        return buffer.size() - offset;
+    }
+
+    uint32_t _allocate(BindlessResourceType type) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _indices[static_cast<uint32_t>(type)].allocate();
+    }
+
+    void _write(BindlessResourceType type, uint32_t index,
+        const VkDescriptorImageInfo* p_image_info, const VkDescriptorBufferInfo* p_buffer_info)
+    {
+        if (_backend == DescriptorBackend::DescriptorBuffer) {
+            _write_buffer(type, index, p_image_info, p_buffer_info);
+            return;
+        }
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = _set;
+        write.dstBinding = static_cast<uint32_t>(type);
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = DescriptorType(type);
+        write.pImageInfo = p_image_info;
+        write.pBufferInfo = p_buffer_info;
+
+        // host access to the set must be externally synchronized
+        std::lock_guard<std::mutex> lock(*_mutex);
+        vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+    }
+
+    void _write_buffer(BindlessResourceType type, uint32_t index,
+        const VkDescriptorImageInfo* p_image_info, const VkDescriptorBufferInfo* p_buffer_info)
+    {
+        uint32_t binding = static_cast<uint32_t>(type);
+        switch (type) {
+            case BindlessResourceType::SampledImage:
+                _descriptor_buffer->write_sampled_image(_allocation, binding, index, p_image_info->imageView, p_image_info->imageLayout);
+                break;
+            case BindlessResourceType::Sampler:
+                _descriptor_buffer->write_sampler(_allocation, binding, index, p_image_info->sampler);
+                break;
+            case BindlessResourceType::StorageImage:
+                _descriptor_buffer->write_storage_image(_allocation, binding, index, p_image_info->imageView, p_image_info->imageLayout);
+                break;
+            case BindlessResourceType::StorageBuffer: {
+                // descriptors hold raw addresses; a bare VkBuffer has no size to
+                // resolve VK_WHOLE_SIZE against, so pass the wk::Buffer instead
+                if (p_buffer_info->range == VK_WHOLE_SIZE) {
+                    throw std::runtime_error("descriptor buffer storage buffers need a wk::Buffer or an explicit range");
+                }
+                VkBufferDeviceAddressInfo address_info = BufferDeviceAddressInfo{}.set_buffer(p_buffer_info->buffer).to_vk();
+                VkDeviceAddress address = vkGetBufferDeviceAddress(_device, &address_info) + p_buffer_info->offset;
+                _descriptor_buffer->write_storage_buffer(_allocation, binding, index, address, p_buffer_info->range);
+                break;
+            }
+        }
+    }
+
+    VkDevice _device = VK_NULL_HANDLE;
+    DescriptorBackend _backend = DescriptorBackend::DescriptorSets;
+    std::unique_ptr<std::mutex> _mutex;
+    DescriptorSetLayout _layout;
+    DescriptorPool _pool;
+    VkDescriptorSet _set = VK_NULL_HANDLE; // freed with the pool
+    DescriptorBuffer* _descriptor_buffer = nullptr; // not owned
+    DescriptorBufferAllocation _allocation;
+    std::array<BindlessIndexAllocator, BINDLESS_RESOURCE_TYPE_COUNT> _indices;
+};
+
+}
+
+#endif
@@ -14,7 +14,7 @@ class Buffer {
 public:
     Buffer() = default;
     Buffer(VmaAllocator allocator, const VkBufferCreateInfo& ci, const VmaAllocationCreateInfo& aci)
-        : _allocator(allocator)
+        : _allocator(allocator), _size(ci.size)
     {
         if (vmaCreateBuffer(_allocator, &ci, &aci, &_handle, &_allocation, nullptr) != VK_SUCCESS) {
             throw std::runtime_error("failed to create buffer");
@@ -33,7 +33,8 @@ public:
     Buffer(Buffer&& other) noexcept
         : _handle(other._handle),
           _allocator(other._allocator),
-          _allocation(other._allocation)
+          _allocation(other._allocation),
+          _size(other._size)
     {
         other._handle = VK_NULL_HANDLE;
         other._allocation = nullptr;
@@ -47,6 +48,7 @@ public:
             _handle = other._handle;
             _allocator = other._allocator;
             _allocation = other._allocation;
+            _size = other._size;
 
             other._handle = VK_NULL_HANDLE;
             other._allocation = nullptr;
@@ -56,11 +58,13 @@ public:
 
     const VkBuffer& handle() const { return _handle; }
     const VmaAllocation& allocation() const { return _allocation; }
+    VkDeviceSize size() const { return _size; }
 
 private:
     VkBuffer _handle = VK_NULL_HANDLE;
     VmaAllocator _allocator = VK_NULL_HANDLE;
     VmaAllocation _allocation = nullptr;
+    VkDeviceSize _size = 0;
 };
 
 class BufferDeviceAddressInfo {
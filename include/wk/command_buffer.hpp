@@ -158,6 +158,87 @@ private:
     uint32_t _clear_value_count = 0;
 };
 
+class RenderingAttachmentInfo {
+public:
+    RenderingAttachmentInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    RenderingAttachmentInfo& set_image_view(VkImageView image_view) { _image_view = image_view; return *this; }
+    RenderingAttachmentInfo& set_image_layout(VkImageLayout image_layout) { _image_layout = image_layout; return *this; }
+    RenderingAttachmentInfo& set_resolve_mode(VkResolveModeFlagBits resolve_mode) { _resolve_mode = resolve_mode; return *this; }
+    RenderingAttachmentInfo& set_resolve_image_view(VkImageView resolve_image_view) { _resolve_image_view = resolve_image_view; return *this; }
+    RenderingAttachmentInfo& set_resolve_image_layout(VkImageLayout resolve_image_layout) { _resolve_image_layout = resolve_image_layout; return *this; }
+    RenderingAttachmentInfo& set_load_op(VkAttachmentLoadOp load_op) { _load_op = load_op; return *this; }
+    RenderingAttachmentInfo& set_store_op(VkAttachmentStoreOp store_op) { _store_op = store_op; return *this; }
+    RenderingAttachmentInfo& set_clear_value(VkClearValue clear_value) { _clear_value = clear_value; return *this; }
+
+    VkRenderingAttachmentInfo to_vk() const {
+        VkRenderingAttachmentInfo ai{};
+        ai.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        ai.pNext = _p_next;
+        ai.imageView = _image_view;
+        ai.imageLayout = _image_layout;
+        ai.resolveMode = _resolve_mode;
+        ai.resolveImageView = _resolve_image_view;
+        ai.resolveImageLayout = _resolve_image_layout;
+        ai.loadOp = _load_op;
+        ai.storeOp = _store_op;
+        ai.clearValue = _clear_value;
+        return ai;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkImageView _image_view = VK_NULL_HANDLE;
+    VkImageLayout _image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkResolveModeFlagBits _resolve_mode = VK_RESOLVE_MODE_NONE;
+    VkImageView _resolve_image_view = VK_NULL_HANDLE;
+    VkImageLayout _resolve_image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkAttachmentLoadOp _load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    VkAttachmentStoreOp _store_op = VK_ATTACHMENT_STORE_OP_STORE;
+    VkClearValue _clear_value{};
+};
+
+class RenderingInfo {
+public:
+    RenderingInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    RenderingInfo& set_flags(VkRenderingFlags flags) { _flags = flags; return *this; }
+    RenderingInfo& set_render_area(VkRect2D render_area) { _render_area = render_area; return *this; }
+    RenderingInfo& set_layer_count(uint32_t layer_count) { _layer_count = layer_count; return *this; }
+    RenderingInfo& set_view_mask(uint32_t view_mask) { _view_mask = view_mask; return *this; }
+    RenderingInfo& set_color_attachments(uint32_t count, const VkRenderingAttachmentInfo* p_attachments) {
+        _color_attachment_count = count;
+        _p_color_attachments = p_attachments;
+        return *this;
+    }
+    RenderingInfo& set_p_depth_attachment(const VkRenderingAttachmentInfo* p_attachment) { _p_depth_attachment = p_attachment; return *this; }
+    RenderingInfo& set_p_stencil_attachment(const VkRenderingAttachmentInfo* p_attachment) { _p_stencil_attachment = p_attachment; return *this; }
+
+    VkRenderingInfo to_vk() const {
+        VkRenderingInfo ri{};
+        ri.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        ri.pNext = _p_next;
+        ri.flags = _flags;
+        ri.renderArea = _render_area;
+        ri.layerCount = _layer_count;
+        ri.viewMask = _view_mask;
+        ri.colorAttachmentCount = _color_attachment_count;
+        ri.pColorAttachments = _p_color_attachments;
+        ri.pDepthAttachment = _p_depth_attachment;
+        ri.pStencilAttachment = _p_stencil_attachment;
+        return ri;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkRenderingFlags _flags = 0;
+    VkRect2D _render_area{};
+    uint32_t _layer_count = 1;
+    uint32_t _view_mask = 0;
+    uint32_t _color_attachment_count = 0;
+    const VkRenderingAttachmentInfo* _p_color_attachments = nullptr;
+    const VkRenderingAttachmentInfo* _p_depth_attachment = nullptr;
+    const VkRenderingAttachmentInfo* _p_stencil_attachment = nullptr;
+};
+
 class CommandBufferAllocateInfo {
 public:
     CommandBufferAllocateInfo& set_command_pool(VkCommandPool command_pool) { _command_pool = command_pool; return *this; }
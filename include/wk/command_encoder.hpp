@@ -0,0 +1,354 @@
+#ifndef wulkan_wk_COMMAND_ENCODER_HPP
+#define wulkan_wk_COMMAND_ENCODER_HPP
+
+#include "wulkan_internal.hpp"
+#include "shader_object.hpp"
+#include "descriptor_update_template.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace wk {
+
+// Non-owning recording helper over a command buffer in the recording state.
+// Extension commands go through the optional device function table.
+class CommandEncoder {
+public:
+    CommandEncoder() = default;
+    explicit CommandEncoder(VkCommandBuffer command_buffer, const DeviceFunctions* functions = nullptr)
+        : _command_buffer(command_buffer), _functions(functions) {}
+
+    // ---------- dynamic rendering ----------
+    CommandEncoder& begin_rendering(const VkRenderingInfo& info) {
+        vkCmdBeginRendering(_command_buffer, &info);
+        return *this;
+    }
+    CommandEncoder& end_rendering() {
+        vkCmdEndRendering(_command_buffer);
+        return *this;
+    }
+
+    // ---------- synchronization ----------
+    CommandEncoder& pipeline_barrier(const VkDependencyInfo& info) {
+        vkCmdPipelineBarrier2(_command_buffer, &info);
+        return *this;
+    }
+
+    // ---------- binding ----------
+    CommandEncoder& bind_pipeline(VkPipelineBindPoint bind_point, VkPipeline pipeline) {
+        vkCmdBindPipeline(_command_buffer, bind_point, pipeline);
+        return *this;
+    }
+    CommandEncoder& bind_shaders(uint32_t count, const VkShaderStageFlagBits* p_stages, const VkShaderEXT* p_shaders) {
+        _require(&DeviceFunctions::vkCmdBindShadersEXT, "vkCmdBindShadersEXT")(_command_buffer, count, p_stages, p_shaders);
+        return *this;
+    }
+    CommandEncoder& bind_program(const GraphicsProgram& program) {
+        if (program.backend() == GraphicsBackend::ShaderObject) {
+            return bind_shaders(program.stage_count(), program.stages(), program.shaders());
+        }
+        return bind_pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, program.pipeline());
+    }
+    CommandEncoder& bind_descriptor_sets(VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t first_set,
+        uint32_t count, const VkDescriptorSet* p_sets, uint32_t dynamic_offset_count = 0, const uint32_t* p_dynamic_offsets = nullptr) {
+        vkCmdBindDescriptorSets(_command_buffer, bind_point, layout, first_set, count, p_sets, dynamic_offset_count, p_dynamic_offsets);
+        return *this;
+    }
+    CommandEncoder& bind_descriptor_buffers(uint32_t count, const VkDescriptorBufferBindingInfoEXT* p_binding_infos) {
+        _require(&DeviceFunctions::vkCmdBindDescriptorBuffersEXT, "vkCmdBindDescriptorBuffersEXT")(_command_buffer, count, p_binding_infos);
+        return *this;
+    }
+    CommandEncoder& set_descriptor_buffer_offsets(VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t first_set,
+        uint32_t count, const uint32_t* p_buffer_indices, const VkDeviceSize* p_offsets) {
+        _require(&DeviceFunctions::vkCmdSetDescriptorBufferOffsetsEXT, "vkCmdSetDescriptorBufferOffsetsEXT")(_command_buffer,
+            bind_point, layout, first_set, count, p_buffer_indices, p_offsets);
+        return *this;
+    }
+    // Push descriptors need a set layout created with the PUSH_DESCRIPTOR flag (VK_KHR_push_descriptor).
+    CommandEncoder& push_descriptor_set(VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set,
+        uint32_t count, const VkWriteDescriptorSet* p_writes) {
+        _require(&DeviceFunctions::vkCmdPushDescriptorSetKHR, "vkCmdPushDescriptorSetKHR")(_command_buffer,
+            bind_point, layout, set, count, p_writes);
+        return *this;
+    }
+    CommandEncoder& push_descriptor_set_with_template(VkDescriptorUpdateTemplate update_template, VkPipelineLayout layout,
+        uint32_t set, const void* p_data) {
+        _require(&DeviceFunctions::vkCmdPushDescriptorSetWithTemplateKHR, "vkCmdPushDescriptorSetWithTemplateKHR")(_command_buffer,
+            update_template, layout, set, p_data);
+        return *this;
+    }
+    template<typename T>
+    CommandEncoder& push_descriptors(const TypedDescriptorUpdateTemplate<T>& update_template, const T& data) {
+        if (!update_template.is_push()) {
+            throw std::runtime_error("descriptor update template was not created for push descriptors");
+        }
+        return push_descriptor_set_with_template(update_template.handle(), update_template.pipeline_layout(),
+            update_template.set(), &data);
+    }
+    CommandEncoder& bind_vertex_buffers(uint32_t first_binding, uint32_t count, const VkBuffer* p_buffers, const VkDeviceSize* p_offsets) {
+        vkCmdBindVertexBuffers(_command_buffer, first_binding, count, p_buffers, p_offsets);
+        return *this;
+    }
+    CommandEncoder& bind_index_buffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type) {
+        vkCmdBindIndexBuffer(_command_buffer, buffer, offset, index_type);
+        return *this;
+    }
+
+    // ---------- dynamic state ----------
+    CommandEncoder& set_viewport(const VkViewport& viewport) {
+        vkCmdSetViewport(_command_buffer, 0, 1, &viewport);
+        return *this;
+    }
+    CommandEncoder& set_scissor(const VkRect2D& scissor) {
+        vkCmdSetScissor(_command_buffer, 0, 1, &scissor);
+        return *this;
+    }
+
+    // ---------- extended dynamic state ----------
+    CommandEncoder& set_cull_mode(VkCullModeFlags cull_mode) {
+        _resolve(&DeviceFunctions::vkCmdSetCullModeEXT, vkCmdSetCullMode)(_command_buffer, cull_mode);
+        return *this;
+    }
+    CommandEncoder& set_front_face(VkFrontFace front_face) {
+        _resolve(&DeviceFunctions::vkCmdSetFrontFaceEXT, vkCmdSetFrontFace)(_command_buffer, front_face);
+        return *this;
+    }
+    CommandEncoder& set_primitive_topology(VkPrimitiveTopology topology) {
+        _resolve(&DeviceFunctions::vkCmdSetPrimitiveTopologyEXT, vkCmdSetPrimitiveTopology)(_command_buffer, topology);
+        return *this;
+    }
+    CommandEncoder& set_viewports_with_count(uint32_t count, const VkViewport* p_viewports) {
+        _resolve(&DeviceFunctions::vkCmdSetViewportWithCountEXT, vkCmdSetViewportWithCount)(_command_buffer, count, p_viewports);
+        return *this;
+    }
+    CommandEncoder& set_scissors_with_count(uint32_t count, const VkRect2D* p_scissors) {
+        _resolve(&DeviceFunctions::vkCmdSetScissorWithCountEXT, vkCmdSetScissorWithCount)(_command_buffer, count, p_scissors);
+        return *this;
+    }
+    CommandEncoder& set_depth_test_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetDepthTestEnableEXT, vkCmdSetDepthTestEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_depth_write_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetDepthWriteEnableEXT, vkCmdSetDepthWriteEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_depth_compare_op(VkCompareOp compare_op) {
+        _resolve(&DeviceFunctions::vkCmdSetDepthCompareOpEXT, vkCmdSetDepthCompareOp)(_command_buffer, compare_op);
+        return *this;
+    }
+    CommandEncoder& set_depth_bounds_test_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetDepthBoundsTestEnableEXT, vkCmdSetDepthBoundsTestEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_stencil_test_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetStencilTestEnableEXT, vkCmdSetStencilTestEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_stencil_op(VkStencilFaceFlags face_mask, VkStencilOp fail_op, VkStencilOp pass_op,
+        VkStencilOp depth_fail_op, VkCompareOp compare_op) {
+        _resolve(&DeviceFunctions::vkCmdSetStencilOpEXT, vkCmdSetStencilOp)(_command_buffer, face_mask, fail_op, pass_op, depth_fail_op, compare_op);
+        return *this;
+    }
+
+    // ---------- extended dynamic state 2 ----------
+    CommandEncoder& set_rasterizer_discard_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetRasterizerDiscardEnableEXT, vkCmdSetRasterizerDiscardEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_depth_bias_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetDepthBiasEnableEXT, vkCmdSetDepthBiasEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_primitive_restart_enable(VkBool32 enable) {
+        _resolve(&DeviceFunctions::vkCmdSetPrimitiveRestartEnableEXT, vkCmdSetPrimitiveRestartEnable)(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_patch_control_points(uint32_t count) {
+        _require(&DeviceFunctions::vkCmdSetPatchControlPointsEXT, "vkCmdSetPatchControlPointsEXT")(_command_buffer, count);
+        return *this;
+    }
+    CommandEncoder& set_logic_op(VkLogicOp logic_op) {
+        _require(&DeviceFunctions::vkCmdSetLogicOpEXT, "vkCmdSetLogicOpEXT")(_command_buffer, logic_op);
+        return *this;
+    }
+
+    // ---------- extended dynamic state 3 ----------
+    CommandEncoder& set_tessellation_domain_origin(VkTessellationDomainOrigin origin) {
+        _require(&DeviceFunctions::vkCmdSetTessellationDomainOriginEXT, "vkCmdSetTessellationDomainOriginEXT")(_command_buffer, origin);
+        return *this;
+    }
+    CommandEncoder& set_depth_clamp_enable(VkBool32 enable) {
+        _require(&DeviceFunctions::vkCmdSetDepthClampEnableEXT, "vkCmdSetDepthClampEnableEXT")(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_polygon_mode(VkPolygonMode mode) {
+        _require(&DeviceFunctions::vkCmdSetPolygonModeEXT, "vkCmdSetPolygonModeEXT")(_command_buffer, mode);
+        return *this;
+    }
+    CommandEncoder& set_rasterization_samples(VkSampleCountFlagBits samples) {
+        _require(&DeviceFunctions::vkCmdSetRasterizationSamplesEXT, "vkCmdSetRasterizationSamplesEXT")(_command_buffer, samples);
+        return *this;
+    }
+    CommandEncoder& set_sample_mask(VkSampleCountFlagBits samples, const VkSampleMask* p_mask) {
+        _require(&DeviceFunctions::vkCmdSetSampleMaskEXT, "vkCmdSetSampleMaskEXT")(_command_buffer, samples, p_mask);
+        return *this;
+    }
+    CommandEncoder& set_alpha_to_coverage_enable(VkBool32 enable) {
+        _require(&DeviceFunctions::vkCmdSetAlphaToCoverageEnableEXT, "vkCmdSetAlphaToCoverageEnableEXT")(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_alpha_to_one_enable(VkBool32 enable) {
+        _require(&DeviceFunctions::vkCmdSetAlphaToOneEnableEXT, "vkCmdSetAlphaToOneEnableEXT")(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_logic_op_enable(VkBool32 enable) {
+        _require(&DeviceFunctions::vkCmdSetLogicOpEnableEXT, "vkCmdSetLogicOpEnableEXT")(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_color_blend_enable(uint32_t first_attachment, uint32_t count, const VkBool32* p_enables) {
+        _require(&DeviceFunctions::vkCmdSetColorBlendEnableEXT, "vkCmdSetColorBlendEnableEXT")(_command_buffer, first_attachment, count, p_enables);
+        return *this;
+    }
+    CommandEncoder& set_color_blend_equation(uint32_t first_attachment, uint32_t count, const VkColorBlendEquationEXT* p_equations) {
+        _require(&DeviceFunctions::vkCmdSetColorBlendEquationEXT, "vkCmdSetColorBlendEquationEXT")(_command_buffer, first_attachment, count, p_equations);
+        return *this;
+    }
+    CommandEncoder& set_color_write_mask(uint32_t first_attachment, uint32_t count, const VkColorComponentFlags* p_masks) {
+        _require(&DeviceFunctions::vkCmdSetColorWriteMaskEXT, "vkCmdSetColorWriteMaskEXT")(_command_buffer, first_attachment, count, p_masks);
+        return *this;
+    }
+    CommandEncoder& set_depth_clip_enable(VkBool32 enable) {
+        _require(&DeviceFunctions::vkCmdSetDepthClipEnableEXT, "vkCmdSetDepthClipEnableEXT")(_command_buffer, enable);
+        return *this;
+    }
+    CommandEncoder& set_line_rasterization_mode(VkLineRasterizationModeEXT mode) {
+        _require(&DeviceFunctions::vkCmdSetLineRasterizationModeEXT, "vkCmdSetLineRasterizationModeEXT")(_command_buffer, mode);
+        return *this;
+    }
+
+    // ---------- shader object state ----------
+    CommandEncoder& set_vertex_input(uint32_t binding_count, const VkVertexInputBindingDescription2EXT* p_bindings,
+        uint32_t attribute_count, const VkVertexInputAttributeDescription2EXT* p_attributes) {
+        _require(&DeviceFunctions::vkCmdSetVertexInputEXT, "vkCmdSetVertexInputEXT")(_command_buffer,
+            binding_count, p_bindings, attribute_count, p_attributes);
+        return *this;
+    }
+
+    // Shader objects carry no baked state, so everything a draw reads must be
+    // recorded first. Sets opaque, depth-less, single-sampled defaults that
+    // callers then override.
+    CommandEncoder& set_shader_object_defaults(VkExtent2D extent, uint32_t color_attachment_count) {
+        VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+        VkRect2D scissor{ { 0, 0 }, extent };
+        set_viewports_with_count(1, &viewport);
+        set_scissors_with_count(1, &scissor);
+        set_rasterizer_discard_enable(VK_FALSE);
+        set_primitive_topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+        set_primitive_restart_enable(VK_FALSE);
+        set_cull_mode(VK_CULL_MODE_NONE);
+        set_front_face(VK_FRONT_FACE_COUNTER_CLOCKWISE);
+        set_depth_test_enable(VK_FALSE);
+        set_depth_write_enable(VK_FALSE);
+        set_depth_compare_op(VK_COMPARE_OP_LESS_OR_EQUAL);
+        set_depth_bounds_test_enable(VK_FALSE);
+        set_depth_bias_enable(VK_FALSE);
+        set_stencil_test_enable(VK_FALSE);
+        set_polygon_mode(VK_POLYGON_MODE_FILL);
+        set_rasterization_samples(VK_SAMPLE_COUNT_1_BIT);
+        VkSampleMask sample_mask = ~0u;
+        set_sample_mask(VK_SAMPLE_COUNT_1_BIT, &sample_mask);
+        set_alpha_to_coverage_enable(VK_FALSE);
+        set_depth_clamp_enable(VK_FALSE);
+        set_logic_op_enable(VK_FALSE);
+        set_vertex_input(0, nullptr, 0, nullptr);
+
+        if (color_attachment_count > 0) {
+            std::vector<VkBool32> blend_enables(color_attachment_count, VK_FALSE);
+            std::vector<VkColorBlendEquationEXT> equations(color_attachment_count, VkColorBlendEquationEXT{
+                VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+                VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD });
+            std::vector<VkColorComponentFlags> write_masks(color_attachment_count,
+                VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT);
+            set_color_blend_enable(0, color_attachment_count, blend_enables.data());
+            set_color_blend_equation(0, color_attachment_count, equations.data());
+            set_color_write_mask(0, color_attachment_count, write_masks.data());
+        }
+        return *this;
+    }
+
+    // ---------- draws ----------
+    CommandEncoder& draw(uint32_t vertex_count, uint32_t instance_count = 1, uint32_t first_vertex = 0, uint32_t first_instance = 0) {
+        vkCmdDraw(_command_buffer, vertex_count, instance_count, first_vertex, first_instance);
+        return *this;
+    }
+    CommandEncoder& draw_indexed(uint32_t index_count, uint32_t instance_count = 1, uint32_t first_index = 0,
+        int32_t vertex_offset = 0, uint32_t first_instance = 0) {
+        vkCmdDrawIndexed(_command_buffer, index_count, instance_count, first_index, vertex_offset, first_instance);
+        return *this;
+    }
+
+    // ---------- compute ----------
+    CommandEncoder& push_constants(VkPipelineLayout layout, VkShaderStageFlags stage_flags, uint32_t offset, uint32_t size, const void* p_values) {
+        vkCmdPushConstants(_command_buffer, layout, stage_flags, offset, size, p_values);
+        return *this;
+    }
+    CommandEncoder& dispatch(uint32_t group_count_x, uint32_t group_count_y = 1, uint32_t group_count_z = 1) {
+        vkCmdDispatch(_command_buffer, group_count_x, group_count_y, group_count_z);
+        return *this;
+    }
+
+    // ---------- transfer ----------
+    CommandEncoder& fill_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t data) {
+        vkCmdFillBuffer(_command_buffer, buffer, offset, size, data);
+        return *this;
+    }
+    CommandEncoder& blit_image(const VkBlitImageInfo2& info) {
+        vkCmdBlitImage2(_command_buffer, &info);
+        return *this;
+    }
+    CommandEncoder& copy_buffer_to_image(const VkCopyBufferToImageInfo2& info) {
+        vkCmdCopyBufferToImage2(_command_buffer, &info);
+        return *this;
+    }
+    CommandEncoder& copy_image_to_buffer(const VkCopyImageToBufferInfo2& info) {
+        vkCmdCopyImageToBuffer2(_command_buffer, &info);
+        return *this;
+    }
+    CommandEncoder& copy_buffer(const VkCopyBufferInfo2& info) {
+        vkCmdCopyBuffer2(_command_buffer, &info);
+        return *this;
+    }
+
+    const VkCommandBuffer& handle() const { return _command_buffer; }
+
+private:
+    VkCommandBuffer _command_buffer = VK_NULL_HANDLE;
+    const DeviceFunctions* _functions = nullptr;
+
+    // Core from 1.3 on; below that the extension entry point, which is only
+    // set when the extension is enabled on the device.
+    template <typename PFN>
+    PFN _resolve(PFN DeviceFunctions::* function, std::type_identity_t<PFN> core) const {
+        if (_functions && _functions->api_version < VK_API_VERSION_1_3 && _functions->*function) {
+            return _functions->*function;
+        }
+        return core;
+    }
+
+    template <typename PFN>
+    PFN _require(PFN DeviceFunctions::* function, const char* name) const {
+        if (!_functions || !(_functions->*function)) {
+            throw std::runtime_error(std::string("device function ") + name + " not set");
+        }
+        return _functions->*function;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef wulkan_wk_DELETION_QUEUE_HPP
+#define wulkan_wk_DELETION_QUEUE_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <type_traits>
+
+namespace wk {
+
+// Keeps objects the GPU may still be using alive until every frame that
+// could have used them has finished. Anything retired during frame N is
+// destroyed at the start of frame N + frames_in_flight, when the fence wait
+// for that frame slot guarantees frames up to N are done. Lets resources be
+// replaced (e.g. on swapchain resize) without vkDeviceWaitIdle. Fences only
+// cover submitted work: a retired swapchain may still have presents pending,
+// which nothing here waits for (see Swapchain::recreate).
+class DeletionQueue {
+public:
+    DeletionQueue() = default;
+    explicit DeletionQueue(uint32_t frames_in_flight)
+        : _frames_in_flight(frames_in_flight) {}
+
+    ~DeletionQueue() { flush(); }
+
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+    DeletionQueue(DeletionQueue&&) noexcept = default;
+    DeletionQueue& operator=(DeletionQueue&& other) noexcept {
+        if (this != &other) {
+            flush();
+            _frames_in_flight = other._frames_in_flight;
+            _frame = other._frame;
+            _entries = std::move(other._entries);
+        }
+        return *this;
+    }
+
+    // Call once per submitted frame, after waiting on the fence of its slot.
+    void begin_frame() {
+        ++_frame;
+        while (!_entries.empty() && _entries.front().frame + _frames_in_flight <= _frame) {
+            _entries.pop_front();
+        }
+    }
+
+    // Takes ownership of an RAII object (or container of them).
+    template <typename T>
+    void retire(T&& object) {
+        static_assert(!std::is_lvalue_reference_v<T>, "retire takes ownership, move the object in");
+        _entries.push_back(Entry{ _frame, std::make_shared<std::decay_t<T>>(std::move(object)) });
+    }
+
+    // Runs destroy once the current frame can no longer be in flight.
+    void defer(std::function<void()> destroy) {
+        retire(Deferred{ std::move(destroy) });
+    }
+
+    // Allowed to change at runtime. Only lower it once no more than that
+    // many frames can actually be in flight.
+    void set_frames_in_flight(uint32_t frames_in_flight) { _frames_in_flight = frames_in_flight; }
+    uint32_t frames_in_flight() const { return _frames_in_flight; }
+
+    // Destroys everything now; the device has to be idle.
+    void flush() {
+        while (!_entries.empty()) {
+            _entries.pop_front();
+        }
+    }
+
+    size_t size() const { return _entries.size(); }
+
+private:
+    struct Deferred {
+        std::function<void()> destroy;
+
+        Deferred(std::function<void()> destroy) : destroy(std::move(destroy)) {}
+        ~Deferred() { if (destroy) destroy(); }
+        Deferred(const Deferred&) = delete;
+        Deferred& operator=(const Deferred&) = delete;
+        Deferred(Deferred&& other) noexcept : destroy(std::move(other.destroy)) { other.destroy = nullptr; }
+        Deferred& operator=(Deferred&&) = delete;
+    };
+
+    struct Entry {
+        uint64_t frame = 0;
+        std::shared_ptr<void> object;
+    };
+
+    uint32_t _frames_in_flight = 2;
+    uint64_t _frame = 0;
+    std::deque<Entry> _entries; // in retirement order, so destroyed in it too
+};
+
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef wulkan_wk_DESCRIPTOR_ALLOCATOR_HPP
+#define wulkan_wk_DESCRIPTOR_ALLOCATOR_HPP
+
+#include "wulkan_internal.hpp"
+#include "descriptor_pool.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <span>
+#include <algorithm>
+
+namespace wk {
+
+// Transient descriptor sets, allocated linearly from pools owned by one
+// (thread slot, frame) pair. Sets are never freed individually: once the
+// frame's fence has signalled, reset_frame() recycles every pool of that
+// frame at once. A full pool is chained to a new, larger one instead of
+// failing, and a set too big for a fresh pool grows the pools that follow:
+// given the layout's own pool sizes, only the types it is short of.
+// Each thread slot must only be used by one thread at a time.
+class DescriptorAllocator {
+public:
+    static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+    static constexpr uint32_t MAX_DESCRIPTORS_PER_TYPE = 1u << 20;
+
+    DescriptorAllocator() = default;
+
+    // p_sizes_per_set gives the average number of descriptors of each type a
+    // set needs; pools are sized as that times their set count.
+    DescriptorAllocator(VkDevice device, uint32_t frame_count, uint32_t thread_count,
+        uint32_t initial_sets_per_pool, uint32_t size_count, const VkDescriptorPoolSize* p_sizes_per_set,
+        VkDescriptorPoolCreateFlags flags = 0)
+        : _device(device),
+          _frame_count(frame_count),
+          _flags(flags),
+          _sizes_per_set(p_sizes_per_set, p_sizes_per_set + size_count),
+          _slots(size_t(frame_count) * thread_count)
+    {
+        for (Slot& slot : _slots) {
+            slot.next_pool_sets = std::max(1u, initial_sets_per_pool);
+        }
+    }
+
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+    DescriptorAllocator(DescriptorAllocator&&) noexcept = default;
+    DescriptorAllocator& operator=(DescriptorAllocator&&) noexcept = default;
+
+    VkDescriptorSet allocate(uint32_t frame_index, VkDescriptorSetLayout layout,
+        uint32_t thread_index = 0, const void* p_next = nullptr)
+    {
+        return _allocate(_slot(frame_index, thread_index), layout, {}, p_next);
+    }
+
+    // layout_sizes are the descriptors one set of the layout needs per type
+    // (see ShaderReflection::set_pool_sizes), so a set too big for a fresh
+    // pool grows exactly the types it is short of.
+    VkDescriptorSet allocate(uint32_t frame_index, VkDescriptorSetLayout layout,
+        std::span<const VkDescriptorPoolSize> layout_sizes, uint32_t thread_index = 0, const void* p_next = nullptr)
+    {
+        return _allocate(_slot(frame_index, thread_index), layout, layout_sizes, p_next);
+    }
+
+    // Every set allocated for frame_index (on any thread slot) becomes invalid.
+    void reset_frame(uint32_t frame_index) {
+        for (uint32_t t = 0; t < thread_count(); ++t) {
+            Slot& slot = _slot(frame_index, t);
+            for (DescriptorPool& pool : slot.pools) {
+                vkResetDescriptorPool(_device, pool.handle(), 0);
+            }
+            slot.current = 0;
+        }
+    }
+
+    uint32_t frame_count() const { return _frame_count; }
+    uint32_t thread_count() const { return _frame_count ? static_cast<uint32_t>(_slots.size() / _frame_count) : 0; }
+
+private:
+    struct Slot {
+        std::vector<DescriptorPool> pools;
+        size_t current = 0; // pools before this one are full
+        uint32_t next_pool_sets = 0;
+        std::vector<VkDescriptorPoolSize> min_sizes; // per pool, raised by _grow()
+    };
+
+    VkDescriptorSet _allocate(Slot& slot, VkDescriptorSetLayout layout,
+        std::span<const VkDescriptorPoolSize> layout_sizes, const void* p_next)
+    {
+        VkDescriptorSetAllocateInfo ai{};
+        ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        ai.pNext = p_next;
+        ai.descriptorSetCount = 1;
+        ai.pSetLayouts = &layout;
+
+        while (true) {
+            uint32_t created_sets = 0;
+            if (slot.current == slot.pools.size()) {
+                created_sets = slot.next_pool_sets;
+                slot.pools.push_back(_create_pool(slot, created_sets));
+                slot.next_pool_sets = std::min(slot.next_pool_sets * 2, MAX_SETS_PER_POOL);
+            }
+
+            ai.descriptorPool = slot.pools[slot.current].handle();
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            VkResult result = vkAllocateDescriptorSets(_device, &ai, &set);
+            if (result == VK_SUCCESS) {
+                return set;
+            }
+            if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+                throw std::runtime_error("failed to allocate descriptor set");
+            }
+            // an empty pool that can't fit one set never will, so the next
+            // one is made larger; the small one stays for smaller sets
+            if (created_sets != 0) {
+                _grow(slot, created_sets, layout_sizes);
+            }
+            slot.current++;
+        }
+    }
+
+    Slot& _slot(uint32_t frame_index, uint32_t thread_index) {
+        if (frame_index >= _frame_count || thread_index >= thread_count()) {
+            throw std::runtime_error("descriptor allocator slot out of range");
+        }
+        return _slots[size_t(thread_index) * _frame_count + frame_index];
+    }
+
+    static VkDescriptorPoolSize& _find_size(std::vector<VkDescriptorPoolSize>& sizes, VkDescriptorType type) {
+        auto it = std::find_if(sizes.begin(), sizes.end(), [type](const VkDescriptorPoolSize& s) { return s.type == type; });
+        if (it != sizes.end()) {
+            return *it;
+        }
+        return sizes.emplace_back(VkDescriptorPoolSize{ type, 0 });
+    }
+
+    std::vector<VkDescriptorPoolSize> _pool_sizes(const Slot& slot, uint32_t set_count) const {
+        std::vector<VkDescriptorPoolSize> sizes = _sizes_per_set;
+        for (VkDescriptorPoolSize& s : sizes) {
+            s.descriptorCount = std::max(1u, s.descriptorCount * set_count);
+        }
+        for (const VkDescriptorPoolSize& min : slot.min_sizes) {
+            VkDescriptorPoolSize& s = _find_size(sizes, min.type);
+            s.descriptorCount = std::max(s.descriptorCount, min.descriptorCount);
+        }
+        return sizes;
+    }
+
+    DescriptorPool _create_pool(const Slot& slot, uint32_t set_count) {
+        std::vector<VkDescriptorPoolSize> sizes = _pool_sizes(slot, set_count);
+        return DescriptorPool(_device,
+            DescriptorPoolCreateInfo{}
+                .set_flags(_flags)
+                .set_max_sets(set_count)
+                .set_pool_sizes(static_cast<uint32_t>(sizes.size()), sizes.data())
+                .to_vk()
+        );
+    }
+
+    // Raises the slot's per-pool floor after a set did not fit in a fresh
+    // pool. With the layout's sizes, the types the pool was short of are
+    // raised to what the set needs (all of them doubled if none was short);
+    // without them, only the types of p_sizes_per_set double, so a type
+    // missing there needs the sized allocate().
+    void _grow(Slot& slot, uint32_t failed_pool_sets, std::span<const VkDescriptorPoolSize> layout_sizes) {
+        std::vector<VkDescriptorPoolSize> failed = _pool_sizes(slot, failed_pool_sets);
+        std::vector<VkDescriptorPoolSize> wanted;
+        if (layout_sizes.empty()) {
+            for (const VkDescriptorPoolSize& s : failed) {
+                wanted.push_back(VkDescriptorPoolSize{ s.type, s.descriptorCount * 2 });
+            }
+        } else {
+            for (const VkDescriptorPoolSize& need : layout_sizes) {
+                if (_find_size(failed, need.type).descriptorCount < need.descriptorCount) {
+                    wanted.push_back(need);
+                }
+            }
+            if (wanted.empty()) {
+                for (const VkDescriptorPoolSize& need : layout_sizes) {
+                    wanted.push_back(VkDescriptorPoolSize{ need.type, std::max(1u, _find_size(failed, need.type).descriptorCount * 2) });
+                }
+            }
+        }
+
+        if (wanted.empty()) {
+            throw std::runtime_error("descriptor set needs types the allocator has no sizes for");
+        }
+        for (const VkDescriptorPoolSize& w : wanted) {
+            if (w.descriptorCount > MAX_DESCRIPTORS_PER_TYPE) {
+                throw std::runtime_error("descriptor set does not fit in any descriptor pool");
+            }
+            VkDescriptorPoolSize& min = _find_size(slot.min_sizes, w.type);
+            min.descriptorCount = std::max(min.descriptorCount, w.descriptorCount);
+        }
+    }
+
+    VkDevice _device = VK_NULL_HANDLE;
+    uint32_t _frame_count = 0;
+    VkDescriptorPoolCreateFlags _flags = 0;
+    std::vector<VkDescriptorPoolSize> _sizes_per_set;
+    std::vector<Slot> _slots; // [thread][frame]
+};
+
+}
+
+#endif
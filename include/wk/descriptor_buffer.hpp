@@ -0,0 +1,270 @@
+#ifndef wulkan_wk_DESCRIPTOR_BUFFER_HPP
+#define wulkan_wk_DESCRIPTOR_BUFFER_HPP
+
+#include "vma_include.hpp"
+#include "wulkan_internal.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+
+namespace wk {
+
+// Where one set's descriptors live inside a DescriptorBuffer. offset is what
+// vkCmdSetDescriptorBufferOffsetsEXT takes.
+struct DescriptorBufferAllocation {
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    uint8_t* p_data = nullptr;
+};
+
+// Descriptor backend without pools or sets (VK_EXT_descriptor_buffer). A
+// persistent region at the start of the buffer holds long-lived sets (e.g. a
+// bindless heap), followed by one linear region per frame in flight that is
+// rewound when the frame retires. Layouts need the DESCRIPTOR_BUFFER flag
+// (LayoutCache does this for DescriptorBackend::DescriptorBuffer) and
+// pipelines VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT. The allocator must
+// have been created with buffer device address support. The memory may not
+// be host coherent, so every write is flushed.
+class DescriptorBuffer {
+public:
+    DescriptorBuffer() : _mutex(std::make_unique<std::mutex>()) {}
+    DescriptorBuffer(VkDevice device, VmaAllocator allocator, const DeviceFunctions& f,
+        const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties,
+        VkDeviceSize persistent_size, VkDeviceSize frame_size, uint32_t frame_count)
+        : _device(device),
+          _allocator(allocator),
+          _functions(f),
+          _properties(properties),
+          _mutex(std::make_unique<std::mutex>())
+    {
+        if (!f.vkGetDescriptorSetLayoutSizeEXT || !f.vkGetDescriptorSetLayoutBindingOffsetEXT || !f.vkGetDescriptorEXT) {
+            throw std::runtime_error("device function vkGetDescriptorEXT not set");
+        }
+
+        _persistent_size = _align(persistent_size);
+        _frame_size = _align(frame_size);
+        _frame_cursors.assign(frame_count, 0);
+
+        _buffer = Buffer(allocator,
+            BufferCreateInfo{}
+                .set_size(_persistent_size + _frame_size * frame_count)
+                .set_usage(VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT
+                    | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT
+                    | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+                .set_sharing_mode(VK_SHARING_MODE_EXCLUSIVE)
+                .to_vk(),
+            AllocationCreateInfo{}
+                .set_usage(VMA_MEMORY_USAGE_AUTO)
+                .set_flags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT)
+                .to_vk()
+        );
+
+        VmaAllocationInfo info{};
+        vmaGetAllocationInfo(allocator, _buffer.allocation(), &info);
+        _p_mapped = static_cast<uint8_t*>(info.pMappedData);
+
+        VkBufferDeviceAddressInfo address_info = BufferDeviceAddressInfo{}.set_buffer(_buffer.handle()).to_vk();
+        _address = vkGetBufferDeviceAddress(_device, &address_info);
+    }
+
+    DescriptorBuffer(const DescriptorBuffer&) = delete;
+    DescriptorBuffer& operator=(const DescriptorBuffer&) = delete;
+    DescriptorBuffer(DescriptorBuffer&&) noexcept = default;
+    DescriptorBuffer& operator=(DescriptorBuffer&&) noexcept = default;
+
+    // Lives until the buffer is destroyed.
+    DescriptorBufferAllocation allocate_persistent(VkDescriptorSetLayout layout) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        VkDeviceSize size = _align(_layout_size(layout));
+        if (_persistent_cursor + size > _persistent_size) {
+            throw std::runtime_error("descriptor buffer persistent region is full");
+        }
+        DescriptorBufferAllocation a{ layout, _persistent_cursor, _p_mapped + _persistent_cursor };
+        _persistent_cursor += size;
+        return a;
+    }
+
+    // Valid until reset_frame(frame_index).
+    DescriptorBufferAllocation allocate(uint32_t frame_index, VkDescriptorSetLayout layout) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        VkDeviceSize size = _align(_layout_size(layout));
+        VkDeviceSize& cursor = _frame_cursors.at(frame_index);
+        if (cursor + size > _frame_size) {
+            throw std::runtime_error("descriptor buffer frame region is full");
+        }
+        VkDeviceSize offset = _persistent_size + _frame_size * frame_index + cursor;
+        cursor += size;
+        return DescriptorBufferAllocation{ layout, offset, _p_mapped + offset };
+    }
+
+    // Call once the frame's fence has signalled.
+    void reset_frame(uint32_t frame_index) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _frame_cursors.at(frame_index) = 0;
+    }
+
+    void write(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element,
+        VkDescriptorType type, const VkDescriptorDataEXT& data)
+    {
+        VkDeviceSize binding_offset = 0;
+        {
+            std::lock_guard<std::mutex> lock(*_mutex);
+            binding_offset = _binding_offset(a.layout, binding);
+        }
+        size_t size = descriptor_size(type);
+        VkDeviceSize offset = a.offset + binding_offset + array_element * size;
+
+        VkDescriptorGetInfoEXT info{};
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT;
+        info.type = type;
+        info.data = data;
+        _functions.vkGetDescriptorEXT(_device, &info, size, _p_mapped + offset);
+        vmaFlushAllocation(_allocator, _buffer.allocation(), offset, size);
+    }
+
+    void write_uniform_buffer(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element,
+        VkDeviceAddress address, VkDeviceSize range)
+    {
+        VkDescriptorAddressInfoEXT address_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT, nullptr, address, range, VK_FORMAT_UNDEFINED };
+        VkDescriptorDataEXT data{};
+        data.pUniformBuffer = &address_info;
+        write(a, binding, array_element, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, data);
+    }
+
+    void write_storage_buffer(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element,
+        VkDeviceAddress address, VkDeviceSize range)
+    {
+        VkDescriptorAddressInfoEXT address_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT, nullptr, address, range, VK_FORMAT_UNDEFINED };
+        VkDescriptorDataEXT data{};
+        data.pStorageBuffer = &address_info;
+        write(a, binding, array_element, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, data);
+    }
+
+    void write_sampled_image(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element,
+        VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        VkDescriptorImageInfo image_info{ VK_NULL_HANDLE, view, layout };
+        VkDescriptorDataEXT data{};
+        data.pSampledImage = &image_info;
+        write(a, binding, array_element, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, data);
+    }
+
+    void write_storage_image(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element,
+        VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL)
+    {
+        VkDescriptorImageInfo image_info{ VK_NULL_HANDLE, view, layout };
+        VkDescriptorDataEXT data{};
+        data.pStorageImage = &image_info;
+        write(a, binding, array_element, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, data);
+    }
+
+    void write_sampler(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element, VkSampler sampler) {
+        VkDescriptorDataEXT data{};
+        data.pSampler = &sampler;
+        write(a, binding, array_element, VK_DESCRIPTOR_TYPE_SAMPLER, data);
+    }
+
+    void write_combined_image_sampler(const DescriptorBufferAllocation& a, uint32_t binding, uint32_t array_element,
+        VkSampler sampler, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+    {
+        VkDescriptorImageInfo image_info{ sampler, view, layout };
+        VkDescriptorDataEXT data{};
+        data.pCombinedImageSampler = &image_info;
+        write(a, binding, array_element, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, data);
+    }
+
+    size_t descriptor_size(VkDescriptorType type) const {
+        switch (type) {
+            case VK_DESCRIPTOR_TYPE_SAMPLER: return _properties.samplerDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: return _properties.combinedImageSamplerDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE: return _properties.sampledImageDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE: return _properties.storageImageDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER: return _properties.uniformTexelBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER: return _properties.storageTexelBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return _properties.uniformBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: return _properties.storageBufferDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: return _properties.inputAttachmentDescriptorSize;
+            case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: return _properties.accelerationStructureDescriptorSize;
+            default:
+                throw std::runtime_error("descriptor type not supported by descriptor buffer");
+        }
+    }
+
+    // Bind once per command buffer, then select sets with set_descriptor_buffer_offsets (buffer index 0).
+    VkDescriptorBufferBindingInfoEXT binding_info() const {
+        VkDescriptorBufferBindingInfoEXT info{};
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT;
+        info.address = _address;
+        info.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+        return info;
+    }
+
+    const VkBuffer& handle() const { return _buffer.handle(); }
+    VkDeviceAddress device_address() const { return _address; }
+    const DeviceFunctions& functions() const { return _functions; }
+
+private:
+    VkDeviceSize _align(VkDeviceSize size) const {
+        VkDeviceSize alignment = std::max<VkDeviceSize>(_properties.descriptorBufferOffsetAlignment, 1);
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    VkDeviceSize _layout_size(VkDescriptorSetLayout layout) {
+        auto it = _layout_sizes.find(HandleToUint64(layout));
+        if (it != _layout_sizes.end()) {
+            return it->second;
+        }
+        VkDeviceSize size = 0;
+        _functions.vkGetDescriptorSetLayoutSizeEXT(_device, layout, &size);
+        _layout_sizes.emplace(HandleToUint64(layout), size);
+        return size;
+    }
+
+    VkDeviceSize _binding_offset(VkDescriptorSetLayout layout, uint32_t binding) {
+        std::pair<uint64_t, uint32_t> key{ HandleToUint64(layout), binding };
+        auto it = _binding_offsets.find(key);
+        if (it != _binding_offsets.end()) {
+            return it->second;
+        }
+        VkDeviceSize offset = 0;
+        _functions.vkGetDescriptorSetLayoutBindingOffsetEXT(_device, layout, binding, &offset);
+        _binding_offsets.emplace(key, offset);
+        return offset;
+    }
+
+    struct BindingKeyHash {
+        size_t operator()(const std::pair<uint64_t, uint32_t>& k) const {
+            return std::hash<uint64_t>()(k.first * 31 + k.second);
+        }
+    };
+
+    VkDevice _device = VK_NULL_HANDLE;
+    VmaAllocator _allocator = VK_NULL_HANDLE;
+    DeviceFunctions _functions{};
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT _properties{};
+    std::unique_ptr<std::mutex> _mutex;
+
+    Buffer _buffer;
+    uint8_t* _p_mapped = nullptr;
+    VkDeviceAddress _address = 0;
+
+    VkDeviceSize _persistent_size = 0;
+    VkDeviceSize _persistent_cursor = 0;
+    VkDeviceSize _frame_size = 0;
+    std::vector<VkDeviceSize> _frame_cursors;
+
+    std::unordered_map<uint64_t, VkDeviceSize> _layout_sizes;
+    std::unordered_map<std::pair<uint64_t, uint32_t>, VkDeviceSize, BindingKeyHash> _binding_offsets;
+};
+
+}
+
+#endif
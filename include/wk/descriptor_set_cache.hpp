@@ -0,0 +1,303 @@
+#ifndef wulkan_wk_DESCRIPTOR_SET_CACHE_HPP
+#define wulkan_wk_DESCRIPTOR_SET_CACHE_HPP
+
+#include "wulkan_internal.hpp"
+#include "descriptor_pool.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <list>
+#include <iterator>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+
+namespace wk {
+
+// Returns an existing descriptor set when one was already written with the
+// same layout and resources, so steady-state frames skip allocation and
+// writes entirely. Sets unused for max_age frames are freed, but only once
+// the last frame that used them has retired on the GPU. Before destroying a
+// buffer, view or sampler, invalidate() it so no set referencing it is
+// handed out again.
+class DescriptorSetCache {
+public:
+    static constexpr uint32_t SETS_PER_POOL = 256;
+
+    DescriptorSetCache() : _mutex(std::make_unique<std::mutex>()) {}
+
+    // p_sizes_per_set gives the average number of descriptors of each type a set needs.
+    DescriptorSetCache(VkDevice device, uint32_t size_count, const VkDescriptorPoolSize* p_sizes_per_set,
+        uint32_t max_sets = 4096, uint32_t max_age = 16)
+        : _device(device),
+          _mutex(std::make_unique<std::mutex>()),
+          _sizes_per_set(p_sizes_per_set, p_sizes_per_set + size_count),
+          _max_sets(max_sets),
+          _max_age(max_age) {}
+
+    DescriptorSetCache(const DescriptorSetCache&) = delete;
+    DescriptorSetCache& operator=(const DescriptorSetCache&) = delete;
+    DescriptorSetCache(DescriptorSetCache&&) noexcept = default;
+    DescriptorSetCache& operator=(DescriptorSetCache&&) noexcept = default;
+
+    // dstSet of the writes is ignored; the returned set holds exactly these writes.
+    VkDescriptorSet get(VkDescriptorSetLayout layout, uint32_t write_count, const VkWriteDescriptorSet* p_writes) {
+        std::vector<uint64_t> key = _make_key(layout, write_count, p_writes);
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+        auto it = _lookup.find(key);
+        if (it != _lookup.end()) {
+            _hits++;
+            it->second->last_used = _frame;
+            _lru.splice(_lru.begin(), _lru, it->second);
+            return it->second->set;
+        }
+
+        _misses++;
+        Entry entry;
+        entry.key = std::move(key);
+        entry.last_used = _frame;
+        entry.resources = _resources(write_count, p_writes);
+        _allocate(layout, entry);
+
+        std::vector<VkWriteDescriptorSet> writes(p_writes, p_writes + write_count);
+        for (VkWriteDescriptorSet& w : writes) {
+            w.dstSet = entry.set;
+        }
+        vkUpdateDescriptorSets(_device, write_count, writes.data(), 0, nullptr);
+
+        _lru.push_front(std::move(entry));
+        _lookup.emplace(_lru.front().key, _lru.begin());
+        return _lru.front().set;
+    }
+
+    // frame is the number of the frame being recorded, retired_frame the last
+    // one whose fence has signalled. Sets are only freed if no frame in
+    // flight can still reference them.
+    void begin_frame(uint64_t frame, uint64_t retired_frame) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _frame = frame;
+        for (auto it = _stale.begin(); it != _stale.end();) {
+            if (it->last_used > retired_frame) {
+                ++it;
+                continue;
+            }
+            vkFreeDescriptorSets(_device, it->pool, 1, &it->set);
+            it = _stale.erase(it);
+        }
+        while (!_lru.empty()) {
+            Entry& oldest = _lru.back();
+            bool expired = frame - oldest.last_used > _max_age || _lru.size() > _max_sets;
+            if (!expired || oldest.last_used > retired_frame) {
+                break;
+            }
+            vkFreeDescriptorSets(_device, oldest.pool, 1, &oldest.set);
+            _lookup.erase(oldest.key);
+            _lru.pop_back();
+        }
+    }
+
+    // Stops handing out sets that reference the resource (a VkBuffer,
+    // VkImageView, VkSampler or VkBufferView). They are freed by begin_frame
+    // once no frame in flight can still use them.
+    template<typename Handle>
+    void invalidate(Handle resource) {
+        uint64_t handle = HandleToUint64(resource);
+        std::lock_guard<std::mutex> lock(*_mutex);
+        for (auto it = _lru.begin(); it != _lru.end();) {
+            auto next = std::next(it);
+            if (std::find(it->resources.begin(), it->resources.end(), handle) != it->resources.end()) {
+                _retire(it);
+            }
+            it = next;
+        }
+    }
+
+    // Drops every set, freeing them the same way as invalidate().
+    void clear() {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        while (!_lru.empty()) {
+            _retire(_lru.begin());
+        }
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _lru.size();
+    }
+
+    uint64_t hits() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _hits;
+    }
+
+    uint64_t misses() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _misses;
+    }
+
+    double hit_rate() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _hits + _misses ? double(_hits) / double(_hits + _misses) : 0.0;
+    }
+
+private:
+    struct Entry {
+        std::vector<uint64_t> key;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        uint64_t last_used = 0;
+        std::vector<uint64_t> resources; // handles written into the set
+    };
+
+    struct KeyHash {
+        size_t operator()(const std::vector<uint64_t>& key) const {
+            uint64_t h = 0xcbf29ce484222325ull;
+            for (uint64_t v : key) {
+                h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+
+    static std::vector<uint64_t> _make_key(VkDescriptorSetLayout layout, uint32_t write_count, const VkWriteDescriptorSet* p_writes) {
+        std::vector<uint64_t> key{ HandleToUint64(layout) };
+        for (uint32_t i = 0; i < write_count; ++i) {
+            const VkWriteDescriptorSet& w = p_writes[i];
+            key.push_back((uint64_t(w.dstBinding) << 32) | w.dstArrayElement);
+            key.push_back((uint64_t(w.descriptorType) << 32) | w.descriptorCount);
+            for (uint32_t d = 0; d < w.descriptorCount; ++d) {
+                // only the fields the descriptor type reads, the rest may be garbage
+                switch (w.descriptorType) {
+                    case VK_DESCRIPTOR_TYPE_SAMPLER:
+                        key.push_back(HandleToUint64(w.pImageInfo[d].sampler));
+                        break;
+                    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                        key.push_back(HandleToUint64(w.pImageInfo[d].sampler));
+                        key.push_back(HandleToUint64(w.pImageInfo[d].imageView));
+                        key.push_back(w.pImageInfo[d].imageLayout);
+                        break;
+                    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+                    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                        key.push_back(HandleToUint64(w.pImageInfo[d].imageView));
+                        key.push_back(w.pImageInfo[d].imageLayout);
+                        break;
+                    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                        key.push_back(HandleToUint64(w.pBufferInfo[d].buffer));
+                        key.push_back(w.pBufferInfo[d].offset);
+                        key.push_back(w.pBufferInfo[d].range);
+                        break;
+                    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                        key.push_back(HandleToUint64(w.pTexelBufferView[d]));
+                        break;
+                    default:
+                        throw std::runtime_error("descriptor type not supported by descriptor set cache");
+                }
+            }
+        }
+        return key;
+    }
+
+    static std::vector<uint64_t> _resources(uint32_t write_count, const VkWriteDescriptorSet* p_writes) {
+        std::vector<uint64_t> resources;
+        for (uint32_t i = 0; i < write_count; ++i) {
+            const VkWriteDescriptorSet& w = p_writes[i];
+            for (uint32_t d = 0; d < w.descriptorCount; ++d) {
+                // the pointers not used by the descriptor type are ignored by Vulkan, so may be garbage
+                switch (w.descriptorType) {
+                    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+                    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+                        resources.push_back(HandleToUint64(w.pBufferInfo[d].buffer));
+                        break;
+                    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+                    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+                        resources.push_back(HandleToUint64(w.pTexelBufferView[d]));
+                        break;
+                    case VK_DESCRIPTOR_TYPE_SAMPLER:
+                        resources.push_back(HandleToUint64(w.pImageInfo[d].sampler));
+                        break;
+                    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+                        resources.push_back(HandleToUint64(w.pImageInfo[d].sampler));
+                        resources.push_back(HandleToUint64(w.pImageInfo[d].imageView));
+                        break;
+                    default:
+                        resources.push_back(HandleToUint64(w.pImageInfo[d].imageView));
+                        break;
+                }
+            }
+        }
+        return resources;
+    }
+
+    // Takes the entry out of the lookup; begin_frame frees it once retired.
+    void _retire(std::list<Entry>::iterator it) {
+        _lookup.erase(it->key);
+        _stale.splice(_stale.end(), _lru, it);
+    }
+
+    void _allocate(VkDescriptorSetLayout layout, Entry& entry) {
+        VkDescriptorSetAllocateInfo ai{};
+        ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        ai.descriptorSetCount = 1;
+        ai.pSetLayouts = &layout;
+
+        // freed sets leave room in older pools, so try them all before growing
+        for (const DescriptorPool& pool : _pools) {
+            ai.descriptorPool = pool.handle();
+            VkResult result = vkAllocateDescriptorSets(_device, &ai, &entry.set);
+            if (result == VK_SUCCESS) {
+                entry.pool = pool.handle();
+                return;
+            }
+            if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+                throw std::runtime_error("failed to allocate descriptor set");
+            }
+        }
+
+        std::vector<VkDescriptorPoolSize> sizes = _sizes_per_set;
+        for (VkDescriptorPoolSize& s : sizes) {
+            s.descriptorCount = std::max(1u, s.descriptorCount * SETS_PER_POOL);
+        }
+        _pools.emplace_back(_device,
+            DescriptorPoolCreateInfo{}
+                .set_flags(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)
+                .set_max_sets(SETS_PER_POOL)
+                .set_pool_sizes(static_cast<uint32_t>(sizes.size()), sizes.data())
+                .to_vk()
+        );
+
+        ai.descriptorPool = _pools.back().handle();
+        if (vkAllocateDescriptorSets(_device, &ai, &entry.set) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor set");
+        }
+        entry.pool = _pools.back().handle();
+    }
+
+    VkDevice _device = VK_NULL_HANDLE;
+    std::unique_ptr<std::mutex> _mutex;
+    std::vector<VkDescriptorPoolSize> _sizes_per_set;
+    uint32_t _max_sets = 0;
+    uint32_t _max_age = 0;
+    uint64_t _frame = 0;
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+
+    std::vector<DescriptorPool> _pools; // sets are freed with their pool
+    std::list<Entry> _lru; // most recently used first
+    std::list<Entry> _stale; // invalidated, freed once their last frame retires
+    std::unordered_map<std::vector<uint64_t>, std::list<Entry>::iterator, KeyHash> _lookup;
+};
+
+}
+
+#endif
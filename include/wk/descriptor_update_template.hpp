@@ -3,8 +3,68 @@
 
 #include "wulkan_internal.hpp"
 
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <span>
+#include <type_traits>
+
+// Update entry for one member of a descriptor struct. The member is a
+// VkDescriptorImageInfo, VkDescriptorBufferInfo or VkBufferView, or an array
+// of them for an arrayed binding:
+//   struct MaterialSet {
+//       VkDescriptorBufferInfo constants;
+//       VkDescriptorImageInfo textures[4];
+//   };
+//   constexpr std::array MATERIAL_SET_ENTRIES = {
+//       WLK_DESCRIPTOR_UPDATE_ENTRY(MaterialSet, constants, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER),
+//       WLK_DESCRIPTOR_UPDATE_ENTRY(MaterialSet, textures, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+//   };
+#define WLK_DESCRIPTOR_UPDATE_ENTRY(type, member, binding, descriptor_type) \
+    ::wk::MakeDescriptorUpdateEntry<std::remove_all_extents_t<decltype(type::member)>>( \
+        (binding), (descriptor_type), offsetof(type, member), sizeof(type::member))
+
 namespace wk {
 
+// Whether Info is the struct vkUpdateDescriptorSetWithTemplate reads for descriptors of this type.
+template<typename Info>
+constexpr bool IsDescriptorInfoFor(VkDescriptorType type) {
+    switch (type) {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+            return std::is_same_v<Info, VkDescriptorImageInfo>;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            return std::is_same_v<Info, VkDescriptorBufferInfo>;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            return std::is_same_v<Info, VkBufferView>;
+        default:
+            return false;
+    }
+}
+
+// In a constexpr array a mismatched type fails to compile; at run time it throws.
+template<typename Info>
+constexpr VkDescriptorUpdateTemplateEntry MakeDescriptorUpdateEntry(uint32_t binding, VkDescriptorType type,
+    size_t offset, size_t member_size)
+{
+    static_assert(std::is_same_v<Info, VkDescriptorImageInfo> || std::is_same_v<Info, VkDescriptorBufferInfo>
+        || std::is_same_v<Info, VkBufferView>,
+        "descriptor struct members must be image infos, buffer infos or buffer views");
+    if (!IsDescriptorInfoFor<Info>(type)) {
+        throw std::runtime_error("descriptor struct member does not match its descriptor type");
+    }
+    return VkDescriptorUpdateTemplateEntry{
+        binding, 0, static_cast<uint32_t>(member_size / sizeof(Info)), type, offset, sizeof(Info)
+    };
+}
+
 class DescriptorUpdateTemplate {
 public:
     DescriptorUpdateTemplate() = default;
@@ -86,6 +146,69 @@ private:
     uint32_t _set = 0;
 };
 
+// Update template generated from a struct describing the set's bindings;
+// updating a set is then one vkUpdateDescriptorSetWithTemplate call. The
+// push descriptor constructor instead builds a template for
+// CommandEncoder::push_descriptors, which records the struct straight into
+// the command buffer without allocating a set.
+template<typename T>
+class TypedDescriptorUpdateTemplate {
+    static_assert(std::is_standard_layout_v<T>, "descriptor struct must be standard layout");
+
+public:
+    TypedDescriptorUpdateTemplate() = default;
+    TypedDescriptorUpdateTemplate(VkDevice device, VkDescriptorSetLayout layout,
+        std::span<const VkDescriptorUpdateTemplateEntry> entries)
+        : _device(device),
+          _template(device,
+            DescriptorUpdateTemplateCreateInfo{}
+                .set_descriptor_update_entry_count(static_cast<uint32_t>(entries.size()))
+                .set_p_descriptor_update_entries(entries.data())
+                .set_template_type(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET)
+                .set_descriptor_set_layout(layout)
+                .to_vk()
+          ) {}
+
+    // set_layout must have been created with the PUSH_DESCRIPTOR flag.
+    TypedDescriptorUpdateTemplate(VkDevice device, VkDescriptorSetLayout set_layout,
+        VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set,
+        std::span<const VkDescriptorUpdateTemplateEntry> entries)
+        : _device(device),
+          _template(device,
+            DescriptorUpdateTemplateCreateInfo{}
+                .set_descriptor_update_entry_count(static_cast<uint32_t>(entries.size()))
+                .set_p_descriptor_update_entries(entries.data())
+                .set_template_type(VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR)
+                .set_descriptor_set_layout(set_layout)
+                .set_pipeline_bind_point(bind_point)
+                .set_pipeline_layout(pipeline_layout)
+                .set_set(set)
+                .to_vk()
+          ),
+          _push(true),
+          _pipeline_layout(pipeline_layout),
+          _set(set) {}
+
+    void update(VkDescriptorSet set, const T& data) const {
+        if (_push) {
+            throw std::runtime_error("push descriptor templates are recorded through CommandEncoder::push_descriptors");
+        }
+        vkUpdateDescriptorSetWithTemplate(_device, set, _template.handle(), &data);
+    }
+
+    const VkDescriptorUpdateTemplate& handle() const { return _template.handle(); }
+    bool is_push() const { return _push; }
+    VkPipelineLayout pipeline_layout() const { return _pipeline_layout; }
+    uint32_t set() const { return _set; }
+
+private:
+    VkDevice _device = VK_NULL_HANDLE;
+    DescriptorUpdateTemplate _template;
+    bool _push = false;
+    VkPipelineLayout _pipeline_layout = VK_NULL_HANDLE; // push templates only
+    uint32_t _set = 0;
+};
+
 } // namespace wk
 
 #endif
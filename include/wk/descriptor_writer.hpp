@@ -0,0 +1,211 @@
+#ifndef wulkan_wk_DESCRIPTOR_WRITER_HPP
+#define wulkan_wk_DESCRIPTOR_WRITER_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+namespace wk {
+
+// Collects descriptor writes for any number of sets and applies them with a
+// single vkUpdateDescriptorSets call. The writer copies every image, buffer,
+// texel buffer and acceleration structure it is given, so callers may pass
+// temporaries. On flush, writes to consecutive array elements of the same
+// binding are merged and repeated writes to one element keep the last value.
+// Not thread-safe; use one writer per thread.
+class DescriptorWriter {
+public:
+    DescriptorWriter() = default;
+
+    DescriptorWriter& write_buffer(VkDescriptorSet set, uint32_t binding, uint32_t array_element, VkDescriptorType type,
+        VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE)
+    {
+        _push(set, binding, array_element, type, Kind::Buffer, _buffer_infos.size());
+        _buffer_infos.push_back(VkDescriptorBufferInfo{ buffer, offset, range });
+        return *this;
+    }
+
+    DescriptorWriter& write_buffers(VkDescriptorSet set, uint32_t binding, uint32_t first_array_element, VkDescriptorType type,
+        uint32_t count, const VkDescriptorBufferInfo* p_infos)
+    {
+        for (uint32_t i = 0; i < count; ++i) {
+            write_buffer(set, binding, first_array_element + i, type, p_infos[i].buffer, p_infos[i].offset, p_infos[i].range);
+        }
+        return *this;
+    }
+
+    DescriptorWriter& write_image(VkDescriptorSet set, uint32_t binding, uint32_t array_element, VkDescriptorType type,
+        VkImageView view, VkImageLayout layout, VkSampler sampler = VK_NULL_HANDLE)
+    {
+        _push(set, binding, array_element, type, Kind::Image, _image_infos.size());
+        _image_infos.push_back(VkDescriptorImageInfo{ sampler, view, layout });
+        return *this;
+    }
+
+    DescriptorWriter& write_images(VkDescriptorSet set, uint32_t binding, uint32_t first_array_element, VkDescriptorType type,
+        uint32_t count, const VkDescriptorImageInfo* p_infos)
+    {
+        for (uint32_t i = 0; i < count; ++i) {
+            write_image(set, binding, first_array_element + i, type, p_infos[i].imageView, p_infos[i].imageLayout, p_infos[i].sampler);
+        }
+        return *this;
+    }
+
+    DescriptorWriter& write_sampler(VkDescriptorSet set, uint32_t binding, uint32_t array_element, VkSampler sampler) {
+        return write_image(set, binding, array_element, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED, sampler);
+    }
+
+    DescriptorWriter& write_texel_buffer(VkDescriptorSet set, uint32_t binding, uint32_t array_element, VkDescriptorType type,
+        VkBufferView view)
+    {
+        _push(set, binding, array_element, type, Kind::TexelBuffer, _texel_buffer_views.size());
+        _texel_buffer_views.push_back(view);
+        return *this;
+    }
+
+    DescriptorWriter& write_acceleration_structure(VkDescriptorSet set, uint32_t binding, uint32_t array_element,
+        VkAccelerationStructureKHR acceleration_structure)
+    {
+        _push(set, binding, array_element, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
+            Kind::AccelerationStructure, _acceleration_structures.size());
+        _acceleration_structures.push_back(acceleration_structure);
+        return *this;
+    }
+
+    // Applies every pending write and returns the number of VkWriteDescriptorSet
+    // structs it took. The writer is empty afterwards.
+    uint32_t flush(VkDevice device) {
+        if (_pending.empty()) {
+            return 0;
+        }
+
+        // stable, so duplicates stay in recording order and the last one wins
+        std::stable_sort(_pending.begin(), _pending.end(), [](const Pending& a, const Pending& b) {
+            if (a.set != b.set) return HandleToUint64(a.set) < HandleToUint64(b.set);
+            if (a.binding != b.binding) return a.binding < b.binding;
+            return a.array_element < b.array_element;
+        });
+        std::vector<Pending> unique;
+        unique.reserve(_pending.size());
+        for (const Pending& p : _pending) {
+            if (!unique.empty() && unique.back().set == p.set && unique.back().binding == p.binding
+                && unique.back().array_element == p.array_element) {
+                unique.back() = p;
+            } else {
+                unique.push_back(p);
+            }
+        }
+
+        // repacked in write order so merged writes see contiguous infos; sized
+        // up front so the pointers taken below stay valid
+        std::vector<VkDescriptorBufferInfo> buffer_infos;
+        std::vector<VkDescriptorImageInfo> image_infos;
+        std::vector<VkBufferView> texel_buffer_views;
+        std::vector<VkAccelerationStructureKHR> acceleration_structures;
+        std::vector<VkWriteDescriptorSetAccelerationStructureKHR> acceleration_structure_writes;
+        std::vector<VkWriteDescriptorSet> writes;
+        buffer_infos.reserve(_buffer_infos.size());
+        image_infos.reserve(_image_infos.size());
+        texel_buffer_views.reserve(_texel_buffer_views.size());
+        acceleration_structures.reserve(_acceleration_structures.size());
+        acceleration_structure_writes.reserve(_acceleration_structures.size());
+        writes.reserve(unique.size());
+
+        for (const Pending& p : unique) {
+            bool merge = false;
+            if (!writes.empty()) {
+                const VkWriteDescriptorSet& last = writes.back();
+                merge = last.dstSet == p.set && last.dstBinding == p.binding && last.descriptorType == p.type
+                    && last.dstArrayElement + last.descriptorCount == p.array_element;
+            }
+
+            if (!merge) {
+                VkWriteDescriptorSet w{};
+                w.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                w.dstSet = p.set;
+                w.dstBinding = p.binding;
+                w.dstArrayElement = p.array_element;
+                w.descriptorType = p.type;
+                switch (p.kind) {
+                    case Kind::Buffer: w.pBufferInfo = buffer_infos.data() + buffer_infos.size(); break;
+                    case Kind::Image: w.pImageInfo = image_infos.data() + image_infos.size(); break;
+                    case Kind::TexelBuffer: w.pTexelBufferView = texel_buffer_views.data() + texel_buffer_views.size(); break;
+                    case Kind::AccelerationStructure: {
+                        VkWriteDescriptorSetAccelerationStructureKHR as{};
+                        as.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+                        as.pAccelerationStructures = acceleration_structures.data() + acceleration_structures.size();
+                        acceleration_structure_writes.push_back(as);
+                        w.pNext = &acceleration_structure_writes.back();
+                        break;
+                    }
+                }
+                writes.push_back(w);
+            }
+
+            writes.back().descriptorCount++;
+            switch (p.kind) {
+                case Kind::Buffer: buffer_infos.push_back(_buffer_infos[p.info]); break;
+                case Kind::Image: image_infos.push_back(_image_infos[p.info]); break;
+                case Kind::TexelBuffer: texel_buffer_views.push_back(_texel_buffer_views[p.info]); break;
+                case Kind::AccelerationStructure:
+                    acceleration_structures.push_back(_acceleration_structures[p.info]);
+                    acceleration_structure_writes.back().accelerationStructureCount++;
+                    break;
+            }
+        }
+
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        clear();
+        return static_cast<uint32_t>(writes.size());
+    }
+
+    void clear() {
+        _pending.clear();
+        _buffer_infos.clear();
+        _image_infos.clear();
+        _texel_buffer_views.clear();
+        _acceleration_structures.clear();
+    }
+
+    size_t size() const { return _pending.size(); }
+    bool empty() const { return _pending.empty(); }
+
+private:
+    enum class Kind : uint8_t {
+        Buffer,
+        Image,
+        TexelBuffer,
+        AccelerationStructure
+    };
+
+    // one descriptor; info indexes the storage vector of its kind
+    struct Pending {
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        uint32_t binding = 0;
+        uint32_t array_element = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        Kind kind = Kind::Buffer;
+        size_t info = 0;
+    };
+
+    void _push(VkDescriptorSet set, uint32_t binding, uint32_t array_element, VkDescriptorType type, Kind kind, size_t info) {
+        if (set == VK_NULL_HANDLE) {
+            throw std::runtime_error("descriptor write has no destination set");
+        }
+        _pending.push_back(Pending{ set, binding, array_element, type, kind, info });
+    }
+
+    std::vector<Pending> _pending;
+    std::vector<VkDescriptorBufferInfo> _buffer_infos;
+    std::vector<VkDescriptorImageInfo> _image_infos;
+    std::vector<VkBufferView> _texel_buffer_views;
+    std::vector<VkAccelerationStructureKHR> _acceleration_structures;
+};
+
+}
+
+#endif
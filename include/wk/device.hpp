@@ -125,6 +125,41 @@ private:
     const VkSemaphore* _p_signal_semaphores = nullptr;
 };
 
+// Values for the timeline semaphores of a VkSubmitInfo; binary semaphores
+// in the same submit take any value.
+class TimelineSemaphoreSubmitInfo {
+public:
+    TimelineSemaphoreSubmitInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    TimelineSemaphoreSubmitInfo& set_wait_semaphore_values(uint32_t count, const uint64_t* values) {
+        _wait_semaphore_value_count = count;
+        _p_wait_semaphore_values = values;
+        return *this;
+    }
+    TimelineSemaphoreSubmitInfo& set_signal_semaphore_values(uint32_t count, const uint64_t* values) {
+        _signal_semaphore_value_count = count;
+        _p_signal_semaphore_values = values;
+        return *this;
+    }
+
+    VkTimelineSemaphoreSubmitInfo to_vk() const {
+        VkTimelineSemaphoreSubmitInfo si{};
+        si.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        si.pNext = _p_next;
+        si.waitSemaphoreValueCount = _wait_semaphore_value_count;
+        si.pWaitSemaphoreValues = _p_wait_semaphore_values;
+        si.signalSemaphoreValueCount = _signal_semaphore_value_count;
+        si.pSignalSemaphoreValues = _p_signal_semaphore_values;
+        return si;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    uint32_t _wait_semaphore_value_count = 0;
+    const uint64_t* _p_wait_semaphore_values = nullptr;
+    uint32_t _signal_semaphore_value_count = 0;
+    const uint64_t* _p_signal_semaphore_values = nullptr;
+};
+
 class PresentInfo {
 public:
     PresentInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
@@ -40,7 +40,9 @@ public:
     AccelerationStructure& operator=(const AccelerationStructure&) = delete;
 
     AccelerationStructure(AccelerationStructure&& other) noexcept
-        : _device(other._device), _handle(other._handle)
+        : _handle(other._handle), _device(other._device),
+          _vkCreateAccelerationStructureKHR(other._vkCreateAccelerationStructureKHR),
+          _vkDestroyAccelerationStructureKHR(other._vkDestroyAccelerationStructureKHR)
     {
         other._handle = VK_NULL_HANDLE;
         other._device = VK_NULL_HANDLE;
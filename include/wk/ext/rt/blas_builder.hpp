@@ -0,0 +1,124 @@
+#ifndef wulkan_wk_ext_rt_BLAS_BUILDER_HPP
+#define wulkan_wk_ext_rt_BLAS_BUILDER_HPP
+
+#include "rt_internal.hpp"
+#include "acceleration_structure.hpp"
+#include "../../buffer.hpp"
+#include "../../allocator.hpp"
+#include "../../query_pool.hpp"
+#include "../../deletion_queue.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <stdexcept>
+#include <iostream>
+
+namespace wk::ext::rt {
+
+// One bottom level acceleration structure: a range per geometry. Anything
+// chained into the geometries' pNext has to stay alive until it is built.
+struct BlasInput {
+    std::vector<VkAccelerationStructureGeometryKHR> geometries;
+    std::vector<VkAccelerationStructureBuildRangeInfoKHR> ranges;
+    VkBuildAccelerationStructureFlagsKHR flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+};
+
+// Builds many BLASes with few commands. add() sizes each one and creates
+// it; record() then builds everything added since the last record(), packing
+// the scratch of as many builds as fit in scratch_budget into one pooled
+// buffer, aligned to minAccelerationStructureScratchOffsetAlignment, and
+// issuing them as a single vkCmdBuildAccelerationStructuresKHR per batch.
+// Batches reuse the pool, separated by barriers, so scratch memory stays
+// within the budget however many structures there are (a single build
+// larger than the budget gets a batch of its own).
+//
+// Recorded builds have to run on one queue. The structures are ready for
+// TLAS builds once the commands complete; release_scratch() then frees the
+// pool.
+//
+// With allow_compaction every structure is built with ALLOW_COMPACTION and
+// record() also queries its compacted size. compact() copies the structures
+// whose sizes are back into right-sized buffers and hands the originals to
+// a DeletionQueue, so it never waits on the GPU and can be called every
+// frame, even before the recorded builds have been submitted. The query
+// pools are reset on the host, so compaction needs the hostQueryReset
+// feature (core in 1.2). Compaction moves structures: device_address()
+// changes, so build TLASes from the compacted ones.
+class BlasBuilder {
+public:
+    BlasBuilder() = default;
+    BlasBuilder(VkDevice device, VkPhysicalDevice physical_device, VmaAllocator allocator, const DeviceFunctions& f,
+        VkDeviceSize scratch_budget = 64ull << 20, bool allow_compaction = true);
+
+    BlasBuilder(const BlasBuilder&) = delete;
+    BlasBuilder& operator=(const BlasBuilder&) = delete;
+    BlasBuilder(BlasBuilder&&) noexcept = default;
+    BlasBuilder& operator=(BlasBuilder&&) noexcept = default;
+
+    // Returns the index of the structure.
+    uint32_t add(const BlasInput& input);
+
+    void record(VkCommandBuffer command_buffer);
+
+    // Only once the commands from every record() so far have completed.
+    void release_scratch();
+
+    // Records compacting copies of every structure whose size query has
+    // completed, retiring the originals into deletion_queue. Returns how many
+    // were compacted.
+    uint32_t compact(VkCommandBuffer command_buffer, DeletionQueue& deletion_queue);
+    bool is_compaction_pending() const { return !_compactions.empty(); }
+    // Bytes compaction has given back so far.
+    VkDeviceSize compacted_savings() const { return _compacted_savings; }
+
+    const AccelerationStructure& acceleration_structure(uint32_t index) const { return _entries.at(index).acceleration_structure; }
+    VkDeviceAddress device_address(uint32_t index) const { return _entries.at(index).address; }
+    size_t size() const { return _entries.size(); }
+    VkDeviceSize scratch_budget() const { return _scratch_budget; }
+
+private:
+    struct Entry {
+        BlasInput input;
+        VkAccelerationStructureBuildSizesInfoKHR sizes{};
+        Buffer buffer;
+        AccelerationStructure acceleration_structure;
+        VkDeviceAddress address = 0;
+    };
+
+    // Size queries for the structures [first, last) built by one record().
+    struct Compaction {
+        QueryPool query_pool;
+        size_t first = 0;
+        size_t last = 0;
+    };
+
+    // The storage of a structure that has been compacted.
+    struct Retired {
+        Buffer buffer;
+        AccelerationStructure acceleration_structure; // destroyed before its buffer
+    };
+
+    VkDevice _device = VK_NULL_HANDLE;
+    VmaAllocator _allocator = VK_NULL_HANDLE;
+    DeviceFunctions _functions{};
+    VkDeviceSize _scratch_alignment = 1;
+    VkDeviceSize _scratch_budget = 0;
+    bool _allow_compaction = false;
+
+    std::vector<Entry> _entries;
+    size_t _first_unbuilt = 0;
+
+    Buffer _scratch;
+    VkDeviceSize _scratch_size = 0;
+    VkDeviceAddress _scratch_address = 0; // aligned start of the pool
+    bool _is_scratch_used = false;
+    std::vector<Buffer> _retired_scratch; // outgrown, possibly still in use
+
+    std::deque<Compaction> _compactions; // oldest first
+    VkDeviceSize _compacted_savings = 0;
+};
+
+} // namespace wk::ext::rt
+
+#endif // wulkan_wk_ext_rt_BLAS_BUILDER_HPP
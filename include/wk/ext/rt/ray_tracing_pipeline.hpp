@@ -2,10 +2,14 @@
 #define wulkan_WK_EXT_RT_RAY_TRACING_PIPELINE_HPP
 
 #include "wk/ext/rt/rt_internal.hpp"
+#include "wk/pipeline_feedback.hpp"
 
 #include <cstdint>
 #include <stdexcept>
 #include <iostream>
+#include <optional>
+#include <vector>
+#include <memory>
 
 namespace wk::ext::rt {
 
@@ -15,21 +19,39 @@ public:
 
     RayTracingPipeline(VkDevice device, const DeviceFunctions& f, const VkRayTracingPipelineCreateInfoKHR& ci,
         VkDeferredOperationKHR deferred_op = VK_NULL_HANDLE,
-        VkPipelineCache pipeline_cache = VK_NULL_HANDLE)
+        VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+        PipelineCreationReport* p_report = nullptr, const char* label = nullptr)
         : _device(device),
           _vkCreateRayTracingPipelinesKHR(f.vkCreateRayTracingPipelinesKHR)
     {
+        // deferred creation finishes after this returns, so feedback is only
+        // collected for immediate creation
+        VkRayTracingPipelineCreateInfoKHR create_info = ci;
+        std::optional<PipelineCreationFeedback> feedback;
+        if (p_report && deferred_op == VK_NULL_HANDLE) {
+            feedback.emplace(ci.stageCount, ci.pStages);
+            create_info.pNext = feedback->chain(ci.pNext);
+        }
         if (_vkCreateRayTracingPipelinesKHR(_device,
                 deferred_op,
                 pipeline_cache,
                 1,
-                &ci,
+                &create_info,
                 nullptr,
                 &_handle) != VK_SUCCESS) {
             throw std::runtime_error("failed to create ray tracing pipeline");
         }
+        if (feedback) {
+            p_report->add(feedback->record(label, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR));
+        }
     }
 
+    // Takes ownership of an already created pipeline.
+    RayTracingPipeline(VkDevice device, const DeviceFunctions& f, VkPipeline handle)
+        : _handle(handle),
+          _device(device),
+          _vkCreateRayTracingPipelinesKHR(f.vkCreateRayTracingPipelinesKHR) {}
+
     ~RayTracingPipeline() {
         if (_handle != VK_NULL_HANDLE) {
             vkDestroyPipeline(_device, _handle, nullptr);
@@ -72,6 +94,50 @@ private:
     PFN_vkCreateRayTracingPipelinesKHR _vkCreateRayTracingPipelinesKHR = VK_NULL_HANDLE;
 };
 
+// Creates every pipeline in one vkCreateRayTracingPipelinesKHR call so the
+// driver can compile them in parallel and share work across the batch.
+// Throws only on errors; pipelines the driver did not create on a positive
+// result come back with a null handle.
+inline std::vector<RayTracingPipeline> CreateRayTracingPipelines(VkDevice device, const DeviceFunctions& f,
+    uint32_t count, const VkRayTracingPipelineCreateInfoKHR* p_create_infos,
+    VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+    PipelineCreationReport* p_report = nullptr, const char* const* p_labels = nullptr)
+{
+    if (f.vkCreateRayTracingPipelinesKHR == nullptr) {
+        throw std::runtime_error("device function vkCreateRayTracingPipelinesKHR not set");
+    }
+
+    std::vector<VkRayTracingPipelineCreateInfoKHR> create_infos(p_create_infos, p_create_infos + count);
+    std::vector<std::unique_ptr<PipelineCreationFeedback>> feedback;
+    if (p_report) {
+        for (VkRayTracingPipelineCreateInfoKHR& ci : create_infos) {
+            feedback.push_back(std::make_unique<PipelineCreationFeedback>(ci.stageCount, ci.pStages));
+            ci.pNext = feedback.back()->chain(ci.pNext);
+        }
+    }
+
+    std::vector<VkPipeline> handles(count, VK_NULL_HANDLE);
+    if (f.vkCreateRayTracingPipelinesKHR(device, VK_NULL_HANDLE, pipeline_cache, count,
+            create_infos.data(), nullptr, handles.data()) < VK_SUCCESS) {
+        for (VkPipeline handle : handles) {
+            if (handle != VK_NULL_HANDLE) {
+                vkDestroyPipeline(device, handle, nullptr);
+            }
+        }
+        throw std::runtime_error("failed to create ray tracing pipelines");
+    }
+
+    std::vector<RayTracingPipeline> pipelines;
+    pipelines.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        pipelines.emplace_back(device, f, handles[i]);
+        if (p_report && handles[i] != VK_NULL_HANDLE) {
+            p_report->add(feedback[i]->record(p_labels ? p_labels[i] : nullptr, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR));
+        }
+    }
+    return pipelines;
+}
+
 class RayTracingShaderGroupCreateInfo {
 public:
     RayTracingShaderGroupCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
@@ -0,0 +1,346 @@
+#ifndef wulkan_wk_GRAPHICS_PIPELINE_CACHE_HPP
+#define wulkan_wk_GRAPHICS_PIPELINE_CACHE_HPP
+
+#include "wulkan_internal.hpp"
+#include "pipeline.hpp"
+#include "pipeline_feedback.hpp"
+#include "specialization.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <bit>
+
+namespace wk {
+
+// Topologies that may be swapped at record time must share a class when
+// VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY is set.
+inline uint32_t PrimitiveTopologyClass(VkPrimitiveTopology topology) {
+    switch (topology) {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+        return 0;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+        return 1;
+    case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+// Canonical key of a graphics pipeline: everything baked into it, with state
+// declared dynamic left out and order-independent lists sorted. Understands
+// the rendering, library and creation feedback structures in pNext; any
+// other chained structure cannot be keyed and throws.
+inline std::vector<uint64_t> GraphicsPipelineKey(const VkGraphicsPipelineCreateInfo& ci) {
+    std::vector<VkDynamicState> dynamic_states;
+    if (ci.pDynamicState) {
+        dynamic_states.assign(ci.pDynamicState->pDynamicStates,
+            ci.pDynamicState->pDynamicStates + ci.pDynamicState->dynamicStateCount);
+        std::sort(dynamic_states.begin(), dynamic_states.end());
+    }
+    auto is_dynamic = [&](VkDynamicState state) {
+        return std::binary_search(dynamic_states.begin(), dynamic_states.end(), state);
+    };
+
+    // the dynamic states go first, so skipping their values below is unambiguous
+    std::vector<uint64_t> key{ ci.flags, dynamic_states.size() };
+    key.insert(key.end(), dynamic_states.begin(), dynamic_states.end());
+
+    auto push_static = [&](VkDynamicState state, uint64_t value) {
+        if (!is_dynamic(state)) {
+            key.push_back(value);
+        }
+    };
+    auto push_float = [&](float value) {
+        key.push_back(std::bit_cast<uint32_t>(value));
+    };
+    auto push_string = [&](const char* p_string) {
+        size_t length = p_string ? std::strlen(p_string) : 0;
+        key.push_back(length);
+        for (size_t i = 0; i < length; i += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, p_string + i, std::min(sizeof(uint64_t), length - i));
+            key.push_back(word);
+        }
+    };
+    auto require_no_chain = [](const void* p_next) {
+        if (p_next) {
+            throw std::runtime_error("graphics pipeline cache cannot key pipeline state chain");
+        }
+    };
+
+    // shader stages, in stage order
+    std::vector<const VkPipelineShaderStageCreateInfo*> stages;
+    for (uint32_t i = 0; i < ci.stageCount; ++i) {
+        stages.push_back(&ci.pStages[i]);
+    }
+    std::sort(stages.begin(), stages.end(), [](auto* a, auto* b) { return a->stage < b->stage; });
+    key.push_back(stages.size());
+    for (const VkPipelineShaderStageCreateInfo* stage : stages) {
+        require_no_chain(stage->pNext);
+        key.insert(key.end(), { stage->flags, uint64_t(stage->stage), HandleToUint64(stage->module) });
+        push_string(stage->pName);
+        std::vector<uint64_t> spec = SpecializationKey(stage->pSpecializationInfo);
+        key.push_back(spec.size());
+        key.insert(key.end(), spec.begin(), spec.end());
+    }
+
+    key.push_back(ci.pVertexInputState != nullptr);
+    if (const VkPipelineVertexInputStateCreateInfo* vi = ci.pVertexInputState; vi && !is_dynamic(VK_DYNAMIC_STATE_VERTEX_INPUT_EXT)) {
+        require_no_chain(vi->pNext);
+        std::vector<VkVertexInputBindingDescription> bindings(vi->pVertexBindingDescriptions,
+            vi->pVertexBindingDescriptions + vi->vertexBindingDescriptionCount);
+        std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+        key.push_back(bindings.size());
+        for (const VkVertexInputBindingDescription& b : bindings) {
+            key.insert(key.end(), { b.binding, uint64_t(b.inputRate) });
+            push_static(VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE, b.stride);
+        }
+        std::vector<VkVertexInputAttributeDescription> attributes(vi->pVertexAttributeDescriptions,
+            vi->pVertexAttributeDescriptions + vi->vertexAttributeDescriptionCount);
+        std::sort(attributes.begin(), attributes.end(), [](const auto& a, const auto& b) { return a.location < b.location; });
+        key.push_back(attributes.size());
+        for (const VkVertexInputAttributeDescription& a : attributes) {
+            key.insert(key.end(), { a.location, a.binding, uint64_t(a.format), a.offset });
+        }
+    }
+
+    key.push_back(ci.pInputAssemblyState != nullptr);
+    if (const VkPipelineInputAssemblyStateCreateInfo* ia = ci.pInputAssemblyState) {
+        require_no_chain(ia->pNext);
+        key.push_back(is_dynamic(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY) ? PrimitiveTopologyClass(ia->topology) : uint64_t(ia->topology));
+        push_static(VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE, ia->primitiveRestartEnable);
+    }
+
+    key.push_back(ci.pTessellationState != nullptr);
+    if (const VkPipelineTessellationStateCreateInfo* ts = ci.pTessellationState) {
+        require_no_chain(ts->pNext);
+        push_static(VK_DYNAMIC_STATE_PATCH_CONTROL_POINTS_EXT, ts->patchControlPoints);
+    }
+
+    key.push_back(ci.pViewportState != nullptr);
+    if (const VkPipelineViewportStateCreateInfo* vp = ci.pViewportState) {
+        require_no_chain(vp->pNext);
+        push_static(VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT, vp->viewportCount);
+        push_static(VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT, vp->scissorCount);
+        if (vp->pViewports && !is_dynamic(VK_DYNAMIC_STATE_VIEWPORT) && !is_dynamic(VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT)) {
+            for (uint32_t i = 0; i < vp->viewportCount; ++i) {
+                const VkViewport& v = vp->pViewports[i];
+                for (float f : { v.x, v.y, v.width, v.height, v.minDepth, v.maxDepth }) {
+                    push_float(f);
+                }
+            }
+        }
+        if (vp->pScissors && !is_dynamic(VK_DYNAMIC_STATE_SCISSOR) && !is_dynamic(VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT)) {
+            for (uint32_t i = 0; i < vp->scissorCount; ++i) {
+                const VkRect2D& r = vp->pScissors[i];
+                key.insert(key.end(), { uint64_t(uint32_t(r.offset.x)), uint64_t(uint32_t(r.offset.y)), r.extent.width, r.extent.height });
+            }
+        }
+    }
+
+    key.push_back(ci.pRasterizationState != nullptr);
+    if (const VkPipelineRasterizationStateCreateInfo* rs = ci.pRasterizationState) {
+        require_no_chain(rs->pNext);
+        key.push_back(rs->flags);
+        push_static(VK_DYNAMIC_STATE_DEPTH_CLAMP_ENABLE_EXT, rs->depthClampEnable);
+        push_static(VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE, rs->rasterizerDiscardEnable);
+        push_static(VK_DYNAMIC_STATE_POLYGON_MODE_EXT, rs->polygonMode);
+        push_static(VK_DYNAMIC_STATE_CULL_MODE, rs->cullMode);
+        push_static(VK_DYNAMIC_STATE_FRONT_FACE, rs->frontFace);
+        push_static(VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE, rs->depthBiasEnable);
+        if (!is_dynamic(VK_DYNAMIC_STATE_DEPTH_BIAS)) {
+            push_float(rs->depthBiasConstantFactor);
+            push_float(rs->depthBiasClamp);
+            push_float(rs->depthBiasSlopeFactor);
+        }
+        if (!is_dynamic(VK_DYNAMIC_STATE_LINE_WIDTH)) {
+            push_float(rs->lineWidth);
+        }
+    }
+
+    key.push_back(ci.pMultisampleState != nullptr);
+    if (const VkPipelineMultisampleStateCreateInfo* ms = ci.pMultisampleState) {
+        require_no_chain(ms->pNext);
+        key.push_back(ms->flags);
+        push_static(VK_DYNAMIC_STATE_RASTERIZATION_SAMPLES_EXT, ms->rasterizationSamples);
+        key.push_back(ms->sampleShadingEnable);
+        push_float(ms->minSampleShading);
+        if (!is_dynamic(VK_DYNAMIC_STATE_SAMPLE_MASK_EXT)) {
+            key.push_back(ms->pSampleMask != nullptr);
+            for (uint32_t i = 0; ms->pSampleMask && i < (uint32_t(ms->rasterizationSamples) + 31) / 32; ++i) {
+                key.push_back(ms->pSampleMask[i]);
+            }
+        }
+        push_static(VK_DYNAMIC_STATE_ALPHA_TO_COVERAGE_ENABLE_EXT, ms->alphaToCoverageEnable);
+        push_static(VK_DYNAMIC_STATE_ALPHA_TO_ONE_ENABLE_EXT, ms->alphaToOneEnable);
+    }
+
+    key.push_back(ci.pDepthStencilState != nullptr);
+    if (const VkPipelineDepthStencilStateCreateInfo* ds = ci.pDepthStencilState) {
+        require_no_chain(ds->pNext);
+        key.push_back(ds->flags);
+        push_static(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE, ds->depthTestEnable);
+        push_static(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE, ds->depthWriteEnable);
+        push_static(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP, ds->depthCompareOp);
+        push_static(VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE, ds->depthBoundsTestEnable);
+        push_static(VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE, ds->stencilTestEnable);
+        for (const VkStencilOpState* op : { &ds->front, &ds->back }) {
+            if (!is_dynamic(VK_DYNAMIC_STATE_STENCIL_OP)) {
+                key.insert(key.end(), { uint64_t(op->failOp), uint64_t(op->passOp), uint64_t(op->depthFailOp), uint64_t(op->compareOp) });
+            }
+            push_static(VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK, op->compareMask);
+            push_static(VK_DYNAMIC_STATE_STENCIL_WRITE_MASK, op->writeMask);
+            push_static(VK_DYNAMIC_STATE_STENCIL_REFERENCE, op->reference);
+        }
+        if (!is_dynamic(VK_DYNAMIC_STATE_DEPTH_BOUNDS)) {
+            push_float(ds->minDepthBounds);
+            push_float(ds->maxDepthBounds);
+        }
+    }
+
+    key.push_back(ci.pColorBlendState != nullptr);
+    if (const VkPipelineColorBlendStateCreateInfo* cb = ci.pColorBlendState) {
+        require_no_chain(cb->pNext);
+        key.push_back(cb->flags);
+        push_static(VK_DYNAMIC_STATE_LOGIC_OP_ENABLE_EXT, cb->logicOpEnable);
+        push_static(VK_DYNAMIC_STATE_LOGIC_OP_EXT, cb->logicOp);
+        key.push_back(cb->attachmentCount);
+        for (uint32_t i = 0; cb->pAttachments && i < cb->attachmentCount; ++i) {
+            const VkPipelineColorBlendAttachmentState& a = cb->pAttachments[i];
+            push_static(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT, a.blendEnable);
+            if (!is_dynamic(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT)) {
+                key.insert(key.end(), {
+                    uint64_t(a.srcColorBlendFactor), uint64_t(a.dstColorBlendFactor), uint64_t(a.colorBlendOp),
+                    uint64_t(a.srcAlphaBlendFactor), uint64_t(a.dstAlphaBlendFactor), uint64_t(a.alphaBlendOp)
+                });
+            }
+            push_static(VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT, a.colorWriteMask);
+        }
+        if (!is_dynamic(VK_DYNAMIC_STATE_BLEND_CONSTANTS)) {
+            for (float c : cb->blendConstants) {
+                push_float(c);
+            }
+        }
+    }
+
+    key.insert(key.end(), {
+        HandleToUint64(ci.layout), HandleToUint64(ci.renderPass), ci.subpass,
+        HandleToUint64(ci.basePipelineHandle), uint64_t(uint32_t(ci.basePipelineIndex))
+    });
+
+    for (auto p = static_cast<const VkBaseInStructure*>(ci.pNext); p; p = p->pNext) {
+        // feedback only receives results, it does not change the pipeline
+        if (p->sType == VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO) {
+            continue;
+        }
+        key.push_back(p->sType);
+        switch (p->sType) {
+        case VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO: {
+            auto r = reinterpret_cast<const VkPipelineRenderingCreateInfo*>(p);
+            key.insert(key.end(), { r->viewMask, r->colorAttachmentCount });
+            for (uint32_t i = 0; i < r->colorAttachmentCount; ++i) {
+                key.push_back(r->pColorAttachmentFormats[i]);
+            }
+            key.insert(key.end(), { uint64_t(r->depthAttachmentFormat), uint64_t(r->stencilAttachmentFormat) });
+            break;
+        }
+        case VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT:
+            key.push_back(reinterpret_cast<const VkGraphicsPipelineLibraryCreateInfoEXT*>(p)->flags);
+            break;
+        case VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR: {
+            auto l = reinterpret_cast<const VkPipelineLibraryCreateInfoKHR*>(p);
+            std::vector<uint64_t> libraries;
+            for (uint32_t i = 0; i < l->libraryCount; ++i) {
+                libraries.push_back(HandleToUint64(l->pLibraries[i]));
+            }
+            std::sort(libraries.begin(), libraries.end());
+            key.push_back(libraries.size());
+            key.insert(key.end(), libraries.begin(), libraries.end());
+            break;
+        }
+        default:
+            throw std::runtime_error("graphics pipeline cache cannot key graphics pipeline create info chain");
+        }
+    }
+    return key;
+}
+
+// Owns graphics pipelines keyed by GraphicsPipelineKey, so create infos that
+// only differ in state declared dynamic share one pipeline; set that state
+// at record time through a CommandEncoder. Keys are compared in full, so a
+// hit is always the pipeline the create info describes. Creation runs
+// outside the lock: two threads missing on the same key may both compile
+// it, and only the first result is kept.
+class GraphicsPipelineCache {
+public:
+    GraphicsPipelineCache() : _mutex(std::make_unique<std::mutex>()) {}
+    explicit GraphicsPipelineCache(VkDevice device, VkPipelineCache pipeline_cache = VK_NULL_HANDLE)
+        : _device(device), _pipeline_cache(pipeline_cache), _mutex(std::make_unique<std::mutex>()) {}
+
+    GraphicsPipelineCache(const GraphicsPipelineCache&) = delete;
+    GraphicsPipelineCache& operator=(const GraphicsPipelineCache&) = delete;
+    GraphicsPipelineCache(GraphicsPipelineCache&&) noexcept = default;
+    GraphicsPipelineCache& operator=(GraphicsPipelineCache&&) noexcept = default;
+
+    // The report only gets a record when the pipeline is actually created.
+    VkPipeline get(const VkGraphicsPipelineCreateInfo& ci, PipelineCreationReport* p_report = nullptr, const char* label = nullptr) {
+        std::vector<uint64_t> key = GraphicsPipelineKey(ci);
+
+        {
+            std::lock_guard<std::mutex> lock(*_mutex);
+            auto it = _pipelines.find(key);
+            if (it != _pipelines.end()) {
+                _hits++;
+                return it->second.handle();
+            }
+        }
+
+        // a pipeline losing the race is destroyed after the lock is released
+        Pipeline pipeline(_device, ci, _pipeline_cache, p_report, label);
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _misses++;
+        return _pipelines.try_emplace(std::move(key), std::move(pipeline)).first->second.handle();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _pipelines.size();
+    }
+    uint64_t hits() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _hits;
+    }
+    uint64_t misses() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _misses;
+    }
+
+    // Only once no command buffer still references the pipelines.
+    void clear() {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _pipelines.clear();
+    }
+
+private:
+    VkDevice _device = VK_NULL_HANDLE;
+    VkPipelineCache _pipeline_cache = VK_NULL_HANDLE;
+    std::unique_ptr<std::mutex> _mutex;
+    std::map<std::vector<uint64_t>, Pipeline> _pipelines;
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef wulkan_wk_IMAGE_VIEW_CACHE_HPP
+#define wulkan_wk_IMAGE_VIEW_CACHE_HPP
+
+#include "wulkan_internal.hpp"
+#include "image_view.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <bit>
+
+namespace wk {
+
+// Owns image views per image, keyed by format, subresource range and
+// swizzle (plus view type and flags), so every user of the same view of an
+// image gets the same handle. Views live until their image is evicted.
+class ImageViewCache {
+public:
+    ImageViewCache() : _mutex(std::make_unique<std::mutex>()) {}
+    explicit ImageViewCache(VkDevice device)
+        : _device(device), _mutex(std::make_unique<std::mutex>()) {}
+
+    ImageViewCache(const ImageViewCache&) = delete;
+    ImageViewCache& operator=(const ImageViewCache&) = delete;
+    ImageViewCache(ImageViewCache&&) noexcept = default;
+    ImageViewCache& operator=(ImageViewCache&&) noexcept = default;
+
+    // Understands usage, min LOD and YCbCr conversion structures in pNext;
+    // anything else cannot be keyed and throws.
+    VkImageView get(const VkImageViewCreateInfo& ci) {
+        const VkImageSubresourceRange& r = ci.subresourceRange;
+        std::vector<uint64_t> key{
+            ci.flags, ci.viewType, ci.format,
+            _swizzle(ci.components.r, VK_COMPONENT_SWIZZLE_R), _swizzle(ci.components.g, VK_COMPONENT_SWIZZLE_G),
+            _swizzle(ci.components.b, VK_COMPONENT_SWIZZLE_B), _swizzle(ci.components.a, VK_COMPONENT_SWIZZLE_A),
+            r.aspectMask, r.baseMipLevel, r.levelCount, r.baseArrayLayer, r.layerCount
+        };
+        for (auto p = static_cast<const VkBaseInStructure*>(ci.pNext); p; p = p->pNext) {
+            key.push_back(p->sType);
+            switch (p->sType) {
+            case VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO:
+                key.push_back(reinterpret_cast<const VkImageViewUsageCreateInfo*>(p)->usage);
+                break;
+            case VK_STRUCTURE_TYPE_IMAGE_VIEW_MIN_LOD_CREATE_INFO_EXT:
+                key.push_back(std::bit_cast<uint32_t>(reinterpret_cast<const VkImageViewMinLodCreateInfoEXT*>(p)->minLod));
+                break;
+            case VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO:
+                key.push_back(HandleToUint64(reinterpret_cast<const VkSamplerYcbcrConversionInfo*>(p)->conversion));
+                break;
+            default:
+                throw std::runtime_error("image view cache cannot key image view create info chain");
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+        std::map<std::vector<uint64_t>, ImageView>& views = _views[ci.image];
+        auto it = views.find(key);
+        if (it != views.end()) {
+            return it->second.handle();
+        }
+
+        ImageView view(_device, ci);
+        VkImageView handle = view.handle();
+        views.emplace(std::move(key), std::move(view));
+        return handle;
+    }
+
+    VkImageView get(VkImage image, VkImageViewType view_type, VkFormat format, const VkImageSubresourceRange& range,
+        const VkComponentMapping& components = ComponentMapping::identity().to_vk())
+    {
+        return get(ImageViewCreateInfo{}
+            .set_image(image)
+            .set_view_type(view_type)
+            .set_format(format)
+            .set_components(components)
+            .set_subresource_range(range)
+            .to_vk());
+    }
+
+    // Destroys every view of image. Call before destroying the image, once
+    // the GPU is done with its views.
+    void evict(VkImage image) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _views.erase(image);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        size_t count = 0;
+        for (const auto& [image, views] : _views) {
+            count += views.size();
+        }
+        return count;
+    }
+
+private:
+    // An explicit swizzle to a component's own channel is the identity.
+    static uint64_t _swizzle(VkComponentSwizzle swizzle, VkComponentSwizzle own) {
+        return swizzle == own ? VK_COMPONENT_SWIZZLE_IDENTITY : swizzle;
+    }
+
+    VkDevice _device = VK_NULL_HANDLE;
+    std::unique_ptr<std::mutex> _mutex;
+    std::unordered_map<VkImage, std::map<std::vector<uint64_t>, ImageView>> _views;
+};
+
+}
+
+#endif
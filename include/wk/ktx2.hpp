@@ -0,0 +1,95 @@
+#ifndef wulkan_wk_KTX2_HPP
+#define wulkan_wk_KTX2_HPP
+
+#include "wulkan_internal.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <span>
+#include <algorithm>
+
+namespace wk {
+
+// KTX2 supercompression schemes
+constexpr uint32_t KTX2_SUPERCOMPRESSION_NONE = 0;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_BASIS_LZ = 1;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZSTD = 2;
+constexpr uint32_t KTX2_SUPERCOMPRESSION_ZLIB = 3;
+
+struct Ktx2Level {
+    uint64_t byte_offset = 0;
+    uint64_t byte_length = 0;
+    uint64_t uncompressed_byte_length = 0;
+};
+
+// A memory mapped KTX2 texture. Level data is handed out in place; with
+// supercompression (or VK_FORMAT_UNDEFINED, i.e. Basis Universal) it has to
+// go through a transcoder before the GPU can use it. A level holds every
+// layer, face and depth slice in that order, each tightly packed.
+class Ktx2File {
+public:
+    Ktx2File() = default;
+    explicit Ktx2File(const char* path);
+
+    Ktx2File(const Ktx2File&) = delete;
+    Ktx2File& operator=(const Ktx2File&) = delete;
+    Ktx2File(Ktx2File&&) noexcept = default;
+    Ktx2File& operator=(Ktx2File&&) noexcept = default;
+
+    VkFormat format() const { return _format; }
+    uint32_t type_size() const { return _type_size; }
+    // Unused dimensions are 1, not 0 as stored in the file.
+    VkExtent3D extent() const { return _extent; }
+    VkImageType image_type() const { return _image_type; }
+    uint32_t layer_count() const { return _layer_count; }
+    uint32_t face_count() const { return _face_count; }
+    uint32_t level_count() const { return static_cast<uint32_t>(_levels.size()); }
+    bool is_array() const { return _is_array; }
+    bool is_cube() const { return _face_count == 6; }
+    uint32_t supercompression_scheme() const { return _supercompression_scheme; }
+    bool needs_transcoding() const {
+        return _supercompression_scheme != KTX2_SUPERCOMPRESSION_NONE || _format == VK_FORMAT_UNDEFINED;
+    }
+
+    const Ktx2Level& level(uint32_t level) const { return _levels.at(level); }
+    std::span<const uint8_t> level_data(uint32_t level) const {
+        const Ktx2Level& l = _levels.at(level);
+        return _file.bytes().subspan(l.byte_offset, l.byte_length);
+    }
+    VkExtent3D level_extent(uint32_t level) const {
+        return VkExtent3D{
+            std::max(_extent.width >> level, 1u),
+            std::max(_extent.height >> level, 1u),
+            std::max(_extent.depth >> level, 1u)
+        };
+    }
+
+    std::span<const uint8_t> data_format_descriptor() const { return _dfd; }
+    std::span<const uint8_t> key_value_data() const { return _kvd; }
+    std::span<const uint8_t> supercompression_global_data() const { return _sgd; }
+
+private:
+    MappedFile _file;
+    VkFormat _format = VK_FORMAT_UNDEFINED;
+    uint32_t _type_size = 0;
+    VkExtent3D _extent{ 1, 1, 1 };
+    VkImageType _image_type = VK_IMAGE_TYPE_2D;
+    uint32_t _layer_count = 1;
+    uint32_t _face_count = 1;
+    bool _is_array = false;
+    uint32_t _supercompression_scheme = KTX2_SUPERCOMPRESSION_NONE;
+    std::vector<Ktx2Level> _levels; // level 0 is the largest
+    std::span<const uint8_t> _dfd;
+    std::span<const uint8_t> _kvd;
+    std::span<const uint8_t> _sgd;
+};
+
+// Size in texels of one texel block, 1x1 for uncompressed formats.
+VkExtent2D FormatBlockExtent(VkFormat format);
+
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef wulkan_wk_LAYOUT_CACHE_HPP
+#define wulkan_wk_LAYOUT_CACHE_HPP
+
+#include "wulkan_internal.hpp"
+#include "descriptor_set_layout.hpp"
+#include "pipeline_layout.hpp"
+#include "shader_reflection.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <numeric>
+
+namespace wk {
+
+// Owns descriptor set and pipeline layouts, handing out the same handle for
+// identical descriptions so sets stay compatible across pipelines.
+class LayoutCache {
+public:
+    static constexpr uint32_t NO_PUSH_DESCRIPTOR_SET = UINT32_MAX;
+
+    LayoutCache() : _mutex(std::make_unique<std::mutex>()) {}
+    // With the descriptor buffer backend every set layout except push
+    // descriptor ones gets the DESCRIPTOR_BUFFER flag; callers keep passing
+    // the same descriptions.
+    explicit LayoutCache(VkDevice device, DescriptorBackend backend = DescriptorBackend::DescriptorSets)
+        : _device(device), _backend(backend), _mutex(std::make_unique<std::mutex>()) {}
+
+    LayoutCache(const LayoutCache&) = delete;
+    LayoutCache& operator=(const LayoutCache&) = delete;
+    LayoutCache(LayoutCache&&) noexcept = default;
+    LayoutCache& operator=(LayoutCache&&) noexcept = default;
+
+    VkDescriptorSetLayout descriptor_set_layout(uint32_t binding_count, const VkDescriptorSetLayoutBinding* p_bindings,
+        VkDescriptorSetLayoutCreateFlags flags = 0, const VkDescriptorBindingFlags* p_binding_flags = nullptr)
+    {
+        // push descriptors are pushed with the command buffer, never placed in a descriptor buffer
+        if (!(flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)) {
+            flags |= DescriptorBackendLayoutFlags(_backend);
+        }
+
+        // bindings are order independent, so sort before building the key
+        std::vector<uint32_t> order(binding_count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return p_bindings[a].binding < p_bindings[b].binding;
+        });
+
+        std::vector<VkDescriptorSetLayoutBinding> bindings;
+        std::vector<VkDescriptorBindingFlags> binding_flags;
+        std::vector<uint64_t> key{ flags, binding_count, p_binding_flags != nullptr };
+        for (uint32_t i : order) {
+            const VkDescriptorSetLayoutBinding& b = p_bindings[i];
+            bindings.push_back(b);
+            key.push_back(b.binding);
+            key.push_back(b.descriptorType);
+            key.push_back(b.descriptorCount);
+            key.push_back(b.stageFlags);
+            if (b.pImmutableSamplers) {
+                for (uint32_t s = 0; s < b.descriptorCount; ++s) {
+                    key.push_back(HandleToUint64(b.pImmutableSamplers[s]));
+                }
+            }
+            if (p_binding_flags) {
+                binding_flags.push_back(p_binding_flags[i]);
+                key.push_back(p_binding_flags[i]);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+        auto it = _set_layouts.find(key);
+        if (it != _set_layouts.end()) {
+            return it->second.handle();
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flags_ci{};
+        flags_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        flags_ci.bindingCount = static_cast<uint32_t>(binding_flags.size());
+        flags_ci.pBindingFlags = binding_flags.data();
+
+        DescriptorSetLayout layout(_device,
+            DescriptorSetLayoutCreateInfo{}
+                .set_p_next(p_binding_flags ? &flags_ci : nullptr)
+                .set_flags(flags)
+                .set_bindings(static_cast<uint32_t>(bindings.size()), bindings.data())
+                .to_vk()
+        );
+        VkDescriptorSetLayout handle = layout.handle();
+        _set_layouts.emplace(std::move(key), std::move(layout));
+        return handle;
+    }
+
+    VkPipelineLayout pipeline_layout(uint32_t set_layout_count, const VkDescriptorSetLayout* p_set_layouts,
+        uint32_t push_constant_range_count, const VkPushConstantRange* p_push_constant_ranges)
+    {
+        std::vector<uint64_t> key{ set_layout_count, push_constant_range_count };
+        for (uint32_t i = 0; i < set_layout_count; ++i) {
+            key.push_back(HandleToUint64(p_set_layouts[i]));
+        }
+        for (uint32_t i = 0; i < push_constant_range_count; ++i) {
+            key.push_back(p_push_constant_ranges[i].stageFlags);
+            key.push_back(p_push_constant_ranges[i].offset);
+            key.push_back(p_push_constant_ranges[i].size);
+        }
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+        auto it = _pipeline_layouts.find(key);
+        if (it != _pipeline_layouts.end()) {
+            return it->second.handle();
+        }
+
+        PipelineLayout layout(_device,
+            PipelineLayoutCreateInfo{}
+                .set_set_layouts(set_layout_count, p_set_layouts)
+                .set_push_constant_ranges(push_constant_range_count, p_push_constant_ranges)
+                .to_vk()
+        );
+        VkPipelineLayout handle = layout.handle();
+        _pipeline_layouts.emplace(std::move(key), std::move(layout));
+        return handle;
+    }
+
+    // One layout per set index up to the highest set used; gaps get empty layouts.
+    // The set at push_descriptor_set, if any, is created for push descriptors.
+    std::vector<VkDescriptorSetLayout> descriptor_set_layouts(const ShaderReflection& reflection, uint32_t runtime_array_count = 1,
+        uint32_t push_descriptor_set = NO_PUSH_DESCRIPTOR_SET)
+    {
+        std::vector<VkDescriptorSetLayout> layouts;
+        for (uint32_t set = 0; set < reflection.set_count(); ++set) {
+            std::vector<VkDescriptorSetLayoutBinding> bindings = reflection.set_bindings(set, runtime_array_count);
+            VkDescriptorSetLayoutCreateFlags flags = set == push_descriptor_set ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+            layouts.push_back(descriptor_set_layout(static_cast<uint32_t>(bindings.size()), bindings.data(), flags));
+        }
+        return layouts;
+    }
+
+    VkPipelineLayout pipeline_layout(const ShaderReflection& reflection, uint32_t runtime_array_count = 1,
+        uint32_t push_descriptor_set = NO_PUSH_DESCRIPTOR_SET)
+    {
+        std::vector<VkDescriptorSetLayout> layouts = descriptor_set_layouts(reflection, runtime_array_count, push_descriptor_set);
+        return pipeline_layout(static_cast<uint32_t>(layouts.size()), layouts.data(),
+            static_cast<uint32_t>(reflection.push_constant_ranges.size()), reflection.push_constant_ranges.data());
+    }
+
+    DescriptorBackend backend() const { return _backend; }
+
+private:
+    VkDevice _device = VK_NULL_HANDLE;
+    DescriptorBackend _backend = DescriptorBackend::DescriptorSets;
+    std::unique_ptr<std::mutex> _mutex;
+    std::map<std::vector<uint64_t>, DescriptorSetLayout> _set_layouts;
+    std::map<std::vector<uint64_t>, PipelineLayout> _pipeline_layouts;
+};
+
+}
+
+#endif
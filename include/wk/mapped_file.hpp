@@ -0,0 +1,66 @@
+#ifndef wulkan_wk_MAPPED_FILE_HPP
+#define wulkan_wk_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <span>
+
+namespace wk {
+
+// Read-only memory map of a whole file. The mapping is page aligned, so any
+// 4 byte aligned offset into it can be handed to Vulkan as SPIR-V directly.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const char* path);
+
+    ~MappedFile() { _unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : _data(other._data),
+          _size(other._size),
+          _file(other._file),
+          _mapping(other._mapping)
+    {
+        other._data = nullptr;
+        other._size = 0;
+        other._file = nullptr;
+        other._mapping = nullptr;
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            _unmap();
+            _data = other._data;
+            _size = other._size;
+            _file = other._file;
+            _mapping = other._mapping;
+            other._data = nullptr;
+            other._size = 0;
+            other._file = nullptr;
+            other._mapping = nullptr;
+        }
+        return *this;
+    }
+
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+    std::span<const uint8_t> bytes() const { return { _data, _size }; }
+    bool is_open() const { return _data != nullptr; }
+
+private:
+    void _unmap();
+
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+    void* _file = nullptr;    // HANDLE on windows, unused elsewhere
+    void* _mapping = nullptr; // HANDLE on windows, unused elsewhere
+};
+
+}
+
+#endif
@@ -0,0 +1,426 @@
+#ifndef wulkan_wk_MIP_GENERATOR_HPP
+#define wulkan_wk_MIP_GENERATOR_HPP
+
+#include "vma_include.hpp"
+#include "wulkan_internal.hpp"
+#include "buffer.hpp"
+#include "allocator.hpp"
+#include "image_view.hpp"
+#include "sampler.hpp"
+#include "descriptor_set_layout.hpp"
+#include "pipeline_layout.hpp"
+#include "pipeline.hpp"
+#include "sync.hpp"
+#include "command_encoder.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+namespace wk {
+
+// Views of one image for MipGenerator. Created by MipGenerator::prepare and
+// kept alive for as long as any recorded generate() of the image is pending.
+class MipChain {
+public:
+    MipChain() = default;
+
+    VkImage image() const { return _image; }
+    VkExtent2D extent() const { return _extent; }
+    uint32_t mip_levels() const { return _mip_levels; }
+    uint32_t array_layers() const { return _array_layers; }
+    bool uses_compute() const { return _uses_compute; }
+
+private:
+    friend class MipGenerator;
+
+    VkImage _image = VK_NULL_HANDLE;
+    VkExtent2D _extent{};
+    uint32_t _mip_levels = 1;
+    uint32_t _array_layers = 1;
+    bool _uses_compute = false;
+    VkFilter _blit_filter = VK_FILTER_LINEAR;
+    ImageView _sampled_view;                // mip 0
+    std::vector<ImageView> _storage_views;  // mip 1 onwards
+};
+
+// Builds a whole mip chain in one compute dispatch, single pass downsampler
+// style: workgroups reduce 64x64 tiles through shared memory and the last one
+// to finish (atomic counter) reduces the remaining levels. Formats without
+// storage image support, chains deeper than MAX_COMPUTE_MIPS, or images
+// larger than 4096 texels on a side fall back to a chain of blits.
+//
+// The compute path needs the SPIR-V of shaders/spd_downsample.comp,
+// VK_KHR_push_descriptor, shaderStorageImageWriteWithoutFormat, and images
+// created with STORAGE and SAMPLED usage. The blit path needs TRANSFER_SRC
+// and TRANSFER_DST. Not thread-safe: generate() reuses internal buffers, so
+// record it from one thread at a time.
+class MipGenerator {
+public:
+    static constexpr uint32_t MAX_COMPUTE_MIPS = 12; // levels below mip 0
+    static constexpr uint32_t TILE_SIZE = 64;
+
+    MipGenerator() = default;
+    MipGenerator(VkDevice device, VkPhysicalDevice physical_device, VmaAllocator allocator,
+        VkShaderModule spd_module, uint32_t max_array_layers = 6, VkPipelineCache pipeline_cache = VK_NULL_HANDLE)
+        : _device(device),
+          _physical_device(physical_device),
+          _max_array_layers(max_array_layers)
+    {
+        _sampler = Sampler(_device,
+            SamplerCreateInfo{}
+                .set_mag_filter(VK_FILTER_LINEAR)
+                .set_min_filter(VK_FILTER_LINEAR)
+                .set_mipmap_mode(VK_SAMPLER_MIPMAP_MODE_NEAREST)
+                .set_address_mode_u(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE)
+                .set_address_mode_v(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE)
+                .set_address_mode_w(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE)
+                .set_min_lod(0.0f)
+                .set_max_lod(0.0f)
+                .to_vk()
+        );
+
+        VkDescriptorSetLayoutBinding bindings[] = {
+            DescriptorSetLayoutBinding{}
+                .set_binding(0)
+                .set_descriptor_type(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+                .set_descriptor_count(1)
+                .set_stage_flags(VK_SHADER_STAGE_COMPUTE_BIT)
+                .to_vk(),
+            DescriptorSetLayoutBinding{}
+                .set_binding(1)
+                .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+                .set_descriptor_count(MAX_COMPUTE_MIPS)
+                .set_stage_flags(VK_SHADER_STAGE_COMPUTE_BIT)
+                .to_vk(),
+            DescriptorSetLayoutBinding{}
+                .set_binding(2)
+                .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+                .set_descriptor_count(1)
+                .set_stage_flags(VK_SHADER_STAGE_COMPUTE_BIT)
+                .to_vk(),
+            DescriptorSetLayoutBinding{}
+                .set_binding(3)
+                .set_descriptor_type(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+                .set_descriptor_count(1)
+                .set_stage_flags(VK_SHADER_STAGE_COMPUTE_BIT)
+                .to_vk(),
+        };
+        _set_layout = DescriptorSetLayout(_device,
+            DescriptorSetLayoutCreateInfo{}
+                .set_flags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR)
+                .set_bindings(4, bindings)
+                .to_vk()
+        );
+
+        VkPushConstantRange push_constant_range{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) };
+        _pipeline_layout = PipelineLayout(_device,
+            PipelineLayoutCreateInfo{}
+                .set_set_layouts(1, &_set_layout.handle())
+                .set_push_constant_ranges(1, &push_constant_range)
+                .to_vk()
+        );
+
+        _pipeline = Pipeline(_device,
+            ComputePipelineCreateInfo{}
+                .set_stage(PipelineShaderStageCreateInfo{}
+                    .set_stage(VK_SHADER_STAGE_COMPUTE_BIT)
+                    .set_module(spd_module)
+                    .set_p_name("main")
+                    .to_vk())
+                .set_layout(_pipeline_layout.handle())
+                .to_vk(),
+            pipeline_cache
+        );
+
+        // mip 6 of every layer is at most 64x64 texels of vec4
+        _mip6_buffer = Buffer(allocator,
+            BufferCreateInfo{}
+                .set_size(VkDeviceSize(TILE_SIZE) * TILE_SIZE * 4 * sizeof(float) * _max_array_layers)
+                .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+                .to_vk(),
+            AllocationCreateInfo{}
+                .set_usage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                .to_vk()
+        );
+        _counter_buffer = Buffer(allocator,
+            BufferCreateInfo{}
+                .set_size(sizeof(uint32_t) * _max_array_layers)
+                .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+                .to_vk(),
+            AllocationCreateInfo{}
+                .set_usage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+                .to_vk()
+        );
+    }
+
+    MipGenerator(const MipGenerator&) = delete;
+    MipGenerator& operator=(const MipGenerator&) = delete;
+    MipGenerator(MipGenerator&&) noexcept = default;
+    MipGenerator& operator=(MipGenerator&&) noexcept = default;
+
+    static uint32_t MipLevelCount(VkExtent2D extent) {
+        uint32_t levels = 1;
+        for (uint32_t size = std::max(extent.width, extent.height); size > 1; size >>= 1) {
+            levels++;
+        }
+        return levels;
+    }
+
+    bool supports_compute(VkFormat format, VkImageUsageFlags usage) const {
+        VkFormatProperties props{};
+        vkGetPhysicalDeviceFormatProperties(_physical_device, format, &props);
+        VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (props.optimalTilingFeatures & needed) == needed
+            && (usage & VK_IMAGE_USAGE_STORAGE_BIT) && (usage & VK_IMAGE_USAGE_SAMPLED_BIT);
+    }
+
+    // Picks the compute path when the format, usage and size allow it.
+    MipChain prepare(VkImage image, VkFormat format, VkImageUsageFlags usage, VkExtent2D extent,
+        uint32_t mip_levels, uint32_t array_layers = 1) const
+    {
+        MipChain chain;
+        chain._image = image;
+        chain._extent = extent;
+        chain._mip_levels = mip_levels;
+        chain._array_layers = array_layers;
+        // the mip 6 buffer holds at most 64x64 workgroup results per layer
+        chain._uses_compute = mip_levels > 1 && mip_levels - 1 <= MAX_COMPUTE_MIPS
+            && std::max(extent.width, extent.height) <= TILE_SIZE * 64
+            && array_layers <= _max_array_layers && supports_compute(format, usage);
+
+        if (!chain._uses_compute) {
+            VkFormatProperties props{};
+            vkGetPhysicalDeviceFormatProperties(_physical_device, format, &props);
+            chain._blit_filter = (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+                ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+            return chain;
+        }
+
+        auto view_ci = [&](uint32_t level) {
+            return ImageViewCreateInfo{}
+                .set_image(image)
+                .set_view_type(VK_IMAGE_VIEW_TYPE_2D_ARRAY)
+                .set_format(format)
+                .set_subresource_range(ImageSubresourceRange::color()
+                    .set_base_mip_level(level)
+                    .set_layer_count(array_layers)
+                    .to_vk())
+                .to_vk();
+        };
+        chain._sampled_view = ImageView(_device, view_ci(0));
+        for (uint32_t level = 1; level < mip_levels; ++level) {
+            chain._storage_views.emplace_back(_device, view_ci(level));
+        }
+        return chain;
+    }
+
+    // Mip 0 must hold the source texels in base_layout; every level ends in
+    // final_layout, visible to dst_stage/dst_access. Compute chains record
+    // through the encoder's push descriptor function.
+    void generate(CommandEncoder& encoder, const MipChain& chain, VkImageLayout base_layout, VkImageLayout final_layout,
+        VkPipelineStageFlags2 dst_stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VkAccessFlags2 dst_access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT)
+    {
+        if (chain.mip_levels() <= 1) {
+            VkImageMemoryBarrier2 barrier = _barrier(chain, 0, 1, base_layout, final_layout,
+                VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT, dst_stage, dst_access);
+            encoder.pipeline_barrier(DependencyInfo{}.set_image_barriers(1, &barrier).to_vk());
+            return;
+        }
+        if (chain.uses_compute()) {
+            _generate_compute(encoder, chain, base_layout, final_layout, dst_stage, dst_access);
+        } else {
+            _generate_blit(encoder, chain, base_layout, final_layout, dst_stage, dst_access);
+        }
+    }
+
+private:
+    struct PushConstants {
+        uint32_t mip_count;
+        uint32_t workgroup_count;
+        float inv_size[2];
+        uint32_t group_count[2];
+    };
+
+    static VkImageMemoryBarrier2 _barrier(const MipChain& chain, uint32_t base_level, uint32_t level_count,
+        VkImageLayout old_layout, VkImageLayout new_layout,
+        VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access, VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access)
+    {
+        return ImageMemoryBarrier2{}
+            .set_src_stage(src_stage)
+            .set_src_access(src_access)
+            .set_dst_stage(dst_stage)
+            .set_dst_access(dst_access)
+            .set_old_layout(old_layout)
+            .set_new_layout(new_layout)
+            .set_image(chain.image())
+            .set_aspect(VK_IMAGE_ASPECT_COLOR_BIT)
+            .set_levels(base_level, level_count)
+            .set_layers(0, chain.array_layers())
+            .to_vk();
+    }
+
+    void _generate_compute(CommandEncoder& encoder, const MipChain& chain, VkImageLayout base_layout, VkImageLayout final_layout,
+        VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access)
+    {
+        const uint32_t levels = chain.mip_levels();
+
+        // previous generate() calls may still be using the counters and mip 6 buffer
+        VkMemoryBarrier2 reuse = MemoryBarrier2{}
+            .set_src_stage(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+            .set_src_access(VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)
+            .set_dst_stage(VK_PIPELINE_STAGE_2_CLEAR_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+            .set_dst_access(VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)
+            .to_vk();
+        VkImageMemoryBarrier2 before[2] = {
+            _barrier(chain, 0, 1, base_layout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT),
+            _barrier(chain, 1, levels - 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT),
+        };
+        encoder.pipeline_barrier(DependencyInfo{}
+            .set_memory_barriers(1, &reuse)
+            .set_image_barriers(2, before)
+            .to_vk());
+
+        encoder.fill_buffer(_counter_buffer.handle(), 0, VK_WHOLE_SIZE, 0);
+        VkMemoryBarrier2 cleared = MemoryBarrier2{}
+            .set_src_stage(VK_PIPELINE_STAGE_2_CLEAR_BIT)
+            .set_src_access(VK_ACCESS_2_TRANSFER_WRITE_BIT)
+            .set_dst_stage(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+            .set_dst_access(VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)
+            .to_vk();
+        encoder.pipeline_barrier(DependencyInfo{}.set_memory_barriers(1, &cleared).to_vk());
+
+        VkDescriptorImageInfo source{ _sampler.handle(), chain._sampled_view.handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        // every element must be valid; levels past the chain repeat the last view and are never written
+        std::array<VkDescriptorImageInfo, MAX_COMPUTE_MIPS> destinations{};
+        for (uint32_t i = 0; i < MAX_COMPUTE_MIPS; ++i) {
+            const ImageView& view = chain._storage_views[std::min<size_t>(i, chain._storage_views.size() - 1)];
+            destinations[i] = VkDescriptorImageInfo{ VK_NULL_HANDLE, view.handle(), VK_IMAGE_LAYOUT_GENERAL };
+        }
+        VkDescriptorBufferInfo mip6{ _mip6_buffer.handle(), 0, VK_WHOLE_SIZE };
+        VkDescriptorBufferInfo counters{ _counter_buffer.handle(), 0, VK_WHOLE_SIZE };
+
+        VkWriteDescriptorSet writes[4]{};
+        for (uint32_t i = 0; i < 4; ++i) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+        }
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &source;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].descriptorCount = MAX_COMPUTE_MIPS;
+        writes[1].pImageInfo = destinations.data();
+        writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[2].pBufferInfo = &mip6;
+        writes[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[3].pBufferInfo = &counters;
+
+        VkExtent2D extent = chain.extent();
+        uint32_t groups_x = (extent.width + TILE_SIZE - 1) / TILE_SIZE;
+        uint32_t groups_y = (extent.height + TILE_SIZE - 1) / TILE_SIZE;
+        PushConstants constants{};
+        constants.mip_count = levels - 1;
+        constants.workgroup_count = groups_x * groups_y;
+        constants.inv_size[0] = 1.0f / float(extent.width);
+        constants.inv_size[1] = 1.0f / float(extent.height);
+        constants.group_count[0] = groups_x;
+        constants.group_count[1] = groups_y;
+
+        encoder.bind_pipeline(VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline.handle())
+               .push_descriptor_set(VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline_layout.handle(), 0, 4, writes)
+               .push_constants(_pipeline_layout.handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants)
+               .dispatch(groups_x, groups_y, chain.array_layers());
+
+        VkImageMemoryBarrier2 after[2] = {
+            _barrier(chain, 0, 1, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, final_layout,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE, dst_stage, dst_access),
+            _barrier(chain, 1, levels - 1, VK_IMAGE_LAYOUT_GENERAL, final_layout,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, dst_stage, dst_access),
+        };
+        encoder.pipeline_barrier(DependencyInfo{}.set_image_barriers(2, after).to_vk());
+    }
+
+    void _generate_blit(CommandEncoder& encoder, const MipChain& chain, VkImageLayout base_layout, VkImageLayout final_layout,
+        VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access)
+    {
+        const uint32_t levels = chain.mip_levels();
+
+        VkImageMemoryBarrier2 before[2] = {
+            _barrier(chain, 0, 1, base_layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT),
+            _barrier(chain, 1, levels - 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT),
+        };
+        encoder.pipeline_barrier(DependencyInfo{}.set_image_barriers(2, before).to_vk());
+
+        int32_t width = static_cast<int32_t>(chain.extent().width);
+        int32_t height = static_cast<int32_t>(chain.extent().height);
+        for (uint32_t level = 1; level < levels; ++level) {
+            if (level > 1) {
+                VkImageMemoryBarrier2 written = _barrier(chain, level - 1, 1,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+                encoder.pipeline_barrier(DependencyInfo{}.set_image_barriers(1, &written).to_vk());
+            }
+
+            int32_t next_width = std::max(width / 2, 1);
+            int32_t next_height = std::max(height / 2, 1);
+
+            VkImageBlit2 region{};
+            region.sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2;
+            region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, chain.array_layers() };
+            region.srcOffsets[1] = { width, height, 1 };
+            region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, chain.array_layers() };
+            region.dstOffsets[1] = { next_width, next_height, 1 };
+
+            VkBlitImageInfo2 blit{};
+            blit.sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2;
+            blit.srcImage = chain.image();
+            blit.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            blit.dstImage = chain.image();
+            blit.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            blit.regionCount = 1;
+            blit.pRegions = &region;
+            blit.filter = chain._blit_filter;
+            encoder.blit_image(blit);
+
+            width = next_width;
+            height = next_height;
+        }
+
+        VkImageMemoryBarrier2 after[2] = {
+            _barrier(chain, 0, levels - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, final_layout,
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_NONE, dst_stage, dst_access),
+            _barrier(chain, levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, final_layout,
+                VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, dst_stage, dst_access),
+        };
+        encoder.pipeline_barrier(DependencyInfo{}.set_image_barriers(2, after).to_vk());
+    }
+
+    VkDevice _device = VK_NULL_HANDLE;
+    VkPhysicalDevice _physical_device = VK_NULL_HANDLE;
+    uint32_t _max_array_layers = 0;
+
+    Sampler _sampler;
+    DescriptorSetLayout _set_layout;
+    PipelineLayout _pipeline_layout;
+    Pipeline _pipeline;
+    Buffer _mip6_buffer;
+    Buffer _counter_buffer;
+};
+
+}
+
+#endif
@@ -53,6 +53,7 @@ public:
     }
 
     const VkPhysicalDevice& handle() const { return _handle; }
+    const VkPhysicalDeviceProperties& properties() const { return _properties; }
     const VkPhysicalDeviceFeatures& features() const { return _features; }
     const VkPhysicalDeviceFeatures2& features2() const { return _features2; }
     const std::vector<const char*>& extensions() const { return _extensions; }
@@ -88,6 +89,160 @@ private:
     const VkPhysicalDeviceFeatures* _features = nullptr;
 };
 
+class PhysicalDeviceDynamicRenderingFeatures {
+public:
+    PhysicalDeviceDynamicRenderingFeatures& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceDynamicRenderingFeatures& set_dynamic_rendering(VkBool32 b) { _dynamic_rendering = b; return *this; }
+
+    VkPhysicalDeviceDynamicRenderingFeatures to_vk() const {
+        VkPhysicalDeviceDynamicRenderingFeatures f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        f.pNext = _p_next;
+        f.dynamicRendering = _dynamic_rendering;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _dynamic_rendering = VK_FALSE;
+};
+
+class PhysicalDeviceSynchronization2Features {
+public:
+    PhysicalDeviceSynchronization2Features& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceSynchronization2Features& set_synchronization2(VkBool32 b) { _synchronization2 = b; return *this; }
+
+    VkPhysicalDeviceSynchronization2Features to_vk() const {
+        VkPhysicalDeviceSynchronization2Features f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+        f.pNext = _p_next;
+        f.synchronization2 = _synchronization2;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _synchronization2 = VK_FALSE;
+};
+
+class PhysicalDeviceDescriptorIndexingFeatures {
+public:
+    PhysicalDeviceDescriptorIndexingFeatures& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_shader_sampled_image_array_non_uniform_indexing(VkBool32 b) { _f.shaderSampledImageArrayNonUniformIndexing = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_shader_storage_buffer_array_non_uniform_indexing(VkBool32 b) { _f.shaderStorageBufferArrayNonUniformIndexing = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_shader_storage_image_array_non_uniform_indexing(VkBool32 b) { _f.shaderStorageImageArrayNonUniformIndexing = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_descriptor_binding_sampled_image_update_after_bind(VkBool32 b) { _f.descriptorBindingSampledImageUpdateAfterBind = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_descriptor_binding_storage_image_update_after_bind(VkBool32 b) { _f.descriptorBindingStorageImageUpdateAfterBind = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_descriptor_binding_storage_buffer_update_after_bind(VkBool32 b) { _f.descriptorBindingStorageBufferUpdateAfterBind = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_descriptor_binding_update_unused_while_pending(VkBool32 b) { _f.descriptorBindingUpdateUnusedWhilePending = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_descriptor_binding_partially_bound(VkBool32 b) { _f.descriptorBindingPartiallyBound = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_descriptor_binding_variable_descriptor_count(VkBool32 b) { _f.descriptorBindingVariableDescriptorCount = b; return *this; }
+    PhysicalDeviceDescriptorIndexingFeatures& set_runtime_descriptor_array(VkBool32 b) { _f.runtimeDescriptorArray = b; return *this; }
+
+    VkPhysicalDeviceDescriptorIndexingFeatures to_vk() const {
+        VkPhysicalDeviceDescriptorIndexingFeatures f = _f;
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        f.pNext = _p_next;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkPhysicalDeviceDescriptorIndexingFeatures _f{};
+};
+
+class PhysicalDeviceDescriptorBufferFeatures {
+public:
+    PhysicalDeviceDescriptorBufferFeatures& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceDescriptorBufferFeatures& set_descriptor_buffer(VkBool32 b) { _descriptor_buffer = b; return *this; }
+    PhysicalDeviceDescriptorBufferFeatures& set_descriptor_buffer_push_descriptors(VkBool32 b) { _descriptor_buffer_push_descriptors = b; return *this; }
+
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT to_vk() const {
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+        f.pNext = _p_next;
+        f.descriptorBuffer = _descriptor_buffer;
+        f.descriptorBufferPushDescriptors = _descriptor_buffer_push_descriptors;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _descriptor_buffer = VK_FALSE;
+    VkBool32 _descriptor_buffer_push_descriptors = VK_FALSE;
+};
+
+class PhysicalDeviceExtendedDynamicStateFeatures {
+public:
+    PhysicalDeviceExtendedDynamicStateFeatures& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceExtendedDynamicStateFeatures& set_extended_dynamic_state(VkBool32 b) { _extended_dynamic_state = b; return *this; }
+
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT to_vk() const {
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+        f.pNext = _p_next;
+        f.extendedDynamicState = _extended_dynamic_state;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _extended_dynamic_state = VK_FALSE;
+};
+
+class PhysicalDeviceExtendedDynamicState2Features {
+public:
+    PhysicalDeviceExtendedDynamicState2Features& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceExtendedDynamicState2Features& set_extended_dynamic_state2(VkBool32 b) { _extended_dynamic_state2 = b; return *this; }
+    PhysicalDeviceExtendedDynamicState2Features& set_logic_op(VkBool32 b) { _logic_op = b; return *this; }
+    PhysicalDeviceExtendedDynamicState2Features& set_patch_control_points(VkBool32 b) { _patch_control_points = b; return *this; }
+
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT to_vk() const {
+        VkPhysicalDeviceExtendedDynamicState2FeaturesEXT f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT;
+        f.pNext = _p_next;
+        f.extendedDynamicState2 = _extended_dynamic_state2;
+        f.extendedDynamicState2LogicOp = _logic_op;
+        f.extendedDynamicState2PatchControlPoints = _patch_control_points;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _extended_dynamic_state2 = VK_FALSE;
+    VkBool32 _logic_op = VK_FALSE;
+    VkBool32 _patch_control_points = VK_FALSE;
+};
+
+class PhysicalDeviceExtendedDynamicState3Features {
+public:
+    PhysicalDeviceExtendedDynamicState3Features& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_tessellation_domain_origin(VkBool32 b) { _f.extendedDynamicState3TessellationDomainOrigin = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_depth_clamp_enable(VkBool32 b) { _f.extendedDynamicState3DepthClampEnable = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_polygon_mode(VkBool32 b) { _f.extendedDynamicState3PolygonMode = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_rasterization_samples(VkBool32 b) { _f.extendedDynamicState3RasterizationSamples = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_sample_mask(VkBool32 b) { _f.extendedDynamicState3SampleMask = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_alpha_to_coverage_enable(VkBool32 b) { _f.extendedDynamicState3AlphaToCoverageEnable = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_alpha_to_one_enable(VkBool32 b) { _f.extendedDynamicState3AlphaToOneEnable = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_logic_op_enable(VkBool32 b) { _f.extendedDynamicState3LogicOpEnable = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_color_blend_enable(VkBool32 b) { _f.extendedDynamicState3ColorBlendEnable = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_color_blend_equation(VkBool32 b) { _f.extendedDynamicState3ColorBlendEquation = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_color_write_mask(VkBool32 b) { _f.extendedDynamicState3ColorWriteMask = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_depth_clip_enable(VkBool32 b) { _f.extendedDynamicState3DepthClipEnable = b; return *this; }
+    PhysicalDeviceExtendedDynamicState3Features& set_line_rasterization_mode(VkBool32 b) { _f.extendedDynamicState3LineRasterizationMode = b; return *this; }
+
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT to_vk() const {
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT f = _f;
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+        f.pNext = _p_next;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT _f{};
+};
+
 class PhysicalDeviceProperties2 {
 public:
     PhysicalDeviceProperties2& set_p_next(void* p_next) {
@@ -2,24 +2,60 @@
 #define wulkan_wk_PIPELINE_HPP
 
 #include "wulkan_internal.hpp"
+#include "pipeline_feedback.hpp"
 
 #include <cstdint>
 #include <stdexcept>
 #include <iostream>
+#include <optional>
+#include <vector>
+#include <memory>
 
 namespace wk {
 
 class Pipeline {
 public:
     Pipeline() = default;
-    Pipeline(VkDevice device, const VkGraphicsPipelineCreateInfo& ci)
-        : _device(device) 
+    Pipeline(VkDevice device, const VkGraphicsPipelineCreateInfo& ci, VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+        PipelineCreationReport* p_report = nullptr, const char* label = nullptr)
+        : _device(device), _create_flags(ci.flags)
     {
-        if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &ci, nullptr, &_handle) != VK_SUCCESS) {
+        VkGraphicsPipelineCreateInfo create_info = ci;
+        std::optional<PipelineCreationFeedback> feedback;
+        if (p_report) {
+            feedback.emplace(ci.stageCount, ci.pStages);
+            create_info.pNext = feedback->chain(ci.pNext);
+        }
+        if (vkCreateGraphicsPipelines(_device, pipeline_cache, 1, &create_info, nullptr, &_handle) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline");
         }
+        if (p_report) {
+            p_report->add(feedback->record(label, VK_PIPELINE_BIND_POINT_GRAPHICS));
+        }
     }
 
+    Pipeline(VkDevice device, const VkComputePipelineCreateInfo& ci, VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+        PipelineCreationReport* p_report = nullptr, const char* label = nullptr)
+        : _device(device), _create_flags(ci.flags)
+    {
+        VkComputePipelineCreateInfo create_info = ci;
+        std::optional<PipelineCreationFeedback> feedback;
+        if (p_report) {
+            feedback.emplace(1u, &ci.stage);
+            create_info.pNext = feedback->chain(ci.pNext);
+        }
+        if (vkCreateComputePipelines(_device, pipeline_cache, 1, &create_info, nullptr, &_handle) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+        if (p_report) {
+            p_report->add(feedback->record(label, VK_PIPELINE_BIND_POINT_COMPUTE));
+        }
+    }
+
+    // Takes ownership of an already created pipeline.
+    Pipeline(VkDevice device, VkPipeline handle, VkPipelineCreateFlags create_flags = 0)
+        : _handle(handle), _device(device), _create_flags(create_flags) {}
+
     ~Pipeline() {
         if (_handle != VK_NULL_HANDLE) {
             vkDestroyPipeline(_device, _handle, nullptr);
@@ -31,7 +67,8 @@ public:
 
     Pipeline(Pipeline&& other) noexcept
         : _handle(other._handle),
-          _device(other._device)
+          _device(other._device),
+          _create_flags(other._create_flags)
     {
         other._handle = VK_NULL_HANDLE;
         other._device = VK_NULL_HANDLE;
@@ -44,6 +81,7 @@ public:
             }
             _handle = other._handle;
             _device = other._device;
+            _create_flags = other._create_flags;
             other._handle = VK_NULL_HANDLE;
             other._device = VK_NULL_HANDLE;
         }
@@ -51,11 +89,53 @@ public:
     }
 
     const VkPipeline& handle() const { return _handle; }
+    // The flags the pipeline was created with, e.g. to check how a library was built.
+    VkPipelineCreateFlags create_flags() const { return _create_flags; }
 private:
     VkPipeline _handle = VK_NULL_HANDLE;
     VkDevice _device = VK_NULL_HANDLE;
+    VkPipelineCreateFlags _create_flags = 0;
 };
 
+// Creates every pipeline in one vkCreateGraphicsPipelines call so the driver
+// can compile them in parallel and share work across the batch. Throws only
+// on errors; on a positive result (e.g. VK_PIPELINE_COMPILE_REQUIRED with
+// FAIL_ON_PIPELINE_COMPILE_REQUIRED) the pipelines the driver did not create
+// come back with a null handle.
+inline std::vector<Pipeline> CreateGraphicsPipelines(VkDevice device, uint32_t count,
+    const VkGraphicsPipelineCreateInfo* p_create_infos, VkPipelineCache pipeline_cache = VK_NULL_HANDLE,
+    PipelineCreationReport* p_report = nullptr, const char* const* p_labels = nullptr)
+{
+    std::vector<VkGraphicsPipelineCreateInfo> create_infos(p_create_infos, p_create_infos + count);
+    std::vector<std::unique_ptr<PipelineCreationFeedback>> feedback;
+    if (p_report) {
+        for (VkGraphicsPipelineCreateInfo& ci : create_infos) {
+            feedback.push_back(std::make_unique<PipelineCreationFeedback>(ci.stageCount, ci.pStages));
+            ci.pNext = feedback.back()->chain(ci.pNext);
+        }
+    }
+
+    std::vector<VkPipeline> handles(count, VK_NULL_HANDLE);
+    if (vkCreateGraphicsPipelines(device, pipeline_cache, count, create_infos.data(), nullptr, handles.data()) < VK_SUCCESS) {
+        for (VkPipeline handle : handles) {
+            if (handle != VK_NULL_HANDLE) {
+                vkDestroyPipeline(device, handle, nullptr);
+            }
+        }
+        throw std::runtime_error("failed to create graphics pipelines");
+    }
+
+    std::vector<Pipeline> pipelines;
+    pipelines.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        pipelines.emplace_back(device, handles[i], create_infos[i].flags);
+        if (p_report && handles[i] != VK_NULL_HANDLE) {
+            p_report->add(feedback[i]->record(p_labels ? p_labels[i] : nullptr, VK_PIPELINE_BIND_POINT_GRAPHICS));
+        }
+    }
+    return pipelines;
+}
+
 class Viewport {
 public:
     Viewport& set_x(float x) { _x = x; return *this; }
@@ -132,6 +212,36 @@ private:
     const VkSpecializationInfo* _p_specialization_info = nullptr;
 };
 
+class ComputePipelineCreateInfo {
+public:
+    ComputePipelineCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    ComputePipelineCreateInfo& set_flags(VkPipelineCreateFlags flags) { _flags = flags; return *this; }
+    ComputePipelineCreateInfo& set_stage(const VkPipelineShaderStageCreateInfo& stage) { _stage = stage; return *this; }
+    ComputePipelineCreateInfo& set_layout(VkPipelineLayout layout) { _layout = layout; return *this; }
+    ComputePipelineCreateInfo& set_base_pipeline_handle(VkPipeline base_pipeline_handle) { _base_pipeline_handle = base_pipeline_handle; return *this; }
+    ComputePipelineCreateInfo& set_base_pipeline_index(int32_t base_pipeline_index) { _base_pipeline_index = base_pipeline_index; return *this; }
+
+    VkComputePipelineCreateInfo to_vk() const {
+        VkComputePipelineCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        ci.pNext = _p_next;
+        ci.flags = _flags;
+        ci.stage = _stage;
+        ci.layout = _layout;
+        ci.basePipelineHandle = _base_pipeline_handle;
+        ci.basePipelineIndex = _base_pipeline_index;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkPipelineCreateFlags _flags = 0;
+    VkPipelineShaderStageCreateInfo _stage{};
+    VkPipelineLayout _layout = VK_NULL_HANDLE;
+    VkPipeline _base_pipeline_handle = VK_NULL_HANDLE;
+    int32_t _base_pipeline_index = -1;
+};
+
 class VertexInputBindingDescription {
 public:
     VertexInputBindingDescription& set_binding(uint32_t binding) { _binding = binding; return *this; }
@@ -518,6 +628,39 @@ private:
     const float* _p_blend_constants = nullptr;
 };
 
+class PipelineRenderingCreateInfo {
+public:
+    PipelineRenderingCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    PipelineRenderingCreateInfo& set_view_mask(uint32_t view_mask) { _view_mask = view_mask; return *this; }
+    PipelineRenderingCreateInfo& set_color_attachment_formats(uint32_t count, const VkFormat* p_formats) {
+        _color_attachment_count = count;
+        _p_color_attachment_formats = p_formats;
+        return *this;
+    }
+    PipelineRenderingCreateInfo& set_depth_attachment_format(VkFormat format) { _depth_attachment_format = format; return *this; }
+    PipelineRenderingCreateInfo& set_stencil_attachment_format(VkFormat format) { _stencil_attachment_format = format; return *this; }
+
+    VkPipelineRenderingCreateInfo to_vk() const {
+        VkPipelineRenderingCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+        ci.pNext = _p_next;
+        ci.viewMask = _view_mask;
+        ci.colorAttachmentCount = _color_attachment_count;
+        ci.pColorAttachmentFormats = _p_color_attachment_formats;
+        ci.depthAttachmentFormat = _depth_attachment_format;
+        ci.stencilAttachmentFormat = _stencil_attachment_format;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    uint32_t _view_mask = 0;
+    uint32_t _color_attachment_count = 0;
+    const VkFormat* _p_color_attachment_formats = nullptr;
+    VkFormat _depth_attachment_format = VK_FORMAT_UNDEFINED;
+    VkFormat _stencil_attachment_format = VK_FORMAT_UNDEFINED;
+};
+
 class PipelineCreateInfo {
 public:
     PipelineCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
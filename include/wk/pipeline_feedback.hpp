@@ -0,0 +1,164 @@
+#ifndef wulkan_wk_PIPELINE_FEEDBACK_HPP
+#define wulkan_wk_PIPELINE_FEEDBACK_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+
+namespace wk {
+
+struct PipelineStageFeedback {
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+    bool valid = false;
+    bool cache_hit = false;
+    uint64_t duration_ns = 0;
+};
+
+struct PipelineFeedbackRecord {
+    std::string label;
+    VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    bool valid = false;     // the driver filled in the feedback at all
+    bool cache_hit = false; // served from the application pipeline cache
+    uint64_t duration_ns = 0;
+    std::vector<PipelineStageFeedback> stages;
+};
+
+// Feedback storage for a single pipeline creation. chain() links it in front
+// of the create info's pNext; read it back with record() once creation returns.
+class PipelineCreationFeedback {
+public:
+    PipelineCreationFeedback(uint32_t stage_count, const VkPipelineShaderStageCreateInfo* p_stages)
+        : _stages(stage_count)
+    {
+        for (uint32_t i = 0; i < stage_count; ++i) {
+            _stages[i].stage = p_stages[i].stage;
+        }
+        _stage_feedback.resize(stage_count);
+        _ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+        _ci.pPipelineCreationFeedback = &_feedback;
+        _ci.pipelineStageCreationFeedbackCount = stage_count;
+        _ci.pPipelineStageCreationFeedbacks = _stage_feedback.data();
+    }
+
+    PipelineCreationFeedback(const PipelineCreationFeedback&) = delete;
+    PipelineCreationFeedback& operator=(const PipelineCreationFeedback&) = delete;
+
+    const void* chain(const void* p_next) {
+        _ci.pNext = p_next;
+        return &_ci;
+    }
+
+    PipelineFeedbackRecord record(const char* label, VkPipelineBindPoint bind_point) const {
+        PipelineFeedbackRecord r;
+        r.label = label ? label : "";
+        r.bind_point = bind_point;
+        r.valid = (_feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0;
+        r.cache_hit = (_feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+        r.duration_ns = _feedback.duration;
+        r.stages = _stages;
+        for (size_t i = 0; i < _stages.size(); ++i) {
+            r.stages[i].valid = (_stage_feedback[i].flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0;
+            r.stages[i].cache_hit = (_stage_feedback[i].flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0;
+            r.stages[i].duration_ns = _stage_feedback[i].duration;
+        }
+        return r;
+    }
+
+private:
+    VkPipelineCreationFeedbackCreateInfo _ci{};
+    VkPipelineCreationFeedback _feedback{};
+    std::vector<VkPipelineCreationFeedback> _stage_feedback;
+    std::vector<PipelineStageFeedback> _stages;
+};
+
+struct PipelineFeedbackTotals {
+    uint32_t pipeline_count = 0;
+    uint32_t valid_count = 0; // pipelines the driver reported feedback for
+    uint32_t cache_hit_count = 0;
+    uint64_t total_duration_ns = 0;
+
+    double hit_rate() const { return valid_count ? double(cache_hit_count) / double(valid_count) : 0.0; }
+};
+
+// Thread-safe collection of creation feedback, shared by every pipeline
+// created with it so cache and warm-up work can be judged from real numbers.
+class PipelineCreationReport {
+public:
+    PipelineCreationReport() : _mutex(std::make_unique<std::mutex>()) {}
+
+    PipelineCreationReport(const PipelineCreationReport&) = delete;
+    PipelineCreationReport& operator=(const PipelineCreationReport&) = delete;
+    PipelineCreationReport(PipelineCreationReport&&) noexcept = default;
+    PipelineCreationReport& operator=(PipelineCreationReport&&) noexcept = default;
+
+    void add(PipelineFeedbackRecord record) {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _totals.pipeline_count++;
+        if (record.valid) {
+            _totals.valid_count++;
+            _totals.cache_hit_count += record.cache_hit ? 1 : 0;
+            _totals.total_duration_ns += record.duration_ns;
+        }
+        _records.push_back(std::move(record));
+    }
+
+    PipelineFeedbackTotals totals() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _totals;
+    }
+
+    std::vector<PipelineFeedbackRecord> records() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _records;
+    }
+
+    // Slowest pipelines first.
+    std::vector<PipelineFeedbackRecord> worst(size_t count) const {
+        std::vector<PipelineFeedbackRecord> out = records();
+        count = std::min(count, out.size());
+        std::partial_sort(out.begin(), out.begin() + count, out.end(),
+            [](const PipelineFeedbackRecord& a, const PipelineFeedbackRecord& b) { return a.duration_ns > b.duration_ns; });
+        out.resize(count);
+        return out;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _records.clear();
+        _totals = {};
+    }
+
+    // Formats into a local stream so the caller's stream flags are left alone.
+    void print(std::ostream& os, size_t worst_count = 5) const {
+        PipelineFeedbackTotals t = totals();
+        std::ostringstream ss;
+        ss << "pipelines: " << t.pipeline_count
+           << " (feedback for " << t.valid_count << ")"
+           << ", total " << std::fixed << std::setprecision(2) << t.total_duration_ns / 1e6 << " ms"
+           << ", cache hit rate " << std::setprecision(1) << t.hit_rate() * 100.0 << "%\n";
+        for (const PipelineFeedbackRecord& r : worst(worst_count)) {
+            ss << "  " << std::setprecision(2) << r.duration_ns / 1e6 << " ms"
+               << (r.cache_hit ? " [hit] " : " [miss] ")
+               << (r.label.empty() ? "<unnamed>" : r.label) << "\n";
+        }
+        os << ss.str() << std::flush;
+    }
+
+private:
+    std::unique_ptr<std::mutex> _mutex;
+    std::vector<PipelineFeedbackRecord> _records;
+    PipelineFeedbackTotals _totals;
+};
+
+}
+
+#endif
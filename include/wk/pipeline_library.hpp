@@ -0,0 +1,435 @@
+#ifndef wulkan_wk_PIPELINE_LIBRARY_HPP
+#define wulkan_wk_PIPELINE_LIBRARY_HPP
+
+#include "wulkan_internal.hpp"
+#include "pipeline.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <future>
+#include <chrono>
+
+namespace wk {
+
+// Every library part is created with these so it can be relinked with
+// link-time optimization later.
+constexpr VkPipelineCreateFlags GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS =
+    VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+// Graphics pipeline assembled from VK_EXT_graphics_pipeline_library parts.
+// The fast-linked pipeline is available immediately; when requested, an
+// optimized relink runs on a background thread and replaces it once ready.
+// The library pipelines must outlive the background link, and for the
+// optimized relink must have been created with
+// GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS (the part builders below do this).
+class LinkedPipeline {
+public:
+    LinkedPipeline() = default;
+
+    // Checks that every part was created as a library, and with the link-time
+    // optimization info retained when optimizing in the background.
+    LinkedPipeline(VkDevice device, const std::vector<const Pipeline*>& libraries, VkPipelineLayout layout,
+        VkPipelineCache pipeline_cache = VK_NULL_HANDLE, bool optimize_in_background = true)
+        : LinkedPipeline(device, static_cast<uint32_t>(libraries.size()), _library_handles(libraries, optimize_in_background).data(),
+            layout, pipeline_cache, optimize_in_background) {}
+
+    LinkedPipeline(VkDevice device, uint32_t library_count, const VkPipeline* p_libraries, VkPipelineLayout layout,
+        VkPipelineCache pipeline_cache = VK_NULL_HANDLE, bool optimize_in_background = true)
+        : _device(device)
+    {
+        VkPipelineLibraryCreateInfoKHR li{};
+        li.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        li.libraryCount = library_count;
+        li.pLibraries = p_libraries;
+
+        VkGraphicsPipelineCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        ci.pNext = &li;
+        ci.layout = layout;
+        ci.basePipelineIndex = -1;
+
+        if (vkCreateGraphicsPipelines(_device, pipeline_cache, 1, &ci, nullptr, &_fast) != VK_SUCCESS) {
+            throw std::runtime_error("failed to link graphics pipeline library");
+        }
+
+        if (optimize_in_background) {
+            std::vector<VkPipeline> libraries(p_libraries, p_libraries + library_count);
+            _optimized_future = std::async(std::launch::async,
+                [device, libraries = std::move(libraries), layout, pipeline_cache]() {
+                    VkPipelineLibraryCreateInfoKHR li{};
+                    li.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+                    li.libraryCount = static_cast<uint32_t>(libraries.size());
+                    li.pLibraries = libraries.data();
+
+                    VkGraphicsPipelineCreateInfo ci{};
+                    ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                    ci.pNext = &li;
+                    ci.flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+                    ci.layout = layout;
+                    ci.basePipelineIndex = -1;
+
+                    // failure keeps the fast-linked pipeline in use
+                    VkPipeline pipeline = VK_NULL_HANDLE;
+                    if (vkCreateGraphicsPipelines(device, pipeline_cache, 1, &ci, nullptr, &pipeline) != VK_SUCCESS) {
+                        return static_cast<VkPipeline>(VK_NULL_HANDLE);
+                    }
+                    return pipeline;
+                });
+        }
+    }
+
+    ~LinkedPipeline() {
+        _destroy();
+    }
+
+    LinkedPipeline(const LinkedPipeline&) = delete;
+    LinkedPipeline& operator=(const LinkedPipeline&) = delete;
+
+    LinkedPipeline(LinkedPipeline&& other) noexcept
+        : _fast(other._fast),
+          _optimized(other._optimized),
+          _optimized_future(std::move(other._optimized_future)),
+          _device(other._device)
+    {
+        other._fast = VK_NULL_HANDLE;
+        other._optimized = VK_NULL_HANDLE;
+        other._device = VK_NULL_HANDLE;
+    }
+
+    LinkedPipeline& operator=(LinkedPipeline&& other) noexcept {
+        if (this != &other) {
+            _destroy();
+            _fast = other._fast;
+            _optimized = other._optimized;
+            _optimized_future = std::move(other._optimized_future);
+            _device = other._device;
+            other._fast = VK_NULL_HANDLE;
+            other._optimized = VK_NULL_HANDLE;
+            other._device = VK_NULL_HANDLE;
+        }
+        return *this;
+    }
+
+    // Returns the optimized pipeline once the background link has finished,
+    // the fast-linked one otherwise. Call from the recording thread.
+    const VkPipeline& handle() const {
+        _poll();
+        return _optimized != VK_NULL_HANDLE ? _optimized : _fast;
+    }
+
+    bool is_optimized() const {
+        _poll();
+        return _optimized != VK_NULL_HANDLE;
+    }
+
+private:
+    VkPipeline _fast = VK_NULL_HANDLE;
+    mutable VkPipeline _optimized = VK_NULL_HANDLE;
+
+    static std::vector<VkPipeline> _library_handles(const std::vector<const Pipeline*>& libraries, bool optimize_in_background) {
+        VkPipelineCreateFlags required = optimize_in_background ? GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS : VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+        std::vector<VkPipeline> handles;
+        for (const Pipeline* library : libraries) {
+            if ((library->create_flags() & required) != required) {
+                throw std::runtime_error("pipeline library part was not created with GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS");
+            }
+            handles.push_back(library->handle());
+        }
+        return handles;
+    }
+
+    mutable std::future<VkPipeline> _optimized_future;
+    VkDevice _device = VK_NULL_HANDLE;
+
+    void _poll() const {
+        if (_optimized_future.valid() &&
+            _optimized_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            _optimized = _optimized_future.get();
+        }
+    }
+
+    void _destroy() {
+        if (_optimized_future.valid()) {
+            _optimized = _optimized_future.get();
+        }
+        // the fast-linked pipeline may still be referenced by in-flight command buffers,
+        // so both are kept alive until the wrapper itself is destroyed
+        if (_optimized != VK_NULL_HANDLE) {
+            vkDestroyPipeline(_device, _optimized, nullptr);
+        }
+        if (_fast != VK_NULL_HANDLE) {
+            vkDestroyPipeline(_device, _fast, nullptr);
+        }
+        _optimized = VK_NULL_HANDLE;
+        _fast = VK_NULL_HANDLE;
+    }
+};
+
+class GraphicsPipelineLibraryCreateInfo {
+public:
+    GraphicsPipelineLibraryCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    GraphicsPipelineLibraryCreateInfo& set_flags(VkGraphicsPipelineLibraryFlagsEXT flags) { _flags = flags; return *this; }
+
+    VkGraphicsPipelineLibraryCreateInfoEXT to_vk() const {
+        VkGraphicsPipelineLibraryCreateInfoEXT ci{};
+        ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+        ci.pNext = _p_next;
+        ci.flags = _flags;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkGraphicsPipelineLibraryFlagsEXT _flags = 0;
+};
+
+// Builders for the four library parts. Each adds GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS
+// and chains the part's VkGraphicsPipelineLibraryCreateInfoEXT in front of
+// p_next; that struct lives in the builder, so keep the builder alive until
+// the pipeline is created.
+
+// Vertex input interface: vertex input and input assembly state.
+class VertexInputLibraryCreateInfo {
+public:
+    VertexInputLibraryCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    VertexInputLibraryCreateInfo& set_flags(VkPipelineCreateFlags flags) { _flags = flags; return *this; }
+    VertexInputLibraryCreateInfo& set_p_vertex_input_state(const VkPipelineVertexInputStateCreateInfo* p_vertex_input_state) { _p_vertex_input_state = p_vertex_input_state; return *this; }
+    VertexInputLibraryCreateInfo& set_p_input_assembly_state(const VkPipelineInputAssemblyStateCreateInfo* p_input_assembly_state) { _p_input_assembly_state = p_input_assembly_state; return *this; }
+    VertexInputLibraryCreateInfo& set_p_dynamic_state(const VkPipelineDynamicStateCreateInfo* p_dynamic_state) { _p_dynamic_state = p_dynamic_state; return *this; }
+
+    VkGraphicsPipelineCreateInfo to_vk() const {
+        _library_info = GraphicsPipelineLibraryCreateInfo{}
+            .set_p_next(_p_next)
+            .set_flags(VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT)
+            .to_vk();
+
+        VkGraphicsPipelineCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        ci.pNext = &_library_info;
+        ci.flags = _flags | GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS;
+        ci.pVertexInputState = _p_vertex_input_state;
+        ci.pInputAssemblyState = _p_input_assembly_state;
+        ci.pDynamicState = _p_dynamic_state;
+        ci.basePipelineIndex = -1;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkPipelineCreateFlags _flags = 0;
+    const VkPipelineVertexInputStateCreateInfo* _p_vertex_input_state = nullptr;
+    const VkPipelineInputAssemblyStateCreateInfo* _p_input_assembly_state = nullptr;
+    const VkPipelineDynamicStateCreateInfo* _p_dynamic_state = nullptr;
+    mutable VkGraphicsPipelineLibraryCreateInfoEXT _library_info{};
+};
+
+// Pre-rasterization shaders: vertex (or mesh), tessellation and geometry
+// stages with viewport, rasterization and tessellation state.
+class PreRasterizationLibraryCreateInfo {
+public:
+    PreRasterizationLibraryCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    PreRasterizationLibraryCreateInfo& set_flags(VkPipelineCreateFlags flags) { _flags = flags; return *this; }
+    PreRasterizationLibraryCreateInfo& set_stages(uint32_t count, const VkPipelineShaderStageCreateInfo* p_stages) {
+        _stage_count = count;
+        _p_stages = p_stages;
+        return *this;
+    }
+    PreRasterizationLibraryCreateInfo& set_p_tessellation_state(const VkPipelineTessellationStateCreateInfo* p_tessellation_state) { _p_tessellation_state = p_tessellation_state; return *this; }
+    PreRasterizationLibraryCreateInfo& set_p_viewport_state(const VkPipelineViewportStateCreateInfo* p_viewport_state) { _p_viewport_state = p_viewport_state; return *this; }
+    PreRasterizationLibraryCreateInfo& set_p_rasterization_state(const VkPipelineRasterizationStateCreateInfo* p_rasterization_state) { _p_rasterization_state = p_rasterization_state; return *this; }
+    PreRasterizationLibraryCreateInfo& set_p_dynamic_state(const VkPipelineDynamicStateCreateInfo* p_dynamic_state) { _p_dynamic_state = p_dynamic_state; return *this; }
+    PreRasterizationLibraryCreateInfo& set_layout(VkPipelineLayout layout) { _layout = layout; return *this; }
+    PreRasterizationLibraryCreateInfo& set_render_pass(VkRenderPass render_pass) { _render_pass = render_pass; return *this; }
+    PreRasterizationLibraryCreateInfo& set_subpass(uint32_t subpass) { _subpass = subpass; return *this; }
+
+    VkGraphicsPipelineCreateInfo to_vk() const {
+        _library_info = GraphicsPipelineLibraryCreateInfo{}
+            .set_p_next(_p_next)
+            .set_flags(VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)
+            .to_vk();
+
+        VkGraphicsPipelineCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        ci.pNext = &_library_info;
+        ci.flags = _flags | GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS;
+        ci.stageCount = _stage_count;
+        ci.pStages = _p_stages;
+        ci.pTessellationState = _p_tessellation_state;
+        ci.pViewportState = _p_viewport_state;
+        ci.pRasterizationState = _p_rasterization_state;
+        ci.pDynamicState = _p_dynamic_state;
+        ci.layout = _layout;
+        ci.renderPass = _render_pass;
+        ci.subpass = _subpass;
+        ci.basePipelineIndex = -1;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkPipelineCreateFlags _flags = 0;
+    uint32_t _stage_count = 0;
+    const VkPipelineShaderStageCreateInfo* _p_stages = nullptr;
+    const VkPipelineTessellationStateCreateInfo* _p_tessellation_state = nullptr;
+    const VkPipelineViewportStateCreateInfo* _p_viewport_state = nullptr;
+    const VkPipelineRasterizationStateCreateInfo* _p_rasterization_state = nullptr;
+    const VkPipelineDynamicStateCreateInfo* _p_dynamic_state = nullptr;
+    VkPipelineLayout _layout = VK_NULL_HANDLE;
+    VkRenderPass _render_pass = VK_NULL_HANDLE;
+    uint32_t _subpass = 0;
+    mutable VkGraphicsPipelineLibraryCreateInfoEXT _library_info{};
+};
+
+// Fragment shader: the fragment stage with depth/stencil and multisample state.
+class FragmentShaderLibraryCreateInfo {
+public:
+    FragmentShaderLibraryCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    FragmentShaderLibraryCreateInfo& set_flags(VkPipelineCreateFlags flags) { _flags = flags; return *this; }
+    FragmentShaderLibraryCreateInfo& set_stages(uint32_t count, const VkPipelineShaderStageCreateInfo* p_stages) {
+        _stage_count = count;
+        _p_stages = p_stages;
+        return *this;
+    }
+    FragmentShaderLibraryCreateInfo& set_p_multisample_state(const VkPipelineMultisampleStateCreateInfo* p_multisample_state) { _p_multisample_state = p_multisample_state; return *this; }
+    FragmentShaderLibraryCreateInfo& set_p_depth_stencil_state(const VkPipelineDepthStencilStateCreateInfo* p_depth_stencil_state) { _p_depth_stencil_state = p_depth_stencil_state; return *this; }
+    FragmentShaderLibraryCreateInfo& set_p_dynamic_state(const VkPipelineDynamicStateCreateInfo* p_dynamic_state) { _p_dynamic_state = p_dynamic_state; return *this; }
+    FragmentShaderLibraryCreateInfo& set_layout(VkPipelineLayout layout) { _layout = layout; return *this; }
+    FragmentShaderLibraryCreateInfo& set_render_pass(VkRenderPass render_pass) { _render_pass = render_pass; return *this; }
+    FragmentShaderLibraryCreateInfo& set_subpass(uint32_t subpass) { _subpass = subpass; return *this; }
+
+    VkGraphicsPipelineCreateInfo to_vk() const {
+        _library_info = GraphicsPipelineLibraryCreateInfo{}
+            .set_p_next(_p_next)
+            .set_flags(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)
+            .to_vk();
+
+        VkGraphicsPipelineCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        ci.pNext = &_library_info;
+        ci.flags = _flags | GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS;
+        ci.stageCount = _stage_count;
+        ci.pStages = _p_stages;
+        ci.pMultisampleState = _p_multisample_state;
+        ci.pDepthStencilState = _p_depth_stencil_state;
+        ci.pDynamicState = _p_dynamic_state;
+        ci.layout = _layout;
+        ci.renderPass = _render_pass;
+        ci.subpass = _subpass;
+        ci.basePipelineIndex = -1;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkPipelineCreateFlags _flags = 0;
+    uint32_t _stage_count = 0;
+    const VkPipelineShaderStageCreateInfo* _p_stages = nullptr;
+    const VkPipelineMultisampleStateCreateInfo* _p_multisample_state = nullptr;
+    const VkPipelineDepthStencilStateCreateInfo* _p_depth_stencil_state = nullptr;
+    const VkPipelineDynamicStateCreateInfo* _p_dynamic_state = nullptr;
+    VkPipelineLayout _layout = VK_NULL_HANDLE;
+    VkRenderPass _render_pass = VK_NULL_HANDLE;
+    uint32_t _subpass = 0;
+    mutable VkGraphicsPipelineLibraryCreateInfoEXT _library_info{};
+};
+
+// Fragment output interface: color blend and multisample state plus the
+// attachment formats (chain a VkPipelineRenderingCreateInfo for dynamic rendering).
+class FragmentOutputLibraryCreateInfo {
+public:
+    FragmentOutputLibraryCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    FragmentOutputLibraryCreateInfo& set_flags(VkPipelineCreateFlags flags) { _flags = flags; return *this; }
+    FragmentOutputLibraryCreateInfo& set_p_multisample_state(const VkPipelineMultisampleStateCreateInfo* p_multisample_state) { _p_multisample_state = p_multisample_state; return *this; }
+    FragmentOutputLibraryCreateInfo& set_p_color_blend_state(const VkPipelineColorBlendStateCreateInfo* p_color_blend_state) { _p_color_blend_state = p_color_blend_state; return *this; }
+    FragmentOutputLibraryCreateInfo& set_p_dynamic_state(const VkPipelineDynamicStateCreateInfo* p_dynamic_state) { _p_dynamic_state = p_dynamic_state; return *this; }
+    FragmentOutputLibraryCreateInfo& set_render_pass(VkRenderPass render_pass) { _render_pass = render_pass; return *this; }
+    FragmentOutputLibraryCreateInfo& set_subpass(uint32_t subpass) { _subpass = subpass; return *this; }
+
+    VkGraphicsPipelineCreateInfo to_vk() const {
+        _library_info = GraphicsPipelineLibraryCreateInfo{}
+            .set_p_next(_p_next)
+            .set_flags(VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT)
+            .to_vk();
+
+        VkGraphicsPipelineCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        ci.pNext = &_library_info;
+        ci.flags = _flags | GRAPHICS_PIPELINE_LIBRARY_PART_FLAGS;
+        ci.pMultisampleState = _p_multisample_state;
+        ci.pColorBlendState = _p_color_blend_state;
+        ci.pDynamicState = _p_dynamic_state;
+        ci.renderPass = _render_pass;
+        ci.subpass = _subpass;
+        ci.basePipelineIndex = -1;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkPipelineCreateFlags _flags = 0;
+    const VkPipelineMultisampleStateCreateInfo* _p_multisample_state = nullptr;
+    const VkPipelineColorBlendStateCreateInfo* _p_color_blend_state = nullptr;
+    const VkPipelineDynamicStateCreateInfo* _p_dynamic_state = nullptr;
+    VkRenderPass _render_pass = VK_NULL_HANDLE;
+    uint32_t _subpass = 0;
+    mutable VkGraphicsPipelineLibraryCreateInfoEXT _library_info{};
+};
+
+class PipelineLibraryCreateInfo {
+public:
+    PipelineLibraryCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    PipelineLibraryCreateInfo& set_libraries(uint32_t count, const VkPipeline* libs) { _library_count = count; _p_libraries = libs; return *this; }
+
+    VkPipelineLibraryCreateInfoKHR to_vk() const {
+        VkPipelineLibraryCreateInfoKHR li{};
+        li.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        li.pNext = _p_next;
+        li.libraryCount = _library_count;
+        li.pLibraries = _p_libraries;
+        return li;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    uint32_t _library_count = 0;
+    const VkPipeline* _p_libraries = nullptr;
+};
+
+class PhysicalDeviceGraphicsPipelineLibraryFeatures {
+public:
+    PhysicalDeviceGraphicsPipelineLibraryFeatures& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceGraphicsPipelineLibraryFeatures& set_graphics_pipeline_library(VkBool32 b) { _graphics_pipeline_library = b; return *this; }
+
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT to_vk() const {
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+        f.pNext = _p_next;
+        f.graphicsPipelineLibrary = _graphics_pipeline_library;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _graphics_pipeline_library = VK_FALSE;
+};
+
+class PhysicalDeviceGraphicsPipelineLibraryProperties {
+public:
+    PhysicalDeviceGraphicsPipelineLibraryProperties& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+
+    VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT to_vk() const {
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT p{};
+        p.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+        p.pNext = _p_next;
+        return p;
+    }
+
+private:
+    void* _p_next = nullptr;
+};
+
+}
+
+#endif
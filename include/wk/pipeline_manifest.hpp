@@ -0,0 +1,212 @@
+#ifndef wulkan_wk_PIPELINE_MANIFEST_HPP
+#define wulkan_wk_PIPELINE_MANIFEST_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <algorithm>
+#include <string>
+
+namespace wk {
+
+// One pipeline the application asked for. The key is whatever compact,
+// self-contained description the application builds its pipelines from
+// (material id, permutation bits, ...); kind tells apart different key types.
+struct PipelineManifestEntry {
+    uint32_t kind = 0;
+    std::vector<uint8_t> key;
+
+    template<typename T>
+    T as() const {
+        static_assert(std::is_trivially_copyable_v<T>, "manifest keys must be trivially copyable");
+        if (key.size() != sizeof(T)) {
+            throw std::runtime_error("pipeline manifest key size mismatch");
+        }
+        T value;
+        std::memcpy(&value, key.data(), sizeof(T));
+        return value;
+    }
+
+    bool operator<(const PipelineManifestEntry& other) const {
+        return kind != other.kind ? kind < other.kind : key < other.key;
+    }
+};
+
+// Deduplicated log of the pipelines used in a session, saved at shutdown and
+// replayed by PipelineWarmup on the next launch. Recording is thread-safe.
+class PipelineManifest {
+public:
+    PipelineManifest() : _mutex(std::make_unique<std::mutex>()) {}
+
+    PipelineManifest(const PipelineManifest&) = delete;
+    PipelineManifest& operator=(const PipelineManifest&) = delete;
+    PipelineManifest(PipelineManifest&&) noexcept = default;
+    PipelineManifest& operator=(PipelineManifest&&) noexcept = default;
+
+    void record(uint32_t kind, std::span<const uint8_t> key) {
+        PipelineManifestEntry entry{ kind, std::vector<uint8_t>(key.begin(), key.end()) };
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _entries.insert(std::move(entry));
+    }
+
+    template<typename T>
+    void record(uint32_t kind, const T& key) {
+        static_assert(std::is_trivially_copyable_v<T>, "manifest keys must be trivially copyable");
+        record(kind, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&key), sizeof(T)));
+    }
+
+    std::vector<PipelineManifestEntry> entries() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return std::vector<PipelineManifestEntry>(_entries.begin(), _entries.end());
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _entries.size();
+    }
+
+    // Merges entries from a previous session; false if the file is missing or not a manifest.
+    bool load(const char* path);
+    void save(const char* path) const;
+
+private:
+    std::unique_ptr<std::mutex> _mutex;
+    std::set<PipelineManifestEntry> _entries;
+};
+
+// An entry whose callback threw, with the exception's message.
+struct PipelineWarmupFailure {
+    PipelineManifestEntry entry;
+    std::string message;
+};
+
+// Replays manifest entries on background threads. The callback creates (or
+// just pre-caches through a VkPipelineCache) the pipeline for one entry and
+// must be safe to call concurrently; exceptions count as failed entries and
+// are reported through wait() and failures().
+class PipelineWarmup {
+public:
+    using CreateFn = std::function<void(const PipelineManifestEntry&)>;
+
+    PipelineWarmup() = default;
+    PipelineWarmup(std::vector<PipelineManifestEntry> entries, uint32_t thread_count, CreateFn create)
+        : _state(std::make_shared<State>())
+    {
+        _state->entries = std::move(entries);
+        _state->create = std::move(create);
+        thread_count = std::max(1u, std::min(thread_count, static_cast<uint32_t>(_state->entries.size())));
+        if (_state->entries.empty()) {
+            return;
+        }
+        _state->running = thread_count;
+        for (uint32_t i = 0; i < thread_count; ++i) {
+            _threads.emplace_back([state = _state] {
+                _run(*state);
+                state->running--;
+            });
+        }
+    }
+
+    // Abandons the entries not started yet, so destruction only waits for
+    // the compiles in progress.
+    ~PipelineWarmup() {
+        cancel();
+        wait();
+    }
+
+    PipelineWarmup(const PipelineWarmup&) = delete;
+    PipelineWarmup& operator=(const PipelineWarmup&) = delete;
+
+    PipelineWarmup(PipelineWarmup&& other) noexcept
+        : _state(std::move(other._state)),
+          _threads(std::move(other._threads)) {}
+
+    PipelineWarmup& operator=(PipelineWarmup&& other) noexcept {
+        if (this != &other) {
+            cancel();
+            wait();
+            _state = std::move(other._state);
+            _threads = std::move(other._threads);
+        }
+        return *this;
+    }
+
+    uint32_t total() const { return _state ? static_cast<uint32_t>(_state->entries.size()) : 0; }
+    uint32_t completed() const { return _state ? _state->completed.load() : 0; }
+    uint32_t failed() const { return _state ? _state->failed.load() : 0; }
+    // True once every worker has stopped, whether finished or cancelled.
+    bool done() const { return !_state || _state->running.load() == 0; }
+
+    // Stops handing out new entries; entries already being compiled still finish.
+    void cancel() {
+        if (_state) {
+            _state->cancelled = true;
+        }
+    }
+
+    // Returns false if any entry failed.
+    bool wait() {
+        for (std::thread& t : _threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        _threads.clear();
+        return failed() == 0;
+    }
+
+    std::vector<PipelineWarmupFailure> failures() const {
+        if (!_state) {
+            return {};
+        }
+        std::lock_guard<std::mutex> lock(_state->failure_mutex);
+        return _state->failures;
+    }
+
+private:
+    struct State {
+        std::vector<PipelineManifestEntry> entries;
+        CreateFn create;
+        std::atomic<uint32_t> next{ 0 };
+        std::atomic<uint32_t> completed{ 0 };
+        std::atomic<uint32_t> failed{ 0 };
+        std::atomic<bool> cancelled{ false };
+        std::atomic<uint32_t> running{ 0 }; // workers that have not returned yet
+        std::mutex failure_mutex;
+        std::vector<PipelineWarmupFailure> failures;
+    };
+
+    static void _run(State& state) {
+        while (!state.cancelled.load()) {
+            uint32_t i = state.next.fetch_add(1);
+            if (i >= state.entries.size()) {
+                return;
+            }
+            try {
+                state.create(state.entries[i]);
+                state.completed++;
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(state.failure_mutex);
+                state.failures.push_back(PipelineWarmupFailure{ state.entries[i], e.what() });
+                state.failed++;
+            }
+        }
+    }
+
+    std::shared_ptr<State> _state;
+    std::vector<std::thread> _threads;
+};
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef wulkan_wk_PRESENT_CONTROLLER_HPP
+#define wulkan_wk_PRESENT_CONTROLLER_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+namespace wk {
+
+enum class LatencyMode {
+    LowLatency, // one frame in flight, CPU start delayed towards the next vblank
+    Balanced,   // like LowLatency while frames keep up, more frames in flight when they don't
+    Throughput  // every frame in flight, MAILBOX where available
+};
+
+// Paces the render loop against the display with VK_KHR_present_id and
+// VK_KHR_present_wait. Every present is tagged with an id; wait_for_frame()
+// blocks until few enough of them are still queued for the display, which
+// bounds frames in flight by presentation rather than by GPU completion.
+// The times at which presents complete give the refresh interval and show
+// whether frames make their vblank, which drives both how long the CPU
+// sleeps before starting a frame and, in Balanced mode, how many frames are
+// kept in flight.
+//
+// Per frame: wait_for_frame() before waiting on the frame slot's fence, then
+// chain_present_id() into the present info. Pick the slot with
+// frames_in_flight(), which may change between frames, and keep per frame
+// resources (and any DeletionQueue) sized for max_frames_in_flight(). Call
+// reset() whenever the swapchain is recreated, since ids are per swapchain.
+//
+// Without present wait the controller only chooses the present mode and
+// keeps frames_in_flight() at its maximum.
+class PresentController {
+public:
+    PresentController() = default;
+    PresentController(VkDevice device, const DeviceFunctions& f, bool present_wait_enabled,
+        uint32_t max_frames_in_flight, LatencyMode mode = LatencyMode::Balanced);
+
+    void set_mode(LatencyMode mode);
+    LatencyMode mode() const { return _mode; }
+
+    // The swapchain has to be recreated with it after a mode change.
+    VkPresentModeKHR choose_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes) const;
+
+    // Blocks until the next frame may start. Returns the result of the
+    // present wait: on VK_TIMEOUT, VK_ERROR_OUT_OF_DATE_KHR or
+    // VK_ERROR_SURFACE_LOST_KHR the frame is not counted as presented and
+    // pacing is not held, so the caller decides whether to go on or wait again.
+    VkResult wait_for_frame(VkSwapchainKHR swapchain);
+
+    // Returns the chain to put in VkPresentInfoKHR::pNext, valid until the
+    // next call. Counts as a present, so call it exactly once per present.
+    const void* chain_present_id(const void* p_next = nullptr);
+
+    void reset();
+
+    bool is_present_wait_enabled() const { return _wait_for_present != nullptr; }
+    uint32_t frames_in_flight() const { return _frames_in_flight; }
+    uint32_t max_frames_in_flight() const { return _max_frames_in_flight; }
+    // Estimated from present timings; 0 until known.
+    std::chrono::nanoseconds refresh_interval() const { return _refresh_interval; }
+    // How long wait_for_frame() currently holds the CPU back after a vblank.
+    std::chrono::nanoseconds delay() const { return _delay; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void _on_frame(bool missed);
+
+    VkDevice _device = VK_NULL_HANDLE;
+    PFN_vkWaitForPresentKHR _wait_for_present = nullptr;
+    LatencyMode _mode = LatencyMode::Balanced;
+    uint32_t _max_frames_in_flight = 1;
+    uint32_t _frames_in_flight = 1;
+
+    uint64_t _issued = 0;    // last present id handed out
+    uint64_t _completed = 0; // last present id known to be on screen
+    VkPresentIdKHR _present_id{};
+
+    Clock::time_point _last_completion{};
+    std::vector<Clock::duration> _intervals; // recent completion to completion times
+    size_t _interval_cursor = 0;
+    std::chrono::nanoseconds _refresh_interval{ 0 };
+    std::chrono::nanoseconds _delay{ 0 };
+
+    uint32_t _frames_since_change = 0;
+    uint32_t _recent_misses = 0;
+    uint32_t _clean_frames = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef wulkan_wk_READBACK_HPP
+#define wulkan_wk_READBACK_HPP
+
+#include "vma_include.hpp"
+#include "wulkan_internal.hpp"
+#include "buffer.hpp"
+#include "semaphore.hpp"
+#include "command_encoder.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+
+namespace wk {
+
+using ReadbackFuture = std::future<std::vector<uint8_t>>;
+
+// Copies images and buffers back to the host without stalling the render
+// thread. Copies are recorded into the frame's command buffer and land in a
+// ring of host cached memory, one bytes_per_frame region per frame in
+// flight. The frame's submission signals the readback's timeline semaphore;
+// a worker thread waits on it and fulfils the futures, so the render thread
+// never waits on the GPU for a readback.
+//
+// Per frame: begin_frame() once the frame slot is free again (after its
+// fence), any number of read_*() calls, end_frame(), then signal
+// semaphore() with the value begin_frame() returned in the frame's submit.
+class Readback {
+public:
+    Readback() = default;
+    Readback(VkDevice device, VmaAllocator allocator, uint32_t frame_count, VkDeviceSize bytes_per_frame);
+
+    ~Readback() { _stop_worker(); }
+
+    Readback(const Readback&) = delete;
+    Readback& operator=(const Readback&) = delete;
+    Readback(Readback&&) noexcept = default;
+
+    Readback& operator=(Readback&& other) noexcept {
+        if (this != &other) {
+            _stop_worker();
+            _device = other._device;
+            _allocator = other._allocator;
+            _bytes_per_frame = other._bytes_per_frame;
+            _buffer = std::move(other._buffer);
+            _p_mapped = other._p_mapped;
+            _semaphore = std::move(other._semaphore);
+            _state = std::move(other._state);
+            _worker = std::move(other._worker);
+            _frame_index = other._frame_index;
+            _cursor = other._cursor;
+            _value = other._value;
+            _recorded = std::move(other._recorded);
+        }
+        return *this;
+    }
+
+    // Returns the timeline value the frame's submission has to signal.
+    uint64_t begin_frame(uint32_t frame_index);
+
+    // image has to be in layout with prior writes visible to transfer reads.
+    // Only uncompressed formats; texel_size is the size of one texel in bytes.
+    ReadbackFuture read_image(CommandEncoder& encoder, VkImage image, VkImageLayout layout,
+        const VkImageSubresourceLayers& subresource, VkOffset3D offset, VkExtent3D extent, uint32_t texel_size);
+    // buffer has to have prior writes visible to transfer reads.
+    ReadbackFuture read_buffer(CommandEncoder& encoder, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+    // Makes the frame's copies visible to the host and hands them to the worker.
+    void end_frame(CommandEncoder& encoder);
+
+    // The error that stopped the worker, VK_SUCCESS while it runs. Futures
+    // still pending at that point throw from get().
+    VkResult result() const;
+
+    VkSemaphore semaphore() const { return _semaphore.handle(); }
+    uint64_t value() const { return _value; }
+    VkDeviceSize bytes_per_frame() const { return _bytes_per_frame; }
+
+private:
+    struct Pending {
+        uint64_t value = 0;
+        uint32_t frame_index = 0;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        std::promise<std::vector<uint8_t>> promise;
+    };
+
+    // Shared with the worker.
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<Pending> queue;
+        std::vector<uint32_t> outstanding; // per frame in flight
+        bool stop = false;
+        VkResult result = VK_SUCCESS;
+    };
+
+    VkDeviceSize _allocate(VkDeviceSize size, VkDeviceSize alignment);
+    void _stop_worker();
+    static void _work(State& state, VkDevice device, VmaAllocator allocator, VmaAllocation allocation,
+        VkSemaphore semaphore, const uint8_t* p_mapped);
+
+    VkDevice _device = VK_NULL_HANDLE;
+    VmaAllocator _allocator = VK_NULL_HANDLE;
+    VkDeviceSize _bytes_per_frame = 0;
+
+    Buffer _buffer;
+    uint8_t* _p_mapped = nullptr;
+    Semaphore _semaphore; // timeline
+
+    std::shared_ptr<State> _state;
+    std::thread _worker;
+
+    uint32_t _frame_index = 0;
+    VkDeviceSize _cursor = 0;
+    uint64_t _value = 0;
+    std::vector<Pending> _recorded; // this frame's reads, queued at end_frame
+};
+
+}
+
+#endif
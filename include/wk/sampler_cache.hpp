@@ -0,0 +1,100 @@
+#ifndef wulkan_wk_SAMPLER_CACHE_HPP
+#define wulkan_wk_SAMPLER_CACHE_HPP
+
+#include "wulkan_internal.hpp"
+#include "sampler.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <bit>
+
+namespace wk {
+
+// Owns samplers keyed by their full create state, so identical samplers are
+// created once and shared. Devices cap the number of live samplers
+// (maxSamplerAllocationCount, as low as 4000), which ad hoc creation runs
+// into quickly. Handles stay valid for the lifetime of the cache.
+class SamplerCache {
+public:
+    SamplerCache() : _mutex(std::make_unique<std::mutex>()) {}
+    // max_samplers is usually VkPhysicalDeviceLimits::maxSamplerAllocationCount;
+    // get() throws instead of letting creation fail past it.
+    explicit SamplerCache(VkDevice device, uint32_t max_samplers = UINT32_MAX)
+        : _device(device), _max_samplers(max_samplers), _mutex(std::make_unique<std::mutex>()) {}
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+    SamplerCache(SamplerCache&&) noexcept = default;
+    SamplerCache& operator=(SamplerCache&&) noexcept = default;
+
+    // Understands the reduction mode, YCbCr conversion and custom border
+    // color structures in pNext; anything else cannot be keyed and throws.
+    VkSampler get(const VkSamplerCreateInfo& ci) {
+        std::vector<uint64_t> key{
+            ci.flags, ci.magFilter, ci.minFilter, ci.mipmapMode,
+            ci.addressModeU, ci.addressModeV, ci.addressModeW,
+            std::bit_cast<uint32_t>(ci.mipLodBias), ci.anisotropyEnable, std::bit_cast<uint32_t>(ci.maxAnisotropy),
+            ci.compareEnable, ci.compareOp, std::bit_cast<uint32_t>(ci.minLod), std::bit_cast<uint32_t>(ci.maxLod),
+            ci.borderColor, ci.unnormalizedCoordinates
+        };
+        for (auto p = static_cast<const VkBaseInStructure*>(ci.pNext); p; p = p->pNext) {
+            key.push_back(p->sType);
+            switch (p->sType) {
+            case VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO:
+                key.push_back(reinterpret_cast<const VkSamplerReductionModeCreateInfo*>(p)->reductionMode);
+                break;
+            case VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO:
+                key.push_back(HandleToUint64(reinterpret_cast<const VkSamplerYcbcrConversionInfo*>(p)->conversion));
+                break;
+            case VK_STRUCTURE_TYPE_SAMPLER_CUSTOM_BORDER_COLOR_CREATE_INFO_EXT: {
+                auto p_border = reinterpret_cast<const VkSamplerCustomBorderColorCreateInfoEXT*>(p);
+                uint32_t color[4];
+                std::memcpy(color, &p_border->customBorderColor, sizeof(color));
+                key.insert(key.end(), { color[0], color[1], color[2], color[3], uint64_t(p_border->format) });
+                break;
+            }
+            default:
+                throw std::runtime_error("sampler cache cannot key sampler create info chain");
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+        auto it = _samplers.find(key);
+        if (it != _samplers.end()) {
+            return it->second.handle();
+        }
+        if (_samplers.size() >= _max_samplers) {
+            throw std::runtime_error("sampler cache exceeded maxSamplerAllocationCount");
+        }
+
+        Sampler sampler(_device, ci);
+        VkSampler handle = sampler.handle();
+        _samplers.emplace(std::move(key), std::move(sampler));
+        return handle;
+    }
+
+    VkSampler get(const SamplerCreateInfo& ci) {
+        return get(ci.to_vk());
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _samplers.size();
+    }
+
+private:
+    VkDevice _device = VK_NULL_HANDLE;
+    uint32_t _max_samplers = UINT32_MAX;
+    std::unique_ptr<std::mutex> _mutex;
+    std::map<std::vector<uint64_t>, Sampler> _samplers;
+};
+
+}
+
+#endif
@@ -76,6 +76,27 @@ private:
     VkSemaphoreCreateFlags _flags = 0;
 };
 
+class SemaphoreTypeCreateInfo {
+public:
+    SemaphoreTypeCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    SemaphoreTypeCreateInfo& set_semaphore_type(VkSemaphoreType type) { _semaphore_type = type; return *this; }
+    SemaphoreTypeCreateInfo& set_initial_value(uint64_t value) { _initial_value = value; return *this; }
+
+    VkSemaphoreTypeCreateInfo to_vk() const {
+        VkSemaphoreTypeCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        ci.pNext = _p_next;
+        ci.semaphoreType = _semaphore_type;
+        ci.initialValue = _initial_value;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkSemaphoreType _semaphore_type = VK_SEMAPHORE_TYPE_TIMELINE;
+    uint64_t _initial_value = 0;
+};
+
 }
 
 #endif
@@ -0,0 +1,118 @@
+#ifndef wulkan_wk_SHADER_MODULE_CACHE_HPP
+#define wulkan_wk_SHADER_MODULE_CACHE_HPP
+
+#include "wulkan_internal.hpp"
+#include "shader.hpp"
+#include "shader_pack.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <span>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+namespace wk {
+
+// Owns shader modules keyed by SPIR-V content hash, so the same code loaded
+// under different names or by different pipelines is only compiled once.
+// Code is borrowed, not copied, to check hits against: it has to outlive the
+// cache, as the mapping of a ShaderPack does. Code that will not, such as a
+// file read into a vector, goes through get_transient() instead.
+class ShaderModuleCache {
+public:
+    ShaderModuleCache() : _mutex(std::make_unique<std::mutex>()) {}
+    explicit ShaderModuleCache(VkDevice device)
+        : _device(device), _mutex(std::make_unique<std::mutex>()) {}
+
+    ShaderModuleCache(const ShaderModuleCache&) = delete;
+    ShaderModuleCache& operator=(const ShaderModuleCache&) = delete;
+    ShaderModuleCache(ShaderModuleCache&&) noexcept = default;
+    ShaderModuleCache& operator=(ShaderModuleCache&&) noexcept = default;
+
+    VkShaderModule get(uint64_t hash, std::span<const uint32_t> code) {
+        return _get(hash, code, false);
+    }
+
+    VkShaderModule get(std::span<const uint32_t> code) {
+        return get(HashSpirv(code.data(), code.size_bytes()), code);
+    }
+
+    VkShaderModule get(const ShaderPackEntry& entry) {
+        return get(entry.hash, entry.code);
+    }
+
+    // Keeps a copy of the code, for callers that free it after the call.
+    VkShaderModule get_transient(std::span<const uint32_t> code) {
+        return _get(HashSpirv(code.data(), code.size_bytes()), code, true);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _modules.size();
+    }
+
+    // Modules are only needed until pipeline creation, so callers can drop
+    // them once every pipeline using them has been built.
+    void clear() {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _modules.clear();
+    }
+
+private:
+    struct Entry {
+        ShaderModule module;
+        std::span<const uint32_t> code;
+        std::vector<uint32_t> owned_code; // only for get_transient()
+    };
+
+    // Creates the module outside the lock so other threads are not held up;
+    // if another thread stored the same code meanwhile, theirs is kept and
+    // ours is destroyed after the lock is released.
+    VkShaderModule _get(uint64_t hash, std::span<const uint32_t> code, bool copy) {
+        {
+            std::lock_guard<std::mutex> lock(*_mutex);
+            auto it = _modules.find(hash);
+            if (it != _modules.end()) {
+                return _checked(it->second, code);
+            }
+        }
+
+        ShaderModule module(_device,
+            ShaderModuleCreateInfo{}
+                .set_byte_code(code.size_bytes(), code.data())
+                .to_vk()
+        );
+        std::lock_guard<std::mutex> lock(*_mutex);
+        auto it = _modules.find(hash);
+        if (it != _modules.end()) {
+            return _checked(it->second, code);
+        }
+
+        Entry& entry = _modules.emplace(hash, Entry{ std::move(module), code, {} }).first->second;
+        if (copy) {
+            entry.owned_code.assign(code.begin(), code.end());
+            entry.code = entry.owned_code;
+        }
+        return entry.module.handle();
+    }
+
+    // a matching hash is not enough, different code must not share a module
+    static VkShaderModule _checked(const Entry& entry, std::span<const uint32_t> code) {
+        if (!std::equal(code.begin(), code.end(), entry.code.begin(), entry.code.end())) {
+            throw std::runtime_error("shader module cache hash collision");
+        }
+        return entry.module.handle();
+    }
+
+    VkDevice _device = VK_NULL_HANDLE;
+    std::unique_ptr<std::mutex> _mutex;
+    std::unordered_map<uint64_t, Entry> _modules;
+};
+
+}
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef wulkan_wk_SHADER_OBJECT_HPP
+#define wulkan_wk_SHADER_OBJECT_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <array>
+
+namespace wk {
+
+class ShaderObject {
+public:
+    ShaderObject() = default;
+    ShaderObject(VkDevice device, const DeviceFunctions& f, const VkShaderCreateInfoEXT& ci)
+        : _device(device),
+          _vkDestroyShaderEXT(f.vkDestroyShaderEXT)
+    {
+        if (f.vkCreateShadersEXT == nullptr) {
+            throw std::runtime_error("device function vkCreateShadersEXT not set");
+        } else if (f.vkCreateShadersEXT(_device, 1, &ci, nullptr, &_handle) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader object");
+        }
+    }
+
+    // Takes ownership of an already created shader object.
+    ShaderObject(VkDevice device, const DeviceFunctions& f, VkShaderEXT handle)
+        : _handle(handle),
+          _device(device),
+          _vkDestroyShaderEXT(f.vkDestroyShaderEXT) {}
+
+    ~ShaderObject() {
+        if (_handle != VK_NULL_HANDLE) {
+            _vkDestroyShaderEXT(_device, _handle, nullptr);
+        }
+        _handle = VK_NULL_HANDLE;
+        _device = VK_NULL_HANDLE;
+    }
+
+    ShaderObject(const ShaderObject&) = delete;
+    ShaderObject& operator=(const ShaderObject&) = delete;
+
+    ShaderObject(ShaderObject&& other) noexcept
+        : _handle(other._handle),
+          _device(other._device),
+          _vkDestroyShaderEXT(other._vkDestroyShaderEXT)
+    {
+        other._handle = VK_NULL_HANDLE;
+        other._device = VK_NULL_HANDLE;
+        other._vkDestroyShaderEXT = nullptr;
+    }
+
+    ShaderObject& operator=(ShaderObject&& other) noexcept {
+        if (this != &other) {
+            if (_handle != VK_NULL_HANDLE) {
+                _vkDestroyShaderEXT(_device, _handle, nullptr);
+            }
+            _handle = other._handle;
+            _device = other._device;
+            _vkDestroyShaderEXT = other._vkDestroyShaderEXT;
+            other._handle = VK_NULL_HANDLE;
+            other._device = VK_NULL_HANDLE;
+            other._vkDestroyShaderEXT = nullptr;
+        }
+        return *this;
+    }
+
+    // Implementation-specific binary, reusable via VK_SHADER_CODE_TYPE_BINARY_EXT.
+    std::vector<uint8_t> binary_data(const DeviceFunctions& f) const {
+        if (f.vkGetShaderBinaryDataEXT == nullptr) {
+            throw std::runtime_error("device function vkGetShaderBinaryDataEXT not set");
+        }
+        size_t size = 0;
+        if (f.vkGetShaderBinaryDataEXT(_device, _handle, &size, nullptr) != VK_SUCCESS) {
+            throw std::runtime_error("failed to get shader binary size");
+        }
+        std::vector<uint8_t> data(size);
+        if (f.vkGetShaderBinaryDataEXT(_device, _handle, &size, data.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to get shader binary data");
+        }
+        return data;
+    }
+
+    const VkShaderEXT& handle() const { return _handle; }
+
+private:
+    VkShaderEXT _handle = VK_NULL_HANDLE;
+    VkDevice _device = VK_NULL_HANDLE;
+    PFN_vkDestroyShaderEXT _vkDestroyShaderEXT = nullptr;
+};
+
+// Creates the stages in one call with VK_SHADER_CREATE_LINK_STAGE_BIT_EXT set,
+// letting the driver optimize across the stage interfaces.
+inline std::vector<ShaderObject> CreateLinkedShaderObjects(VkDevice device, const DeviceFunctions& f,
+    uint32_t count, const VkShaderCreateInfoEXT* p_create_infos)
+{
+    if (f.vkCreateShadersEXT == nullptr) {
+        throw std::runtime_error("device function vkCreateShadersEXT not set");
+    }
+
+    std::vector<VkShaderCreateInfoEXT> create_infos(p_create_infos, p_create_infos + count);
+    for (VkShaderCreateInfoEXT& ci : create_infos) {
+        ci.flags |= VK_SHADER_CREATE_LINK_STAGE_BIT_EXT;
+    }
+
+    std::vector<VkShaderEXT> handles(count, VK_NULL_HANDLE);
+    if (f.vkCreateShadersEXT(device, count, create_infos.data(), nullptr, handles.data()) != VK_SUCCESS) {
+        for (VkShaderEXT handle : handles) {
+            if (handle != VK_NULL_HANDLE) {
+                f.vkDestroyShaderEXT(device, handle, nullptr);
+            }
+        }
+        throw std::runtime_error("failed to create linked shader objects");
+    }
+
+    std::vector<ShaderObject> shaders;
+    shaders.reserve(count);
+    for (VkShaderEXT handle : handles) {
+        shaders.emplace_back(device, f, handle);
+    }
+    return shaders;
+}
+
+// Non-owning view of what gets bound for a draw: either a pipeline or a set
+// of shader objects, so call sites stay the same across both backends.
+class GraphicsProgram {
+public:
+    static constexpr uint32_t MAX_STAGES = 8;
+
+    GraphicsProgram() = default;
+    explicit GraphicsProgram(VkPipeline pipeline)
+        : _backend(GraphicsBackend::Pipeline), _pipeline(pipeline) {}
+    GraphicsProgram(uint32_t count, const VkShaderStageFlagBits* p_stages, const VkShaderEXT* p_shaders)
+        : _backend(GraphicsBackend::ShaderObject)
+    {
+        if (count > MAX_STAGES) {
+            throw std::runtime_error("too many shader stages in graphics program");
+        }
+        _stage_count = count;
+        for (uint32_t i = 0; i < count; ++i) {
+            _stages[i] = p_stages[i];
+            _shaders[i] = p_shaders[i];
+        }
+    }
+
+    GraphicsBackend backend() const { return _backend; }
+    VkPipeline pipeline() const { return _pipeline; }
+    uint32_t stage_count() const { return _stage_count; }
+    const VkShaderStageFlagBits* stages() const { return _stages.data(); }
+    const VkShaderEXT* shaders() const { return _shaders.data(); }
+
+private:
+    GraphicsBackend _backend = GraphicsBackend::Pipeline;
+    VkPipeline _pipeline = VK_NULL_HANDLE;
+    uint32_t _stage_count = 0;
+    std::array<VkShaderStageFlagBits, MAX_STAGES> _stages{};
+    std::array<VkShaderEXT, MAX_STAGES> _shaders{};
+};
+
+class ShaderCreateInfo {
+public:
+    ShaderCreateInfo& set_p_next(const void* p_next) { _p_next = p_next; return *this; }
+    ShaderCreateInfo& set_flags(VkShaderCreateFlagsEXT flags) { _flags = flags; return *this; }
+    ShaderCreateInfo& set_stage(VkShaderStageFlagBits stage) { _stage = stage; return *this; }
+    ShaderCreateInfo& set_next_stage(VkShaderStageFlags next_stage) { _next_stage = next_stage; return *this; }
+    ShaderCreateInfo& set_code_type(VkShaderCodeTypeEXT code_type) { _code_type = code_type; return *this; }
+    ShaderCreateInfo& set_code(size_t size, const void* p_code) { _code_size = size; _p_code = p_code; return *this; }
+    ShaderCreateInfo& set_p_name(const char* p_name) { _p_name = p_name; return *this; }
+    ShaderCreateInfo& set_set_layouts(uint32_t count, const VkDescriptorSetLayout* p_layouts) {
+        _set_layout_count = count;
+        _p_set_layouts = p_layouts;
+        return *this;
+    }
+    ShaderCreateInfo& set_push_constant_ranges(uint32_t count, const VkPushConstantRange* p_ranges) {
+        _push_constant_range_count = count;
+        _p_push_constant_ranges = p_ranges;
+        return *this;
+    }
+    ShaderCreateInfo& set_p_specialization_info(const VkSpecializationInfo* p_info) { _p_specialization_info = p_info; return *this; }
+
+    VkShaderCreateInfoEXT to_vk() const {
+        VkShaderCreateInfoEXT ci{};
+        ci.sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT;
+        ci.pNext = _p_next;
+        ci.flags = _flags;
+        ci.stage = _stage;
+        ci.nextStage = _next_stage;
+        ci.codeType = _code_type;
+        ci.codeSize = _code_size;
+        ci.pCode = _p_code;
+        ci.pName = _p_name;
+        ci.setLayoutCount = _set_layout_count;
+        ci.pSetLayouts = _p_set_layouts;
+        ci.pushConstantRangeCount = _push_constant_range_count;
+        ci.pPushConstantRanges = _p_push_constant_ranges;
+        ci.pSpecializationInfo = _p_specialization_info;
+        return ci;
+    }
+
+private:
+    const void* _p_next = nullptr;
+    VkShaderCreateFlagsEXT _flags = 0;
+    VkShaderStageFlagBits _stage = VK_SHADER_STAGE_VERTEX_BIT;
+    VkShaderStageFlags _next_stage = 0;
+    VkShaderCodeTypeEXT _code_type = VK_SHADER_CODE_TYPE_SPIRV_EXT;
+    size_t _code_size = 0;
+    const void* _p_code = nullptr;
+    const char* _p_name = "main";
+    uint32_t _set_layout_count = 0;
+    const VkDescriptorSetLayout* _p_set_layouts = nullptr;
+    uint32_t _push_constant_range_count = 0;
+    const VkPushConstantRange* _p_push_constant_ranges = nullptr;
+    const VkSpecializationInfo* _p_specialization_info = nullptr;
+};
+
+class PhysicalDeviceShaderObjectFeatures {
+public:
+    PhysicalDeviceShaderObjectFeatures& set_p_next(void* p_next) { _p_next = p_next; return *this; }
+    PhysicalDeviceShaderObjectFeatures& set_shader_object(VkBool32 b) { _shader_object = b; return *this; }
+
+    VkPhysicalDeviceShaderObjectFeaturesEXT to_vk() const {
+        VkPhysicalDeviceShaderObjectFeaturesEXT f{};
+        f.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT;
+        f.pNext = _p_next;
+        f.shaderObject = _shader_object;
+        return f;
+    }
+
+private:
+    void* _p_next = nullptr;
+    VkBool32 _shader_object = VK_FALSE;
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef wulkan_wk_SHADER_PACK_HPP
+#define wulkan_wk_SHADER_PACK_HPP
+
+#include "wulkan_internal.hpp"
+#include "mapped_file.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <span>
+#include <unordered_map>
+
+namespace wk {
+
+// Shader pack layout (little endian):
+//   header   { u32 magic 'WKSP', u32 version, u32 entry_count, u32 reserved }
+//   entries  { u64 hash, u64 code_offset, u32 code_size, u32 name_offset, u32 name_size, u32 reserved }[entry_count]
+//   names    utf-8, not null terminated
+//   code     SPIR-V blobs, 16 byte aligned, stored once per distinct hash
+// Entries are sorted by hash; several names may point at the same blob.
+constexpr uint32_t SHADER_PACK_MAGIC = 0x50534B57;
+constexpr uint32_t SHADER_PACK_VERSION = 1;
+
+struct ShaderPackEntry {
+    std::string_view name;
+    uint64_t hash = 0;
+    std::span<const uint32_t> code; // points into the mapped pack
+
+    VkShaderModuleCreateInfo module_create_info() const {
+        VkShaderModuleCreateInfo ci{};
+        ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        ci.codeSize = code.size_bytes();
+        ci.pCode = code.data();
+        return ci;
+    }
+};
+
+// A shader archive mapped once; every lookup hands out SPIR-V without copying.
+class ShaderPack {
+public:
+    ShaderPack() = default;
+    explicit ShaderPack(const char* path);
+
+    ShaderPack(const ShaderPack&) = delete;
+    ShaderPack& operator=(const ShaderPack&) = delete;
+    ShaderPack(ShaderPack&&) noexcept = default;
+    ShaderPack& operator=(ShaderPack&&) noexcept = default;
+
+    const ShaderPackEntry* find(std::string_view name) const {
+        auto it = _by_name.find(name);
+        return it != _by_name.end() ? &_entries[it->second] : nullptr;
+    }
+
+    const ShaderPackEntry* find(uint64_t hash) const;
+
+    const ShaderPackEntry& at(std::string_view name) const {
+        const ShaderPackEntry* entry = find(name);
+        if (!entry) {
+            throw std::runtime_error("shader not found in pack: " + std::string(name));
+        }
+        return *entry;
+    }
+
+    const std::vector<ShaderPackEntry>& entries() const { return _entries; }
+
+private:
+    MappedFile _file;
+    std::vector<ShaderPackEntry> _entries; // sorted by hash
+    std::unordered_map<std::string_view, uint32_t> _by_name;
+};
+
+struct ShaderPackSource {
+    std::string name;
+    std::vector<uint8_t> code;
+};
+
+uint64_t HashSpirv(const void* p_code, size_t code_size);
+void WriteShaderPack(const char* path, uint32_t source_count, const ShaderPackSource* p_sources);
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef wulkan_wk_SHADER_REFLECTION_HPP
+#define wulkan_wk_SHADER_REFLECTION_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+namespace wk {
+
+struct ReflectedBinding {
+    uint32_t set = 0;
+    VkDescriptorSetLayoutBinding binding{};
+    bool runtime_array = false; // declared as T[] in the shader, descriptor_count is 0
+};
+
+struct ShaderReflection {
+    VkShaderStageFlags stages = 0;
+    std::vector<std::string> entry_points;
+    std::vector<ReflectedBinding> bindings; // sorted by (set, binding)
+    std::vector<VkPushConstantRange> push_constant_ranges;
+    uint32_t local_size[3] = { 0, 0, 0 };
+
+    uint32_t set_count() const {
+        uint32_t count = 0;
+        for (const ReflectedBinding& b : bindings) {
+            count = std::max(count, b.set + 1);
+        }
+        return count;
+    }
+
+    // Layout bindings for one set; runtime arrays get runtime_array_count descriptors.
+    std::vector<VkDescriptorSetLayoutBinding> set_bindings(uint32_t set, uint32_t runtime_array_count = 1) const {
+        std::vector<VkDescriptorSetLayoutBinding> out;
+        for (const ReflectedBinding& b : bindings) {
+            if (b.set != set) continue;
+            out.push_back(b.binding);
+            if (b.runtime_array) {
+                out.back().descriptorCount = runtime_array_count;
+            }
+        }
+        return out;
+    }
+
+    // Descriptors one set needs per type, e.g. for DescriptorAllocator::allocate.
+    std::vector<VkDescriptorPoolSize> set_pool_sizes(uint32_t set, uint32_t runtime_array_count = 1) const {
+        std::vector<VkDescriptorPoolSize> out;
+        for (const VkDescriptorSetLayoutBinding& b : set_bindings(set, runtime_array_count)) {
+            auto it = std::find_if(out.begin(), out.end(), [&](const VkDescriptorPoolSize& s) { return s.type == b.descriptorType; });
+            if (it == out.end()) {
+                out.push_back(VkDescriptorPoolSize{ b.descriptorType, 0 });
+                it = out.end() - 1;
+            }
+            it->descriptorCount += b.descriptorCount;
+        }
+        return out;
+    }
+};
+
+ShaderReflection ReflectSpirv(const uint32_t* p_code, size_t code_size);
+ShaderReflection MergeShaderReflections(uint32_t count, const ShaderReflection* p_reflections);
+
+inline ShaderReflection ReflectShaderModule(const VkShaderModuleCreateInfo& ci) {
+    return ReflectSpirv(ci.pCode, ci.codeSize);
+}
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef wulkan_wk_SPECIALIZATION_HPP
+#define wulkan_wk_SPECIALIZATION_HPP
+
+#include "wulkan_internal.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <span>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <type_traits>
+
+// Map entry for one member of a specialization struct, usable in constexpr arrays:
+//   constexpr std::array LIGHTING_SPEC_MAP = {
+//       WLK_SPECIALIZATION_CONSTANT(LightingSpec, light_count, 0),
+//       WLK_SPECIALIZATION_CONSTANT(LightingSpec, use_shadows, 1),
+//   };
+// Boolean constants are 32 bits in SPIR-V, so declare them VkBool32, e.g.
+//   struct LightingSpec { uint32_t light_count; VkBool32 use_shadows; };
+#define WLK_SPECIALIZATION_CONSTANT(type, member, constant_id) \
+    wk::SpecializationMapEntry<decltype(type::member)>((constant_id), offsetof(type, member))
+
+namespace wk {
+
+template<typename Member>
+constexpr VkSpecializationMapEntry SpecializationMapEntry(uint32_t constant_id, size_t offset) {
+    static_assert(!std::is_same_v<std::remove_cv_t<Member>, bool>,
+        "bool specialization constants must be VkBool32, SPIR-V booleans are 4 bytes");
+    return VkSpecializationMapEntry{ constant_id, static_cast<uint32_t>(offset), sizeof(Member) };
+}
+
+// Specialization constants backed by a plain struct. The map says which
+// member feeds which constant_id; to_vk() points into this object, so keep
+// it alive (and unmoved) until the pipeline or shader object is created.
+template<typename T>
+class SpecializationInfo {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>,
+        "specialization data must be a trivially copyable standard layout struct");
+
+public:
+    SpecializationInfo() = default;
+    SpecializationInfo(const T& data, std::span<const VkSpecializationMapEntry> map)
+        : _data(data), _map(map.begin(), map.end())
+    {
+        for (const VkSpecializationMapEntry& e : _map) {
+            if (e.offset + e.size > sizeof(T)) {
+                throw std::runtime_error("specialization map entry outside of data");
+            }
+        }
+    }
+
+    SpecializationInfo& set_data(const T& data) { _data = data; return *this; }
+    const T& data() const { return _data; }
+    T& data() { return _data; }
+
+    VkSpecializationInfo to_vk() const {
+        VkSpecializationInfo info{};
+        info.mapEntryCount = static_cast<uint32_t>(_map.size());
+        info.pMapEntries = _map.data();
+        info.dataSize = sizeof(T);
+        info.pData = &_data;
+        return info;
+    }
+
+private:
+    T _data{};
+    std::vector<VkSpecializationMapEntry> _map;
+};
+
+// Canonical key of a specialization: constant ids and the bytes each one
+// reads, sorted by id, so member order and unmapped padding don't matter.
+inline std::vector<uint64_t> SpecializationKey(const VkSpecializationInfo* p_info) {
+    std::vector<uint64_t> key;
+    if (p_info == nullptr) {
+        return key;
+    }
+
+    std::vector<VkSpecializationMapEntry> entries(p_info->pMapEntries, p_info->pMapEntries + p_info->mapEntryCount);
+    std::sort(entries.begin(), entries.end(), [](const VkSpecializationMapEntry& a, const VkSpecializationMapEntry& b) {
+        return a.constantID < b.constantID;
+    });
+
+    const uint8_t* data = static_cast<const uint8_t*>(p_info->pData);
+    for (const VkSpecializationMapEntry& e : entries) {
+        key.push_back((uint64_t(e.constantID) << 32) | e.size);
+        for (size_t i = 0; i < e.size; i += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            std::memcpy(&word, data + e.offset + i, std::min(sizeof(uint64_t), e.size - i));
+            key.push_back(word);
+        }
+    }
+    return key;
+}
+
+// Holds one compiled variant per (module, specialization values). `Value` is
+// whatever the variant compiles to: a wk::Pipeline, wk::ShaderObject, ...
+// The context key covers anything else the variant depends on (layout,
+// stage, state), in full rather than hashed so different variants never
+// share an entry; GraphicsPipelineKey() builds one for graphics pipelines.
+// create() runs outside the lock, so two threads missing on the same key may
+// both compile it; only the first result is kept.
+template<typename Value>
+class SpecializationCache {
+public:
+    SpecializationCache() : _mutex(std::make_unique<std::mutex>()) {}
+
+    SpecializationCache(const SpecializationCache&) = delete;
+    SpecializationCache& operator=(const SpecializationCache&) = delete;
+    SpecializationCache(SpecializationCache&&) noexcept = default;
+    SpecializationCache& operator=(SpecializationCache&&) noexcept = default;
+
+    template<typename Create>
+    const Value& get(VkShaderModule module, const VkSpecializationInfo* p_info, std::span<const uint64_t> context,
+        Create&& create)
+    {
+        std::vector<uint64_t> key{ HandleToUint64(module), context.size() };
+        key.insert(key.end(), context.begin(), context.end());
+        std::vector<uint64_t> spec = SpecializationKey(p_info);
+        key.insert(key.end(), spec.begin(), spec.end());
+
+        {
+            std::lock_guard<std::mutex> lock(*_mutex);
+            auto it = _variants.find(key);
+            if (it != _variants.end()) {
+                return it->second;
+            }
+        }
+
+        // compile without holding the lock so other variants are not held up;
+        // if another thread stored this one meanwhile, theirs is kept and
+        // ours is destroyed after the lock is released
+        Value value = create();
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _variants.try_emplace(std::move(key), std::move(value)).first->second;
+    }
+
+    template<typename T, typename Create>
+    const Value& get(VkShaderModule module, const SpecializationInfo<T>& spec, std::span<const uint64_t> context,
+        Create&& create)
+    {
+        VkSpecializationInfo info = spec.to_vk();
+        return get(module, &info, context, std::forward<Create>(create));
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        return _variants.size();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(*_mutex);
+        _variants.clear();
+    }
+
+private:
+    std::unique_ptr<std::mutex> _mutex;
+    std::map<std::vector<uint64_t>, Value> _variants;
+};
+
+}
+
+#endif
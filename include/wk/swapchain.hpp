@@ -88,6 +88,27 @@ public:
         return *this;
     }
 
+    // Replaces this swapchain with one created from ci, passing the current
+    // one as oldSwapchain. The old swapchain, its images and views are
+    // returned instead of destroyed since frames still in flight may use them;
+    // retire it through a DeletionQueue. Frame fences only cover rendering,
+    // not the presents still queued on the old swapchain, so retirement by
+    // frame count is not strictly safe: Vulkan has no way to know a present
+    // finished without VK_EXT_swapchain_maintenance1 present fences, which
+    // are not used here. It relies on presents completing within
+    // frames_in_flight frames, as they do in practice.
+    Swapchain recreate(VkSwapchainCreateInfoKHR ci) {
+        ci.oldSwapchain = _handle;
+        Swapchain old = std::move(*this);
+        try {
+            *this = Swapchain(old._device, ci);
+        } catch (...) {
+            *this = std::move(old);
+            throw;
+        }
+        return old;
+    }
+
     const VkSwapchainKHR& handle() const { return _handle; }
     const VkFormat& image_format() const { return _image_format; }
     const std::vector<VkImage>& images() const { return _images; }
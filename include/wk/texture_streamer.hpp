@@ -0,0 +1,174 @@
+#ifndef wulkan_wk_TEXTURE_STREAMER_HPP
+#define wulkan_wk_TEXTURE_STREAMER_HPP
+
+#include "vma_include.hpp"
+#include "wulkan_internal.hpp"
+#include "ktx2.hpp"
+#include "buffer.hpp"
+#include "image.hpp"
+#include "image_view.hpp"
+#include "command_encoder.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+
+namespace wk {
+
+using TextureId = uint32_t;
+constexpr TextureId INVALID_TEXTURE_ID = UINT32_MAX;
+
+// Turns supercompressed or Basis Universal levels into data of target_format.
+// transcode runs on the streamer's worker threads, target_format on the
+// thread calling load().
+struct TextureTranscoder {
+    std::function<VkFormat(const Ktx2File&)> target_format;
+    std::function<std::vector<uint8_t>(const Ktx2File&, uint32_t level)> transcode;
+};
+
+// Streams KTX2 textures in from the smallest mip up. load() maps the file
+// and creates the image right away; update() then copies levels through a
+// ring of staging memory, at most bytes_per_frame per frame, so a texture is
+// usable (blurry) almost immediately and sharpens over the following frames.
+// Levels that need transcoding are prepared on worker threads a couple of
+// levels ahead of the upload, which bounds the memory held for them.
+//
+// view() covers only the resident levels, so it is VK_NULL_HANDLE until the
+// first level arrives and is replaced each time another one does (the old
+// view lives until its frame comes around again); re-fetch it every frame.
+// All methods are meant for the render thread.
+class TextureStreamer {
+public:
+    TextureStreamer() = default;
+    TextureStreamer(VkDevice device, VmaAllocator allocator, uint32_t frame_count, VkDeviceSize bytes_per_frame,
+        uint32_t worker_count = 2, TextureTranscoder transcoder = {});
+
+    ~TextureStreamer() { _stop_workers(); }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+    TextureStreamer(TextureStreamer&&) noexcept = default;
+
+    TextureStreamer& operator=(TextureStreamer&& other) noexcept {
+        if (this != &other) {
+            _stop_workers();
+            _device = other._device;
+            _allocator = other._allocator;
+            _frame_count = other._frame_count;
+            _bytes_per_frame = other._bytes_per_frame;
+            _staging = std::move(other._staging);
+            _p_staging = other._p_staging;
+            _jobs = std::move(other._jobs);
+            _workers = std::move(other._workers);
+            _textures = std::move(other._textures);
+            _free_ids = std::move(other._free_ids);
+            _retired = std::move(other._retired);
+        }
+        return *this;
+    }
+
+    TextureId load(const char* path);
+
+    // Call once per frame after the frame's fence has signalled, while
+    // recording a command buffer of that frame on a queue with transfer support.
+    void update(CommandEncoder& encoder, uint32_t frame_index);
+
+    // The texture is destroyed once frame_index comes around again.
+    void release(TextureId id, uint32_t frame_index);
+
+    VkImage image(TextureId id) const { return _texture(id).image.handle(); }
+    VkImageView view(TextureId id) const { return _texture(id).view.handle(); }
+    uint32_t level_count(TextureId id) const { return _texture(id).level_count; }
+    // Most detailed level with data; level_count() while nothing is resident.
+    uint32_t resident_level(TextureId id) const { return _texture(id).resident_level; }
+    bool is_resident(TextureId id) const { return _texture(id).resident_level < _texture(id).level_count; }
+    bool is_complete(TextureId id) const { return _texture(id).resident_level == 0; }
+    // The next level failed to transcode, or did not match its extent or
+    // the budget, on every retry, so streaming of this texture has stopped
+    // at resident_level().
+    bool has_failed(TextureId id) const;
+
+    VkDeviceSize bytes_per_frame() const { return _bytes_per_frame; }
+
+private:
+    // Level data shared with the workers.
+    struct Source {
+        std::unique_ptr<Ktx2File> file;
+        struct Level {
+            std::vector<uint8_t> data;
+            bool requested = false;
+            bool ready = false;
+            bool failed = false;
+            uint32_t attempts = 0; // failed transcodes so far
+        };
+        std::vector<Level> levels; // only used when the file needs transcoding
+        VkFormat format = VK_FORMAT_UNDEFINED; // transcoder output, for checking levels
+        VkDeviceSize bytes_per_frame = 0;
+    };
+
+    struct Jobs {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::pair<std::shared_ptr<Source>, uint32_t>> queue;
+        bool stop = false;
+        TextureTranscoder transcoder;
+    };
+
+    struct Texture {
+        std::shared_ptr<Source> source; // dropped once every level is resident
+        bool transcoded = false;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D;
+        uint32_t level_count = 0;
+        uint32_t layer_count = 0;      // array layers times faces
+        uint32_t resident_level = 0;
+        VkDeviceSize uploaded = 0;     // bytes of level resident_level - 1 already copied
+        Image image;
+        ImageView view;                // resident_level..level_count, null while none is
+        bool alive = false;
+    };
+
+    struct Retired {
+        std::vector<Image> images;
+        std::vector<ImageView> views;
+    };
+
+    const Texture& _texture(TextureId id) const {
+        if (id >= _textures.size() || !_textures[id].alive) {
+            throw std::runtime_error("invalid texture id");
+        }
+        return _textures[id];
+    }
+
+    std::span<const uint8_t> _level_data(const Texture& texture, uint32_t level) const;
+    void _request_levels(Texture& texture);
+    ImageView _create_view(const Texture& texture) const;
+    void _stop_workers();
+    static void _work(Jobs& jobs);
+
+    VkDevice _device = VK_NULL_HANDLE;
+    VmaAllocator _allocator = VK_NULL_HANDLE;
+    uint32_t _frame_count = 0;
+    VkDeviceSize _bytes_per_frame = 0;
+
+    Buffer _staging; // one bytes_per_frame region per frame in flight
+    uint8_t* _p_staging = nullptr;
+
+    std::shared_ptr<Jobs> _jobs;
+    std::vector<std::thread> _workers;
+
+    std::vector<Texture> _textures; // indexed by TextureId
+    std::vector<TextureId> _free_ids;
+    std::vector<Retired> _retired;  // per frame in flight
+};
+
+}
+
+#endif
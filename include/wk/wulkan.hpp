@@ -12,6 +12,7 @@
 
 // Swapchain & presentation
 #include "swapchain.hpp"
+#include "present_controller.hpp"
 
 // Synchronization
 #include "semaphore.hpp"
@@ -21,26 +22,44 @@
 // Command system
 #include "command_pool.hpp"
 #include "command_buffer.hpp"
+#include "command_encoder.hpp"
 
 // Render targets
 #include "render_pass.hpp"
 #include "framebuffer.hpp"
 #include "image.hpp"
 #include "image_view.hpp"
+#include "image_view_cache.hpp"
 #include "sampler.hpp"
+#include "sampler_cache.hpp"
 #include "sampler_ycbcr_conversion.hpp"
 
 // Shaders & pipelines
 #include "shader.hpp"
+#include "shader_pack.hpp"
+#include "shader_module_cache.hpp"
+#include "specialization.hpp"
 #include "pipeline_layout.hpp"
 #include "pipeline.hpp"
+#include "graphics_pipeline_cache.hpp"
+#include "pipeline_feedback.hpp"
+#include "pipeline_manifest.hpp"
+#include "pipeline_library.hpp"
+#include "shader_object.hpp"
 #include "pipeline_cache.hpp"
 
 // Descriptors
 #include "descriptor_pool.hpp"
+#include "descriptor_allocator.hpp"
+#include "descriptor_buffer.hpp"
+#include "bindless_heap.hpp"
 #include "descriptor_set_layout.hpp"
 #include "descriptor_set.hpp"
+#include "descriptor_writer.hpp"
+#include "descriptor_set_cache.hpp"
 #include "descriptor_update_template.hpp"
+#include "shader_reflection.hpp"
+#include "layout_cache.hpp"
 
 // Queries
 #include "query_pool.hpp"
@@ -51,8 +70,15 @@
 // Memory (VMA + wrappers)
 #include "allocator.hpp"
 #include "buffer.hpp"
+#include "readback.hpp"
 
 // Sync
 #include "sync.hpp"
+#include "deletion_queue.hpp"
+
+// Textures
+#include "mip_generator.hpp"
+#include "ktx2.hpp"
+#include "texture_streamer.hpp"
 
 #endif
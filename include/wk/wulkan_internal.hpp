@@ -9,6 +9,7 @@
 #include <fstream>
 #include <optional>
 #include <functional>
+#include <type_traits>
 
 #include <vulkan/vulkan_core.h>
 #ifdef __APPLE__
@@ -39,6 +40,115 @@ struct PhysicalDeviceSurfaceSupport {
     std::vector<VkPresentModeKHR> present_modes;
 };
 
+struct DeviceFunctions {
+    // Version the device was created for; from 1.3 on the promoted dynamic
+    // state commands are called through their core entry points
+    uint32_t                                       api_version = 0;
+
+    // Extended dynamic state, the extension entry points for devices below 1.3.
+    // Like the other dynamic state groups, only set when the extension is enabled.
+    PFN_vkCmdSetCullModeEXT                        vkCmdSetCullModeEXT = nullptr;
+    PFN_vkCmdSetFrontFaceEXT                       vkCmdSetFrontFaceEXT = nullptr;
+    PFN_vkCmdSetPrimitiveTopologyEXT               vkCmdSetPrimitiveTopologyEXT = nullptr;
+    PFN_vkCmdSetViewportWithCountEXT               vkCmdSetViewportWithCountEXT = nullptr;
+    PFN_vkCmdSetScissorWithCountEXT                vkCmdSetScissorWithCountEXT = nullptr;
+    PFN_vkCmdSetDepthTestEnableEXT                 vkCmdSetDepthTestEnableEXT = nullptr;
+    PFN_vkCmdSetDepthWriteEnableEXT                vkCmdSetDepthWriteEnableEXT = nullptr;
+    PFN_vkCmdSetDepthCompareOpEXT                  vkCmdSetDepthCompareOpEXT = nullptr;
+    PFN_vkCmdSetDepthBoundsTestEnableEXT           vkCmdSetDepthBoundsTestEnableEXT = nullptr;
+    PFN_vkCmdSetStencilTestEnableEXT               vkCmdSetStencilTestEnableEXT = nullptr;
+    PFN_vkCmdSetStencilOpEXT                       vkCmdSetStencilOpEXT = nullptr;
+
+    // Extended dynamic state 2
+    PFN_vkCmdSetRasterizerDiscardEnableEXT         vkCmdSetRasterizerDiscardEnableEXT = nullptr;
+    PFN_vkCmdSetDepthBiasEnableEXT                 vkCmdSetDepthBiasEnableEXT = nullptr;
+    PFN_vkCmdSetPrimitiveRestartEnableEXT          vkCmdSetPrimitiveRestartEnableEXT = nullptr;
+    PFN_vkCmdSetPatchControlPointsEXT              vkCmdSetPatchControlPointsEXT = nullptr;
+    PFN_vkCmdSetLogicOpEXT                         vkCmdSetLogicOpEXT = nullptr;
+
+    // Extended dynamic state 3
+    PFN_vkCmdSetTessellationDomainOriginEXT        vkCmdSetTessellationDomainOriginEXT = nullptr;
+    PFN_vkCmdSetDepthClampEnableEXT                vkCmdSetDepthClampEnableEXT = nullptr;
+    PFN_vkCmdSetPolygonModeEXT                     vkCmdSetPolygonModeEXT = nullptr;
+    PFN_vkCmdSetRasterizationSamplesEXT            vkCmdSetRasterizationSamplesEXT = nullptr;
+    PFN_vkCmdSetSampleMaskEXT                      vkCmdSetSampleMaskEXT = nullptr;
+    PFN_vkCmdSetAlphaToCoverageEnableEXT           vkCmdSetAlphaToCoverageEnableEXT = nullptr;
+    PFN_vkCmdSetAlphaToOneEnableEXT                vkCmdSetAlphaToOneEnableEXT = nullptr;
+    PFN_vkCmdSetLogicOpEnableEXT                   vkCmdSetLogicOpEnableEXT = nullptr;
+    PFN_vkCmdSetColorBlendEnableEXT                vkCmdSetColorBlendEnableEXT = nullptr;
+    PFN_vkCmdSetColorBlendEquationEXT              vkCmdSetColorBlendEquationEXT = nullptr;
+    PFN_vkCmdSetColorWriteMaskEXT                  vkCmdSetColorWriteMaskEXT = nullptr;
+    PFN_vkCmdSetDepthClipEnableEXT                 vkCmdSetDepthClipEnableEXT = nullptr;
+    PFN_vkCmdSetLineRasterizationModeEXT           vkCmdSetLineRasterizationModeEXT = nullptr;
+
+    // Shader objects
+    PFN_vkCreateShadersEXT                         vkCreateShadersEXT = nullptr;
+    PFN_vkDestroyShaderEXT                         vkDestroyShaderEXT = nullptr;
+    PFN_vkGetShaderBinaryDataEXT                   vkGetShaderBinaryDataEXT = nullptr;
+    PFN_vkCmdBindShadersEXT                        vkCmdBindShadersEXT = nullptr;
+    PFN_vkCmdSetVertexInputEXT                     vkCmdSetVertexInputEXT = nullptr;
+
+    // Descriptor buffers
+    PFN_vkGetDescriptorSetLayoutSizeEXT            vkGetDescriptorSetLayoutSizeEXT = nullptr;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT   vkGetDescriptorSetLayoutBindingOffsetEXT = nullptr;
+    PFN_vkGetDescriptorEXT                         vkGetDescriptorEXT = nullptr;
+    PFN_vkCmdBindDescriptorBuffersEXT              vkCmdBindDescriptorBuffersEXT = nullptr;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT         vkCmdSetDescriptorBufferOffsetsEXT = nullptr;
+
+    // Push descriptors
+    PFN_vkCmdPushDescriptorSetKHR                  vkCmdPushDescriptorSetKHR = nullptr;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR      vkCmdPushDescriptorSetWithTemplateKHR = nullptr;
+
+    // Present wait
+    PFN_vkWaitForPresentKHR                        vkWaitForPresentKHR = nullptr;
+};
+
+enum class GraphicsBackend {
+    Pipeline,
+    ShaderObject
+};
+
+// Where descriptors live: pool-allocated sets, or plain buffer memory written
+// through VK_EXT_descriptor_buffer.
+enum class DescriptorBackend {
+    DescriptorSets,
+    DescriptorBuffer
+};
+
+inline VkDescriptorSetLayoutCreateFlags DescriptorBackendLayoutFlags(DescriptorBackend backend) {
+    return backend == DescriptorBackend::DescriptorBuffer ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+}
+
+// Supported extended dynamic state features. p_next chains the structs
+// below, so the object is filled in place and cannot be copied or moved.
+// Enable `extensions` on the device and pass them to LoadDeviceFunctions so
+// a CommandEncoder can reach the commands below 1.3.
+struct ExtendedDynamicStateSupport {
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT eds1{};
+    VkPhysicalDeviceExtendedDynamicState2FeaturesEXT eds2{};
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT eds3{};
+    bool core_eds1 = false;
+    bool core_eds2 = false;
+    std::vector<const char*> extensions;
+    void* p_next = nullptr;
+
+    ExtendedDynamicStateSupport() = default;
+    ExtendedDynamicStateSupport(const ExtendedDynamicStateSupport&) = delete;
+    ExtendedDynamicStateSupport& operator=(const ExtendedDynamicStateSupport&) = delete;
+    ExtendedDynamicStateSupport(ExtendedDynamicStateSupport&&) = delete;
+    ExtendedDynamicStateSupport& operator=(ExtendedDynamicStateSupport&&) = delete;
+};
+
+// Non-dispatchable handles are pointers on 64-bit targets and uint64_t elsewhere.
+template <typename T>
+inline uint64_t HandleToUint64(T handle) {
+    if constexpr (std::is_pointer_v<T>) {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+    } else {
+        return static_cast<uint64_t>(handle);
+    }
+}
+
 std::vector<const char*> GetRequiredDeviceExtensions();
 bool IsValidationLayersSupported();
 VKAPI_ATTR VkBool32 VKAPI_CALL DefaultDebugMessengerCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -59,6 +169,13 @@ std::vector<uint8_t> ReadSpirvShader(const char* file_name);
 VkImageAspectFlags GetAspectFlags(VkFormat format);
 void ImmediateSubmit(VkDevice device, uint32_t queueFamilyIndex,
     const std::function<void(VkDevice, VkCommandPool, VkCommandBuffer)>& record);
+DeviceFunctions LoadDeviceFunctions(VkDevice device, uint32_t api_version, const std::vector<const char*>& enabled_extensions);
+void QueryExtendedDynamicStateSupport(VkPhysicalDevice physical_device, ExtendedDynamicStateSupport& support);
+bool IsDynamicStateSupported(const ExtendedDynamicStateSupport& support, VkDynamicState state);
+std::vector<VkDynamicState> FilterSupportedDynamicStates(const ExtendedDynamicStateSupport& support, uint32_t count, const VkDynamicState* p_states);
+GraphicsBackend ChooseGraphicsBackend(VkPhysicalDevice physical_device);
+VkPhysicalDeviceDescriptorBufferPropertiesEXT QueryDescriptorBufferProperties(VkPhysicalDevice physical_device);
+bool IsPresentWaitSupported(VkPhysicalDevice physical_device);
 
 }
 
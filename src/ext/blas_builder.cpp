@@ -0,0 +1,303 @@
+#include "../../include/wk/ext/rt/blas_builder.hpp"
+#include "../../include/wk/physical_device.hpp"
+#include "../../include/wk/sync.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace wk::ext::rt {
+
+namespace {
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Orders builds sharing scratch, and makes finished structures visible to
+// the builds (TLAS or more BLAS batches) after them.
+void RecordBuildBarrier(VkCommandBuffer command_buffer) {
+    VkMemoryBarrier barrier = wk::MemoryBarrier{}
+        .set_src_access(VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR)
+        .set_dst_access(VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR)
+        .to_vk();
+    vkCmdPipelineBarrier(command_buffer,
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+        0, 1, &barrier, 0, nullptr, 0, nullptr
+    );
+}
+
+}
+
+BlasBuilder::BlasBuilder(VkDevice device, VkPhysicalDevice physical_device, VmaAllocator allocator,
+    const DeviceFunctions& f, VkDeviceSize scratch_budget, bool allow_compaction)
+    : _device(device), _allocator(allocator), _functions(f), _scratch_budget(scratch_budget),
+      _allow_compaction(allow_compaction)
+{
+    if (!f.vkGetAccelerationStructureBuildSizesKHR || !f.vkGetAccelerationStructureDeviceAddressKHR
+        || !f.vkCmdBuildAccelerationStructuresKHR) {
+        throw std::runtime_error("blas builder device functions not set");
+    }
+    if (allow_compaction && (!f.vkCmdWriteAccelerationStructuresPropertiesKHR || !f.vkCmdCopyAccelerationStructureKHR)) {
+        throw std::runtime_error("blas builder compaction device functions not set");
+    }
+
+    VkPhysicalDeviceAccelerationStructurePropertiesKHR acceleration_structure_properties{};
+    acceleration_structure_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR;
+    VkPhysicalDeviceProperties2 physical_device_properties = wk::PhysicalDeviceProperties2{}
+        .set_p_next(&acceleration_structure_properties)
+        .to_vk();
+    vkGetPhysicalDeviceProperties2(physical_device, &physical_device_properties);
+    _scratch_alignment = std::max<VkDeviceSize>(acceleration_structure_properties.minAccelerationStructureScratchOffsetAlignment, 1);
+}
+
+uint32_t BlasBuilder::add(const BlasInput& input) {
+    if (input.geometries.empty() || input.geometries.size() != input.ranges.size()) {
+        throw std::runtime_error("blas input needs one range per geometry");
+    }
+
+    Entry entry;
+    entry.input = input;
+    if (_allow_compaction) {
+        entry.input.flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    }
+
+    std::vector<uint32_t> max_primitive_counts;
+    max_primitive_counts.reserve(input.ranges.size());
+    for (const VkAccelerationStructureBuildRangeInfoKHR& range : input.ranges) {
+        max_primitive_counts.push_back(range.primitiveCount);
+    }
+
+    VkAccelerationStructureBuildGeometryInfoKHR build_info = AccelerationStructureBuildGeometryInfo{}
+        .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
+        .set_flags(entry.input.flags)
+        .set_mode(VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
+        .set_geometries(static_cast<uint32_t>(input.geometries.size()), input.geometries.data())
+        .to_vk();
+    entry.sizes = AccelerationStructureBuildSizesInfo{}.to_vk();
+    _functions.vkGetAccelerationStructureBuildSizesKHR(_device,
+        VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+        &build_info,
+        max_primitive_counts.data(),
+        &entry.sizes
+    );
+
+    entry.buffer = Buffer(_allocator,
+        BufferCreateInfo{}
+            .set_size(entry.sizes.accelerationStructureSize)
+            .set_usage(VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                       VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+            .to_vk(),
+        AllocationCreateInfo{}
+            .set_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+            .to_vk()
+    );
+
+    entry.acceleration_structure = AccelerationStructure(_device, _functions,
+        AccelerationStructureCreateInfo{}
+            .set_buffer(entry.buffer.handle())
+            .set_offset(0)
+            .set_size(entry.sizes.accelerationStructureSize)
+            .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
+            .to_vk()
+    );
+
+    VkAccelerationStructureDeviceAddressInfoKHR address_info = AccelerationStructureDeviceAddressInfo{}
+        .set_acceleration_structure(entry.acceleration_structure.handle())
+        .to_vk();
+    entry.address = _functions.vkGetAccelerationStructureDeviceAddressKHR(_device, &address_info);
+
+    _entries.push_back(std::move(entry));
+    return static_cast<uint32_t>(_entries.size() - 1);
+}
+
+void BlasBuilder::record(VkCommandBuffer command_buffer) {
+    if (_first_unbuilt == _entries.size()) {
+        return;
+    }
+
+    // split into batches whose scratch fits the budget; [first, last)
+    std::vector<std::pair<size_t, size_t>> batches;
+    VkDeviceSize pool_size = 0;
+    VkDeviceSize batch_size = 0;
+    for (size_t i = _first_unbuilt; i < _entries.size(); ++i) {
+        VkDeviceSize scratch_size = AlignUp(_entries[i].sizes.buildScratchSize, _scratch_alignment);
+        if (batches.empty() || (batch_size > 0 && batch_size + scratch_size > _scratch_budget)) {
+            batches.emplace_back(i, i);
+            batch_size = 0;
+        }
+        batches.back().second = i + 1;
+        batch_size += scratch_size;
+        pool_size = std::max(pool_size, batch_size);
+    }
+
+    if (pool_size > _scratch_size) {
+        if (_scratch.handle() != VK_NULL_HANDLE) {
+            _retired_scratch.push_back(std::move(_scratch));
+        }
+        // the allocation is only guaranteed the buffer's own alignment
+        _scratch = Buffer(_allocator,
+            BufferCreateInfo{}
+                .set_size(pool_size + _scratch_alignment)
+                .set_usage(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                           VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+                .to_vk(),
+            AllocationCreateInfo{}
+                .set_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                .to_vk()
+        );
+        VkBufferDeviceAddressInfo scratch_address_info = BufferDeviceAddressInfo{}
+            .set_buffer(_scratch.handle())
+            .to_vk();
+        _scratch_address = AlignUp(vkGetBufferDeviceAddress(_device, &scratch_address_info), _scratch_alignment);
+        _scratch_size = pool_size;
+    }
+
+    std::vector<VkAccelerationStructureBuildGeometryInfoKHR> build_infos;
+    std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> range_ptrs;
+    for (const auto& [first, last] : batches) {
+        if (_is_scratch_used) {
+            RecordBuildBarrier(command_buffer);
+        }
+
+        build_infos.clear();
+        range_ptrs.clear();
+        VkDeviceSize scratch_offset = 0;
+        for (size_t i = first; i < last; ++i) {
+            const Entry& entry = _entries[i];
+            build_infos.push_back(AccelerationStructureBuildGeometryInfo{}
+                .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
+                .set_flags(entry.input.flags)
+                .set_mode(VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR)
+                .set_geometries(static_cast<uint32_t>(entry.input.geometries.size()), entry.input.geometries.data())
+                .set_dst_acceleration_structure(entry.acceleration_structure.handle())
+                .set_scratch_data(
+                    DeviceOrHostAddress{}
+                        .set_device_address(_scratch_address + scratch_offset)
+                        .to_vk()
+                )
+                .to_vk());
+            range_ptrs.push_back(entry.input.ranges.data());
+            scratch_offset += AlignUp(entry.sizes.buildScratchSize, _scratch_alignment);
+        }
+
+        _functions.vkCmdBuildAccelerationStructuresKHR(command_buffer,
+            static_cast<uint32_t>(build_infos.size()), build_infos.data(), range_ptrs.data());
+        _is_scratch_used = true;
+    }
+    RecordBuildBarrier(command_buffer);
+
+    if (_allow_compaction) {
+        uint32_t count = static_cast<uint32_t>(_entries.size() - _first_unbuilt);
+        Compaction compaction;
+        compaction.query_pool = QueryPool(_device,
+            QueryPoolCreateInfo{}
+                .set_query_type(VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR)
+                .set_query_count(count)
+                .to_vk()
+        );
+        // reset on the host so compact() can poll the queries before this
+        // command buffer has run
+        vkResetQueryPool(_device, compaction.query_pool.handle(), 0, count);
+        compaction.first = _first_unbuilt;
+        compaction.last = _entries.size();
+
+        std::vector<VkAccelerationStructureKHR> handles;
+        handles.reserve(count);
+        for (size_t i = compaction.first; i < compaction.last; ++i) {
+            handles.push_back(_entries[i].acceleration_structure.handle());
+        }
+        _functions.vkCmdWriteAccelerationStructuresPropertiesKHR(command_buffer,
+            count, handles.data(),
+            VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+            compaction.query_pool.handle(), 0
+        );
+        _compactions.push_back(std::move(compaction));
+    }
+
+    _first_unbuilt = _entries.size();
+}
+
+uint32_t BlasBuilder::compact(VkCommandBuffer command_buffer, DeletionQueue& deletion_queue) {
+    uint32_t compacted = 0;
+    while (!_compactions.empty()) {
+        Compaction& compaction = _compactions.front();
+        uint32_t count = static_cast<uint32_t>(compaction.last - compaction.first);
+
+        // no wait bit: builds still running just leave the rest for a later call
+        std::vector<VkDeviceSize> compacted_sizes(count);
+        VkResult result = vkGetQueryPoolResults(_device, compaction.query_pool.handle(), 0, count,
+            compacted_sizes.size() * sizeof(VkDeviceSize), compacted_sizes.data(), sizeof(VkDeviceSize),
+            VK_QUERY_RESULT_64_BIT);
+        if (result == VK_NOT_READY) {
+            break;
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to get compacted acceleration structure sizes");
+        }
+
+        std::vector<Retired> retired;
+        retired.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Entry& entry = _entries[compaction.first + i];
+
+            Buffer buffer(_allocator,
+                BufferCreateInfo{}
+                    .set_size(compacted_sizes[i])
+                    .set_usage(VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                               VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+                    .to_vk(),
+                AllocationCreateInfo{}
+                    .set_usage(VMA_MEMORY_USAGE_GPU_ONLY)
+                    .to_vk()
+            );
+            AccelerationStructure acceleration_structure(_device, _functions,
+                AccelerationStructureCreateInfo{}
+                    .set_buffer(buffer.handle())
+                    .set_offset(0)
+                    .set_size(compacted_sizes[i])
+                    .set_type(VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR)
+                    .to_vk()
+            );
+
+            VkCopyAccelerationStructureInfoKHR copy_info = CopyAccelerationStructureInfo{}
+                .set_src(entry.acceleration_structure.handle())
+                .set_dst(acceleration_structure.handle())
+                .set_mode(VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR)
+                .to_vk();
+            _functions.vkCmdCopyAccelerationStructureKHR(command_buffer, &copy_info);
+
+            retired.push_back(Retired{ std::move(entry.buffer), std::move(entry.acceleration_structure) });
+            entry.buffer = std::move(buffer);
+            entry.acceleration_structure = std::move(acceleration_structure);
+
+            VkAccelerationStructureDeviceAddressInfoKHR address_info = AccelerationStructureDeviceAddressInfo{}
+                .set_acceleration_structure(entry.acceleration_structure.handle())
+                .to_vk();
+            entry.address = _functions.vkGetAccelerationStructureDeviceAddressKHR(_device, &address_info);
+
+            _compacted_savings += entry.sizes.accelerationStructureSize - std::min(compacted_sizes[i],
+                entry.sizes.accelerationStructureSize);
+            entry.sizes.accelerationStructureSize = compacted_sizes[i];
+        }
+
+        // the copies still read the originals
+        deletion_queue.retire(std::move(retired));
+        compacted += count;
+        _compactions.pop_front();
+    }
+
+    if (compacted > 0) {
+        RecordBuildBarrier(command_buffer);
+    }
+    return compacted;
+}
+
+void BlasBuilder::release_scratch() {
+    _retired_scratch.clear();
+    _scratch = Buffer();
+    _scratch_size = 0;
+    _scratch_address = 0;
+    _is_scratch_used = false;
+}
+
+} // wk::ext::rt
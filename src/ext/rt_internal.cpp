@@ -57,6 +57,12 @@ DeviceFunctions LoadFunctions(VkDevice device) {\
     f.vkCmdBuildAccelerationStructuresKHR =
         reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(
             vkGetDeviceProcAddr(device, "vkCmdBuildAccelerationStructuresKHR"));
+    f.vkCmdCopyAccelerationStructureKHR =
+        reinterpret_cast<PFN_vkCmdCopyAccelerationStructureKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdCopyAccelerationStructureKHR"));
+    f.vkCmdWriteAccelerationStructuresPropertiesKHR =
+        reinterpret_cast<PFN_vkCmdWriteAccelerationStructuresPropertiesKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdWriteAccelerationStructuresPropertiesKHR"));
 
     // Ray tracing pipelines
     f.vkCreateRayTracingPipelinesKHR =
@@ -0,0 +1,105 @@
+#include "../include/wk/ktx2.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wk {
+
+namespace {
+
+const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+struct Ktx2Header {
+    uint8_t identifier[12];
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+    uint64_t sgd_byte_offset;
+    uint64_t sgd_byte_length;
+};
+
+static_assert(sizeof(Ktx2Header) == 80, "ktx2 header must be 80 bytes");
+static_assert(sizeof(Ktx2Level) == 24, "ktx2 level index entry must be 24 bytes");
+
+std::span<const uint8_t> Section(std::span<const uint8_t> file, uint64_t offset, uint64_t length) {
+    if (offset > file.size() || length > file.size() - offset) {
+        throw std::runtime_error("ktx2 section out of bounds");
+    }
+    return file.subspan(offset, length);
+}
+
+}
+
+Ktx2File::Ktx2File(const char* path)
+    : _file(path)
+{
+    std::span<const uint8_t> bytes = _file.bytes();
+
+    Ktx2Header header{};
+    if (bytes.size() < sizeof(header)) {
+        throw std::runtime_error("ktx2 file is truncated");
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+        throw std::runtime_error("file is not a ktx2 texture");
+    }
+    if (header.pixel_width == 0 || (header.pixel_depth > 0 && header.pixel_height == 0)) {
+        throw std::runtime_error("ktx2 texture has invalid dimensions");
+    }
+    if (header.face_count != 1 && header.face_count != 6) {
+        throw std::runtime_error("ktx2 texture has invalid face count");
+    }
+
+    _format = static_cast<VkFormat>(header.vk_format);
+    _type_size = header.type_size;
+    _extent = VkExtent3D{ header.pixel_width, std::max(header.pixel_height, 1u), std::max(header.pixel_depth, 1u) };
+    _image_type = header.pixel_depth > 0 ? VK_IMAGE_TYPE_3D
+        : header.pixel_height > 0 ? VK_IMAGE_TYPE_2D : VK_IMAGE_TYPE_1D;
+    _layer_count = std::max(header.layer_count, 1u);
+    _is_array = header.layer_count > 0;
+    _face_count = header.face_count;
+    _supercompression_scheme = header.supercompression_scheme;
+
+    // a level count of 0 asks the loader to generate mips; only the base is stored
+    uint32_t level_count = std::max(header.level_count, 1u);
+    std::span<const uint8_t> index = Section(bytes, sizeof(header), uint64_t(level_count) * sizeof(Ktx2Level));
+    _levels.resize(level_count);
+    std::memcpy(_levels.data(), index.data(), index.size());
+    for (const Ktx2Level& level : _levels) {
+        Section(bytes, level.byte_offset, level.byte_length);
+    }
+
+    _dfd = Section(bytes, header.dfd_byte_offset, header.dfd_byte_length);
+    _kvd = Section(bytes, header.kvd_byte_offset, header.kvd_byte_length);
+    _sgd = Section(bytes, header.sgd_byte_offset, header.sgd_byte_length);
+}
+
+VkExtent2D FormatBlockExtent(VkFormat format) {
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK) {
+        return { 4, 4 };
+    }
+    if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK) {
+        return { 4, 4 };
+    }
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+        // UNORM and SRGB variants alternate in enum order
+        static const VkExtent2D ASTC_BLOCKS[] = {
+            { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+            { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 }
+        };
+        return ASTC_BLOCKS[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+    }
+    return { 1, 1 };
+}
+
+} // wk
@@ -0,0 +1,104 @@
+#include "../include/wk/mapped_file.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wk {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const char* path) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open mapped file");
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to get mapped file size");
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to create file mapping");
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file");
+    }
+
+    _data = static_cast<const uint8_t*>(view);
+    _size = static_cast<size_t>(size.QuadPart);
+    _file = file;
+    _mapping = mapping;
+}
+
+void MappedFile::_unmap() {
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping) {
+        CloseHandle(static_cast<HANDLE>(_mapping));
+    }
+    if (_file) {
+        CloseHandle(static_cast<HANDLE>(_file));
+    }
+    _data = nullptr;
+    _size = 0;
+    _file = nullptr;
+    _mapping = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open mapped file");
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("failed to get mapped file size");
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("failed to map file");
+    }
+
+    _data = static_cast<const uint8_t*>(view);
+    _size = static_cast<size_t>(st.st_size);
+}
+
+void MappedFile::_unmap() {
+    if (_data) {
+        munmap(const_cast<uint8_t*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+}
+
+#endif
+
+} // wk
@@ -0,0 +1,105 @@
+#include "../include/wk/pipeline_manifest.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace wk {
+
+// Manifest layout (little endian):
+//   header  { u32 magic 'WKPM', u32 version, u32 entry_count }
+//   entries { u32 kind, u32 key_size, u8 key[key_size] }[entry_count]
+namespace {
+
+constexpr uint32_t MANIFEST_MAGIC = 0x4D504B57;
+constexpr uint32_t MANIFEST_VERSION = 1;
+
+template<typename T>
+bool ReadValue(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template<typename T>
+void WriteValue(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}
+
+bool PipelineManifest::load(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    const std::streamoff file_size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    uint32_t magic = 0, version = 0, count = 0;
+    if (!ReadValue(file, magic) || !ReadValue(file, version) || !ReadValue(file, count)
+        || magic != MANIFEST_MAGIC || version != MANIFEST_VERSION) {
+        return false;
+    }
+
+    // sizes come from the file, so check them against what is left before allocating
+    auto remaining = [&] { return static_cast<uint64_t>(file_size - file.tellg()); };
+    if (uint64_t(count) * 2 * sizeof(uint32_t) > remaining()) {
+        return false;
+    }
+
+    std::vector<PipelineManifestEntry> loaded;
+    loaded.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        PipelineManifestEntry entry;
+        uint32_t size = 0;
+        if (!ReadValue(file, entry.kind) || !ReadValue(file, size) || size > remaining()) {
+            return false;
+        }
+        entry.key.resize(size);
+        if (!file.read(reinterpret_cast<char*>(entry.key.data()), size)) {
+            return false;
+        }
+        loaded.push_back(std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(*_mutex);
+    for (PipelineManifestEntry& entry : loaded) {
+        _entries.insert(std::move(entry));
+    }
+    return true;
+}
+
+void PipelineManifest::save(const char* path) const {
+    // write beside the target and rename, so a crash never leaves half a manifest
+    std::filesystem::path target(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open pipeline manifest for writing");
+        }
+
+        std::lock_guard<std::mutex> lock(*_mutex);
+        WriteValue(file, MANIFEST_MAGIC);
+        WriteValue(file, MANIFEST_VERSION);
+        WriteValue(file, static_cast<uint32_t>(_entries.size()));
+        for (const PipelineManifestEntry& entry : _entries) {
+            WriteValue(file, entry.kind);
+            WriteValue(file, static_cast<uint32_t>(entry.key.size()));
+            file.write(reinterpret_cast<const char*>(entry.key.data()), entry.key.size());
+        }
+        if (!file) {
+            throw std::runtime_error("failed to write pipeline manifest");
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, target, ec);
+    if (ec) {
+        throw std::runtime_error("failed to replace pipeline manifest");
+    }
+}
+
+} // wk
@@ -0,0 +1,195 @@
+#include "../include/wk/present_controller.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace wk {
+
+namespace {
+
+constexpr uint64_t PRESENT_WAIT_TIMEOUT_NS = 100'000'000;
+
+// completions closer together than this were already done when waited on
+constexpr std::chrono::nanoseconds MIN_INTERVAL = std::chrono::milliseconds(1);
+constexpr size_t INTERVAL_HISTORY = 32;
+
+// pacing delay: grows a little on every frame that makes its vblank, halves
+// on every one that doesn't, and always leaves some headroom before vblank
+constexpr std::chrono::nanoseconds DELAY_STEP = std::chrono::microseconds(250);
+constexpr std::chrono::nanoseconds DELAY_HEADROOM = std::chrono::milliseconds(2);
+
+// Balanced mode: add a frame in flight after MISSES_TO_GROW misses within
+// MISS_WINDOW frames, drop one after FRAMES_TO_SHRINK frames without a miss
+constexpr uint32_t MISS_WINDOW = 60;
+constexpr uint32_t MISSES_TO_GROW = 3;
+constexpr uint32_t FRAMES_TO_SHRINK = 240;
+
+}
+
+PresentController::PresentController(VkDevice device, const DeviceFunctions& f, bool present_wait_enabled,
+    uint32_t max_frames_in_flight, LatencyMode mode)
+    : _device(device), _max_frames_in_flight(max_frames_in_flight)
+{
+    if (max_frames_in_flight == 0) {
+        throw std::runtime_error("present controller needs at least one frame in flight");
+    }
+    if (present_wait_enabled) {
+        if (!f.vkWaitForPresentKHR) {
+            throw std::runtime_error("vkWaitForPresentKHR was not loaded");
+        }
+        _wait_for_present = f.vkWaitForPresentKHR;
+    }
+    _frames_in_flight = max_frames_in_flight;
+    set_mode(mode);
+}
+
+void PresentController::set_mode(LatencyMode mode) {
+    _mode = mode;
+    if (_wait_for_present) {
+        switch (mode) {
+        case LatencyMode::LowLatency:
+        case LatencyMode::Balanced:
+            // Balanced starts paced like LowLatency; misses add frames in flight
+            _frames_in_flight = 1;
+            break;
+        case LatencyMode::Throughput:
+            _frames_in_flight = _max_frames_in_flight;
+            break;
+        }
+    }
+    _delay = std::chrono::nanoseconds(0);
+    _last_completion = {};
+    _frames_since_change = 0;
+    _recent_misses = 0;
+    _clean_frames = 0;
+}
+
+VkPresentModeKHR PresentController::choose_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes) const {
+    // FIFO is what makes completions line up with vblank
+    if (_mode != LatencyMode::Throughput) {
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+    return ChooseSurfacePresentationMode(available_present_modes);
+}
+
+VkResult PresentController::wait_for_frame(VkSwapchainKHR swapchain) {
+    if (!_wait_for_present || _issued < _frames_in_flight) {
+        return VK_SUCCESS;
+    }
+
+    // leaves frames_in_flight - 1 presents queued, plus the frame about to start
+    uint64_t target = _issued + 1 - _frames_in_flight;
+    if (target <= _completed) {
+        return VK_SUCCESS;
+    }
+
+    VkResult result = _wait_for_present(_device, swapchain, target, PRESENT_WAIT_TIMEOUT_NS);
+    Clock::time_point now = Clock::now();
+
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        if (result != VK_TIMEOUT && result != VK_ERROR_OUT_OF_DATE_KHR && result != VK_ERROR_SURFACE_LOST_KHR) {
+            throw std::runtime_error("failed to wait for present");
+        }
+        // the target is still outstanding, so the next call waits for it
+        // again; timing restarts since this gap says nothing about the display
+        _last_completion = {};
+        return result;
+    }
+    // suboptimal presents were still shown
+    _completed = target;
+
+    bool missed = false;
+    if (_last_completion != Clock::time_point{}) {
+        Clock::duration elapsed = now - _last_completion;
+        if (elapsed >= MIN_INTERVAL) {
+            if (_intervals.size() < INTERVAL_HISTORY) {
+                _intervals.push_back(elapsed);
+            } else {
+                _intervals[_interval_cursor] = elapsed;
+                _interval_cursor = (_interval_cursor + 1) % INTERVAL_HISTORY;
+            }
+            // a frame that made its vblank completes one refresh after the last
+            _refresh_interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                *std::min_element(_intervals.begin(), _intervals.end()));
+        }
+        missed = _refresh_interval.count() > 0 && elapsed * 2 > _refresh_interval * 3;
+    }
+    _last_completion = now;
+
+    // the last present is already on screen, so any delay only shortens how
+    // long the next frame waits for vblank once it is done
+    bool is_pacing = _mode != LatencyMode::Throughput && _frames_in_flight == 1;
+    _on_frame(missed);
+    if (is_pacing && _frames_in_flight == 1 && _delay.count() > 0) {
+        std::this_thread::sleep_until(now + _delay);
+    }
+    return result;
+}
+
+const void* PresentController::chain_present_id(const void* p_next) {
+    if (!_wait_for_present) {
+        return p_next;
+    }
+
+    ++_issued;
+    _present_id = {};
+    _present_id.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    _present_id.pNext = p_next;
+    _present_id.swapchainCount = 1;
+    _present_id.pPresentIds = &_issued;
+    return &_present_id;
+}
+
+void PresentController::reset() {
+    _issued = 0;
+    _completed = 0;
+    _last_completion = {};
+    // may be on another display now; the estimate is kept until new samples replace it
+    _intervals.clear();
+    _interval_cursor = 0;
+}
+
+void PresentController::_on_frame(bool missed) {
+    if (_mode != LatencyMode::Throughput && _frames_in_flight == 1 && _refresh_interval.count() > 0) {
+        if (missed) {
+            _delay /= 2;
+        } else {
+            std::chrono::nanoseconds limit = std::max(_refresh_interval - DELAY_HEADROOM, std::chrono::nanoseconds(0));
+            _delay = std::min(_delay + DELAY_STEP, limit);
+        }
+    }
+
+    if (_mode != LatencyMode::Balanced) {
+        return;
+    }
+
+    ++_frames_since_change;
+    if (missed) {
+        ++_recent_misses;
+        _clean_frames = 0;
+    } else {
+        ++_clean_frames;
+    }
+
+    uint32_t frames_in_flight = _frames_in_flight;
+    if (_recent_misses >= MISSES_TO_GROW && _frames_in_flight < _max_frames_in_flight) {
+        ++frames_in_flight;
+    } else if (_clean_frames >= FRAMES_TO_SHRINK && _frames_in_flight > 1) {
+        --frames_in_flight;
+    }
+
+    if (frames_in_flight != _frames_in_flight) {
+        _frames_in_flight = frames_in_flight;
+        // completions straddling the change say nothing about the display
+        _delay = std::chrono::nanoseconds(0);
+        _last_completion = {};
+        _frames_since_change = 0;
+        _recent_misses = 0;
+        _clean_frames = 0;
+    } else if (_frames_since_change >= MISS_WINDOW) {
+        _frames_since_change = 0;
+        _recent_misses = 0;
+    }
+}
+
+} // wk
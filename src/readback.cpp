@@ -0,0 +1,256 @@
+#include "../include/wk/readback.hpp"
+#include "../include/wk/sync.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+namespace wk {
+
+namespace {
+
+// how long the worker blocks in vkWaitSemaphores before checking for shutdown
+constexpr uint64_t WAIT_TIMEOUT_NS = 10'000'000;
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+Readback::Readback(VkDevice device, VmaAllocator allocator, uint32_t frame_count, VkDeviceSize bytes_per_frame)
+    : _device(device), _allocator(allocator), _bytes_per_frame(bytes_per_frame)
+{
+    if (frame_count == 0 || bytes_per_frame == 0) {
+        throw std::runtime_error("readback needs at least one frame and a non-zero size");
+    }
+
+    _buffer = Buffer(allocator,
+        BufferCreateInfo{}
+            .set_size(bytes_per_frame * frame_count)
+            .set_usage(VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+            .set_sharing_mode(VK_SHARING_MODE_EXCLUSIVE)
+            .to_vk(),
+        AllocationCreateInfo{}
+            .set_usage(VMA_MEMORY_USAGE_AUTO)
+            .set_flags(VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT)
+            .set_preferred_flags(VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
+            .to_vk()
+    );
+
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(allocator, _buffer.allocation(), &info);
+    _p_mapped = static_cast<uint8_t*>(info.pMappedData);
+
+    VkSemaphoreTypeCreateInfo type_ci = SemaphoreTypeCreateInfo{}
+        .set_semaphore_type(VK_SEMAPHORE_TYPE_TIMELINE)
+        .set_initial_value(0)
+        .to_vk();
+    _semaphore = Semaphore(device,
+        SemaphoreCreateInfo{}
+            .set_p_next(&type_ci)
+            .to_vk()
+    );
+
+    _state = std::make_shared<State>();
+    _state->outstanding.assign(frame_count, 0);
+    _worker = std::thread(&Readback::_work, std::ref(*_state), device, allocator, _buffer.allocation(),
+        _semaphore.handle(), _p_mapped);
+}
+
+VkResult Readback::result() const {
+    if (!_state) {
+        return VK_SUCCESS;
+    }
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->result;
+}
+
+uint64_t Readback::begin_frame(uint32_t frame_index) {
+    if (!_recorded.empty()) {
+        throw std::runtime_error("readback frame was not ended");
+    }
+    if (frame_index >= _state->outstanding.size()) {
+        throw std::runtime_error("readback frame index out of range");
+    }
+
+    // The slot's previous frame has finished on the GPU by now, so this only
+    // waits for the worker to copy it out, if at all.
+    {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        _state->cv.wait(lock, [&] { return _state->stop || _state->outstanding[frame_index] == 0; });
+        if (_state->stop) {
+            throw std::runtime_error("readback worker has stopped");
+        }
+    }
+
+    _frame_index = frame_index;
+    _cursor = 0;
+    return ++_value;
+}
+
+ReadbackFuture Readback::read_image(CommandEncoder& encoder, VkImage image, VkImageLayout layout,
+    const VkImageSubresourceLayers& subresource, VkOffset3D offset, VkExtent3D extent, uint32_t texel_size)
+{
+    VkDeviceSize size = VkDeviceSize(extent.width) * extent.height * extent.depth * subresource.layerCount * texel_size;
+    // buffer offsets have to be a multiple of the texel size and of 4
+    VkDeviceSize buffer_offset = _allocate(size, VkDeviceSize(texel_size) * 4);
+
+    VkBufferImageCopy2 region{};
+    region.sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2;
+    region.bufferOffset = buffer_offset;
+    region.imageSubresource = subresource;
+    region.imageOffset = offset;
+    region.imageExtent = extent;
+
+    VkCopyImageToBufferInfo2 info{};
+    info.sType = VK_STRUCTURE_TYPE_COPY_IMAGE_TO_BUFFER_INFO_2;
+    info.srcImage = image;
+    info.srcImageLayout = layout;
+    info.dstBuffer = _buffer.handle();
+    info.regionCount = 1;
+    info.pRegions = &region;
+    encoder.copy_image_to_buffer(info);
+
+    Pending pending{ _value, _frame_index, buffer_offset, size, {} };
+    ReadbackFuture future = pending.promise.get_future();
+    _recorded.push_back(std::move(pending));
+    return future;
+}
+
+ReadbackFuture Readback::read_buffer(CommandEncoder& encoder, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+    VkDeviceSize buffer_offset = _allocate(size, 16);
+
+    VkBufferCopy2 region{};
+    region.sType = VK_STRUCTURE_TYPE_BUFFER_COPY_2;
+    region.srcOffset = offset;
+    region.dstOffset = buffer_offset;
+    region.size = size;
+
+    VkCopyBufferInfo2 info{};
+    info.sType = VK_STRUCTURE_TYPE_COPY_BUFFER_INFO_2;
+    info.srcBuffer = buffer;
+    info.dstBuffer = _buffer.handle();
+    info.regionCount = 1;
+    info.pRegions = &region;
+    encoder.copy_buffer(info);
+
+    Pending pending{ _value, _frame_index, buffer_offset, size, {} };
+    ReadbackFuture future = pending.promise.get_future();
+    _recorded.push_back(std::move(pending));
+    return future;
+}
+
+void Readback::end_frame(CommandEncoder& encoder) {
+    if (_recorded.empty()) {
+        return;
+    }
+
+    VkMemoryBarrier2 barrier = MemoryBarrier2{}
+        .set_src_stage(VK_PIPELINE_STAGE_2_COPY_BIT)
+        .set_dst_stage(VK_PIPELINE_STAGE_2_HOST_BIT)
+        .set_src_access(VK_ACCESS_2_TRANSFER_WRITE_BIT)
+        .set_dst_access(VK_ACCESS_2_HOST_READ_BIT)
+        .to_vk();
+    encoder.pipeline_barrier(DependencyInfo{}
+        .set_memory_barriers(1, &barrier)
+        .to_vk());
+
+    {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        _state->outstanding[_frame_index] += static_cast<uint32_t>(_recorded.size());
+        for (Pending& pending : _recorded) {
+            _state->queue.push_back(std::move(pending));
+        }
+    }
+    _recorded.clear();
+    _state->cv.notify_all();
+}
+
+VkDeviceSize Readback::_allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    // the frame's base need not be aligned, so align the absolute offset
+    const VkDeviceSize base = VkDeviceSize(_frame_index) * _bytes_per_frame;
+    VkDeviceSize offset = AlignUp(base + _cursor, alignment) - base;
+    if (size > _bytes_per_frame || offset > _bytes_per_frame - size) {
+        throw std::runtime_error("readback exceeded its per frame size");
+    }
+    _cursor = offset + size;
+    return base + offset;
+}
+
+void Readback::_stop_worker() {
+    if (_state) {
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            _state->stop = true;
+        }
+        _state->cv.notify_all();
+    }
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+}
+
+void Readback::_work(State& state, VkDevice device, VmaAllocator allocator, VmaAllocation allocation,
+    VkSemaphore semaphore, const uint8_t* p_mapped)
+{
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (true) {
+        state.cv.wait(lock, [&state] { return state.stop || !state.queue.empty(); });
+        if (state.stop) {
+            return;
+        }
+
+        // values only grow, so the front is always the next to complete
+        uint64_t value = state.queue.front().value;
+        lock.unlock();
+
+        VkSemaphoreWaitInfo wait_info{};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &semaphore;
+        wait_info.pValues = &value;
+        VkResult result = vkWaitSemaphores(device, &wait_info, WAIT_TIMEOUT_NS);
+
+        lock.lock();
+        if (result == VK_TIMEOUT) {
+            continue;
+        }
+        if (result != VK_SUCCESS) {
+            // every outstanding future gets the error; result() keeps the code
+            state.result = result;
+            state.stop = true;
+            std::deque<Pending> failed = std::move(state.queue);
+            state.queue.clear();
+            std::fill(state.outstanding.begin(), state.outstanding.end(), 0u);
+            state.cv.notify_all();
+            lock.unlock();
+            for (Pending& pending : failed) {
+                pending.promise.set_exception(std::make_exception_ptr(
+                    std::runtime_error("readback failed to wait for timeline semaphore")));
+            }
+            return;
+        }
+
+        std::vector<Pending> done;
+        while (!state.queue.empty() && state.queue.front().value <= value) {
+            done.push_back(std::move(state.queue.front()));
+            state.queue.pop_front();
+        }
+        lock.unlock();
+
+        for (Pending& pending : done) {
+            vmaInvalidateAllocation(allocator, allocation, pending.offset, pending.size);
+            std::vector<uint8_t> data(p_mapped + pending.offset, p_mapped + pending.offset + pending.size);
+            pending.promise.set_value(std::move(data));
+        }
+
+        lock.lock();
+        for (const Pending& pending : done) {
+            --state.outstanding[pending.frame_index];
+        }
+        state.cv.notify_all();
+    }
+}
+
+} // wk
@@ -0,0 +1,186 @@
+#include "../include/wk/shader_pack.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace wk {
+
+namespace {
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+};
+
+struct PackEntry {
+    uint64_t hash;
+    uint64_t code_offset;
+    uint32_t code_size;
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(PackHeader) == 16, "shader pack header must be 16 bytes");
+static_assert(sizeof(PackEntry) == 32, "shader pack entry must be 32 bytes");
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+constexpr uint64_t CODE_ALIGNMENT = 16;
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+uint64_t HashSpirv(const void* p_code, size_t code_size) {
+    // 64 bit FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(p_code);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < code_size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+ShaderPack::ShaderPack(const char* path)
+    : _file(path)
+{
+    const uint8_t* data = _file.data();
+    size_t size = _file.size();
+
+    PackHeader header{};
+    if (size < sizeof(header)) {
+        throw std::runtime_error("shader pack is truncated");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != SHADER_PACK_MAGIC) {
+        throw std::runtime_error("file is not a shader pack");
+    }
+    if (header.version != SHADER_PACK_VERSION) {
+        throw std::runtime_error("unsupported shader pack version");
+    }
+    if (header.entry_count > (size - sizeof(header)) / sizeof(PackEntry)) {
+        throw std::runtime_error("shader pack is truncated");
+    }
+
+    _entries.reserve(header.entry_count);
+    _by_name.reserve(header.entry_count);
+    for (uint32_t i = 0; i < header.entry_count; ++i) {
+        PackEntry e{};
+        std::memcpy(&e, data + sizeof(header) + i * sizeof(PackEntry), sizeof(e));
+
+        if (e.code_offset > size || e.code_size > size - e.code_offset
+            || static_cast<uint64_t>(e.name_offset) + e.name_size > size) {
+            throw std::runtime_error("shader pack entry out of bounds");
+        }
+        if (e.code_offset % 4 != 0 || e.code_size % 4 != 0 || e.code_size == 0) {
+            throw std::runtime_error("shader pack entry is not valid SPIR-V");
+        }
+
+        const uint32_t* code = reinterpret_cast<const uint32_t*>(data + e.code_offset);
+        if (code[0] != SPIRV_MAGIC) {
+            throw std::runtime_error("shader pack entry is not valid SPIR-V");
+        }
+
+        ShaderPackEntry entry;
+        entry.name = std::string_view(reinterpret_cast<const char*>(data + e.name_offset), e.name_size);
+        entry.hash = e.hash;
+        entry.code = std::span<const uint32_t>(code, e.code_size / 4);
+        _entries.push_back(entry);
+    }
+
+    if (!std::is_sorted(_entries.begin(), _entries.end(),
+        [](const ShaderPackEntry& a, const ShaderPackEntry& b) { return a.hash < b.hash; }))
+    {
+        throw std::runtime_error("shader pack index is not sorted");
+    }
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(_entries.size()); ++i) {
+        _by_name.emplace(_entries[i].name, i);
+    }
+}
+
+const ShaderPackEntry* ShaderPack::find(uint64_t hash) const {
+    auto it = std::lower_bound(_entries.begin(), _entries.end(), hash,
+        [](const ShaderPackEntry& e, uint64_t h) { return e.hash < h; });
+    return (it != _entries.end() && it->hash == hash) ? &*it : nullptr;
+}
+
+void WriteShaderPack(const char* path, uint32_t source_count, const ShaderPackSource* p_sources) {
+    std::vector<uint32_t> order(source_count);
+    std::vector<uint64_t> hashes(source_count);
+    for (uint32_t i = 0; i < source_count; ++i) {
+        const ShaderPackSource& s = p_sources[i];
+        if (s.code.empty() || s.code.size() % 4 != 0) {
+            throw std::runtime_error("shader pack source is not valid SPIR-V: " + s.name);
+        }
+        order[i] = i;
+        hashes[i] = HashSpirv(s.code.data(), s.code.size());
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return hashes[a] < hashes[b]; });
+
+    uint64_t names_offset = sizeof(PackHeader) + uint64_t(source_count) * sizeof(PackEntry);
+    uint64_t names_size = 0;
+    for (uint32_t i = 0; i < source_count; ++i) {
+        names_size += p_sources[i].name.size();
+    }
+
+    // identical code is stored once and shared by every name that uses it
+    std::vector<PackEntry> entries(source_count);
+    std::vector<uint32_t> blobs; // source index of each distinct blob, in file order
+    uint64_t name_cursor = names_offset;
+    uint64_t code_cursor = AlignUp(names_offset + names_size, CODE_ALIGNMENT);
+    for (uint32_t n = 0; n < source_count; ++n) {
+        uint32_t i = order[n];
+        const ShaderPackSource& s = p_sources[i];
+        PackEntry& e = entries[n];
+        e.hash = hashes[i];
+        e.code_size = static_cast<uint32_t>(s.code.size());
+        e.name_offset = static_cast<uint32_t>(name_cursor);
+        e.name_size = static_cast<uint32_t>(s.name.size());
+        name_cursor += s.name.size();
+
+        if (n > 0 && entries[n - 1].hash == e.hash) {
+            if (p_sources[order[n - 1]].code != s.code) {
+                throw std::runtime_error("shader pack hash collision: " + s.name);
+            }
+            e.code_offset = entries[n - 1].code_offset;
+            continue;
+        }
+        e.code_offset = code_cursor;
+        code_cursor = AlignUp(code_cursor + s.code.size(), CODE_ALIGNMENT);
+        blobs.push_back(i);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open shader pack for writing");
+    }
+
+    PackHeader header{ SHADER_PACK_MAGIC, SHADER_PACK_VERSION, source_count, 0 };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+    for (uint32_t i : order) {
+        file.write(p_sources[i].name.data(), p_sources[i].name.size());
+    }
+
+    uint64_t cursor = names_offset + names_size;
+    static const char zeros[CODE_ALIGNMENT] = {};
+    for (uint32_t i : blobs) {
+        uint64_t aligned = AlignUp(cursor, CODE_ALIGNMENT);
+        file.write(zeros, aligned - cursor);
+        file.write(reinterpret_cast<const char*>(p_sources[i].code.data()), p_sources[i].code.size());
+        cursor = aligned + p_sources[i].code.size();
+    }
+
+    if (!file) {
+        throw std::runtime_error("failed to write shader pack");
+    }
+}
+
+} // wk
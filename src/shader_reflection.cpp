@@ -0,0 +1,460 @@
+#include "../include/wk/shader_reflection.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+namespace wk {
+
+namespace spv {
+
+constexpr uint32_t MAGIC = 0x07230203;
+
+enum Op : uint32_t {
+    OpEntryPoint = 15,
+    OpExecutionMode = 16,
+    OpTypeBool = 20,
+    OpTypeInt = 21,
+    OpTypeFloat = 22,
+    OpTypeVector = 23,
+    OpTypeMatrix = 24,
+    OpTypeImage = 25,
+    OpTypeSampler = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct = 30,
+    OpTypePointer = 32,
+    OpConstant = 43,
+    OpVariable = 59,
+    OpDecorate = 71,
+    OpMemberDecorate = 72,
+    OpTypeAccelerationStructureKHR = 5341,
+};
+
+enum Decoration : uint32_t {
+    DecorationBlock = 2,
+    DecorationBufferBlock = 3,
+    DecorationRowMajor = 4,
+    DecorationArrayStride = 6,
+    DecorationMatrixStride = 7,
+    DecorationBinding = 33,
+    DecorationDescriptorSet = 34,
+    DecorationOffset = 35,
+};
+
+enum StorageClass : uint32_t {
+    StorageClassUniformConstant = 0,
+    StorageClassUniform = 2,
+    StorageClassPushConstant = 9,
+    StorageClassStorageBuffer = 12,
+};
+
+enum Dim : uint32_t {
+    DimBuffer = 5,
+    DimSubpassData = 6,
+};
+
+constexpr uint32_t ExecutionModeLocalSize = 17;
+
+struct Type {
+    uint32_t op = 0;
+    std::vector<uint32_t> operands; // instruction words after the result id
+};
+
+struct Decorations {
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    bool has_binding = false;
+    bool block = false;
+    bool buffer_block = false;
+    uint32_t array_stride = 0;
+};
+
+struct MemberDecorations {
+    uint32_t offset = 0;
+    uint32_t matrix_stride = 0;
+    bool row_major = false;
+};
+
+struct Variable {
+    uint32_t type = 0;
+    uint32_t storage_class = 0;
+};
+
+}
+
+static VkShaderStageFlags ExecutionModelToStage(uint32_t model) {
+    switch (model) {
+        case 0:    return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1:    return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2:    return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3:    return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4:    return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5:    return VK_SHADER_STAGE_COMPUTE_BIT;
+        case 5267:
+        case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+        case 5268:
+        case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+        case 5313: return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+        case 5314: return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+        case 5315: return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+        case 5316: return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+        case 5317: return VK_SHADER_STAGE_MISS_BIT_KHR;
+        case 5318: return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+        default:   return 0;
+    }
+}
+
+class SpirvModule {
+public:
+    SpirvModule(const uint32_t* p_code, size_t code_size) {
+        if (!p_code || code_size < 5 * sizeof(uint32_t) || code_size % sizeof(uint32_t) != 0) {
+            throw std::runtime_error("invalid spir-v code size");
+        }
+        if (p_code[0] != spv::MAGIC) {
+            throw std::runtime_error("invalid spir-v magic number");
+        }
+
+        const size_t word_count = code_size / sizeof(uint32_t);
+        size_t i = 5;
+        while (i < word_count) {
+            const uint32_t op = p_code[i] & 0xffffu;
+            const uint32_t length = p_code[i] >> 16;
+            if (length == 0 || i + length > word_count) {
+                throw std::runtime_error("malformed spir-v instruction stream");
+            }
+            _parse(op, p_code + i + 1, length - 1);
+            i += length;
+        }
+    }
+
+    ShaderReflection reflect() const {
+        ShaderReflection reflection;
+        reflection.stages = _stages;
+        reflection.entry_points = _entry_points;
+        for (int i = 0; i < 3; ++i) reflection.local_size[i] = _local_size[i];
+
+        for (const auto& [id, variable] : _variables) {
+            if (variable.storage_class == spv::StorageClassPushConstant) {
+                _reflect_push_constant(variable, reflection);
+                continue;
+            }
+            if (variable.storage_class != spv::StorageClassUniformConstant &&
+                variable.storage_class != spv::StorageClassUniform &&
+                variable.storage_class != spv::StorageClassStorageBuffer) {
+                continue;
+            }
+
+            auto decorations = _decorations.find(id);
+            if (decorations == _decorations.end() || !decorations->second.has_binding) continue;
+
+            ReflectedBinding rb{};
+            rb.set = decorations->second.set;
+            rb.binding.binding = decorations->second.binding;
+            rb.binding.stageFlags = _stages;
+
+            // strip the pointer and any array dimensions
+            uint32_t type_id = _pointee(variable.type);
+            uint32_t count = 1;
+            while (true) {
+                const spv::Type& type = _type(type_id);
+                if (type.op == spv::OpTypeArray) {
+                    count *= _constant(type.operands[1]);
+                    type_id = type.operands[0];
+                } else if (type.op == spv::OpTypeRuntimeArray) {
+                    rb.runtime_array = true;
+                    count = 0;
+                    type_id = type.operands[0];
+                } else {
+                    break;
+                }
+            }
+            rb.binding.descriptorCount = count;
+            rb.binding.descriptorType = _descriptor_type(type_id, variable.storage_class);
+            reflection.bindings.push_back(rb);
+        }
+
+        std::sort(reflection.bindings.begin(), reflection.bindings.end(),
+            [](const ReflectedBinding& a, const ReflectedBinding& b) {
+                return a.set != b.set ? a.set < b.set : a.binding.binding < b.binding.binding;
+            });
+        return reflection;
+    }
+
+private:
+    VkShaderStageFlags _stages = 0;
+    std::vector<std::string> _entry_points;
+    uint32_t _local_size[3] = { 0, 0, 0 };
+    std::unordered_map<uint32_t, spv::Type> _types;
+    std::unordered_map<uint32_t, uint32_t> _constants;
+    std::unordered_map<uint32_t, spv::Variable> _variables;
+    std::unordered_map<uint32_t, spv::Decorations> _decorations;
+    std::unordered_map<uint64_t, spv::MemberDecorations> _member_decorations;
+
+    static uint64_t _member_key(uint32_t struct_id, uint32_t member) {
+        return (static_cast<uint64_t>(struct_id) << 32) | member;
+    }
+
+    void _parse(uint32_t op, const uint32_t* w, uint32_t n) {
+        switch (op) {
+            case spv::OpEntryPoint: {
+                if (n < 3) break;
+                _stages |= ExecutionModelToStage(w[0]);
+                const char* name = reinterpret_cast<const char*>(w + 2);
+                _entry_points.emplace_back(name, strnlen(name, (n - 2) * sizeof(uint32_t)));
+                break;
+            }
+            case spv::OpExecutionMode: {
+                if (n >= 5 && w[1] == spv::ExecutionModeLocalSize) {
+                    _local_size[0] = w[2];
+                    _local_size[1] = w[3];
+                    _local_size[2] = w[4];
+                }
+                break;
+            }
+            case spv::OpTypeBool:
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            case spv::OpTypeImage:
+            case spv::OpTypeSampler:
+            case spv::OpTypeSampledImage:
+            case spv::OpTypeArray:
+            case spv::OpTypeRuntimeArray:
+            case spv::OpTypeStruct:
+            case spv::OpTypeAccelerationStructureKHR: {
+                if (n < 1) break;
+                _types[w[0]] = spv::Type{ op, std::vector<uint32_t>(w + 1, w + n) };
+                break;
+            }
+            case spv::OpTypePointer: {
+                // operands: storage class, pointee type
+                if (n < 3) break;
+                _types[w[0]] = spv::Type{ op, { w[1], w[2] } };
+                break;
+            }
+            case spv::OpConstant: {
+                // result type, result id, low word
+                if (n < 3) break;
+                _constants[w[1]] = w[2];
+                break;
+            }
+            case spv::OpVariable: {
+                // result type, result id, storage class
+                if (n < 3) break;
+                _variables[w[1]] = spv::Variable{ w[0], w[2] };
+                break;
+            }
+            case spv::OpDecorate: {
+                if (n < 2) break;
+                spv::Decorations& d = _decorations[w[0]];
+                switch (w[1]) {
+                    case spv::DecorationDescriptorSet: if (n >= 3) d.set = w[2]; break;
+                    case spv::DecorationBinding:       if (n >= 3) { d.binding = w[2]; d.has_binding = true; } break;
+                    case spv::DecorationBlock:         d.block = true; break;
+                    case spv::DecorationBufferBlock:   d.buffer_block = true; break;
+                    case spv::DecorationArrayStride:   if (n >= 3) d.array_stride = w[2]; break;
+                    default: break;
+                }
+                break;
+            }
+            case spv::OpMemberDecorate: {
+                if (n < 3) break;
+                spv::MemberDecorations& d = _member_decorations[_member_key(w[0], w[1])];
+                switch (w[2]) {
+                    case spv::DecorationOffset:       if (n >= 4) d.offset = w[3]; break;
+                    case spv::DecorationMatrixStride: if (n >= 4) d.matrix_stride = w[3]; break;
+                    case spv::DecorationRowMajor:     d.row_major = true; break;
+                    default: break;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    const spv::Type& _type(uint32_t id) const {
+        auto it = _types.find(id);
+        if (it == _types.end()) {
+            throw std::runtime_error("spir-v references an undeclared type");
+        }
+        return it->second;
+    }
+
+    uint32_t _pointee(uint32_t pointer_type) const {
+        const spv::Type& type = _type(pointer_type);
+        if (type.op != spv::OpTypePointer) {
+            throw std::runtime_error("spir-v variable is not a pointer");
+        }
+        return type.operands[1];
+    }
+
+    uint32_t _constant(uint32_t id) const {
+        auto it = _constants.find(id);
+        if (it == _constants.end()) {
+            throw std::runtime_error("spir-v array length is not a constant; specialization constant lengths are unsupported");
+        }
+        return it->second;
+    }
+
+    bool _has_decoration(uint32_t id, bool spv::Decorations::* flag) const {
+        auto it = _decorations.find(id);
+        return it != _decorations.end() && it->second.*flag;
+    }
+
+    VkDescriptorType _descriptor_type(uint32_t type_id, uint32_t storage_class) const {
+        const spv::Type& type = _type(type_id);
+
+        if (storage_class == spv::StorageClassStorageBuffer) {
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        }
+        if (storage_class == spv::StorageClassUniform) {
+            return _has_decoration(type_id, &spv::Decorations::buffer_block)
+                ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
+
+        switch (type.op) {
+            case spv::OpTypeSampler:
+                return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case spv::OpTypeSampledImage: {
+                const spv::Type& image = _type(type.operands[0]);
+                if (image.operands[1] == spv::DimBuffer) return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            }
+            case spv::OpTypeImage: {
+                // operands: sampled type, dim, depth, arrayed, ms, sampled, format
+                const uint32_t dim = type.operands[1];
+                const uint32_t sampled = type.operands[5];
+                if (dim == spv::DimSubpassData) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                if (dim == spv::DimBuffer) {
+                    return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                }
+                return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            }
+            case spv::OpTypeAccelerationStructureKHR:
+                return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            default:
+                throw std::runtime_error("unsupported spir-v descriptor type");
+        }
+    }
+
+    uint32_t _type_size(uint32_t type_id, const spv::MemberDecorations* member) const {
+        const spv::Type& type = _type(type_id);
+        switch (type.op) {
+            case spv::OpTypeBool:
+                return 4;
+            case spv::OpTypeInt:
+            case spv::OpTypeFloat:
+                return type.operands[0] / 8;
+            case spv::OpTypeVector:
+                return type.operands[1] * _type_size(type.operands[0], nullptr);
+            case spv::OpTypeMatrix: {
+                const uint32_t columns = type.operands[1];
+                const spv::Type& column = _type(type.operands[0]);
+                const uint32_t rows = column.operands[1];
+                if (member && member->matrix_stride) {
+                    return (member->row_major ? rows : columns) * member->matrix_stride;
+                }
+                return columns * _type_size(type.operands[0], nullptr);
+            }
+            case spv::OpTypeArray: {
+                auto it = _decorations.find(type_id);
+                uint32_t stride = (it != _decorations.end()) ? it->second.array_stride : 0;
+                if (stride == 0) stride = _type_size(type.operands[0], member);
+                return _constant(type.operands[1]) * stride;
+            }
+            case spv::OpTypeRuntimeArray:
+                return 0;
+            case spv::OpTypeStruct:
+                return _struct_size(type_id, type);
+            default:
+                return 0;
+        }
+    }
+
+    uint32_t _struct_size(uint32_t struct_id, const spv::Type& type) const {
+        uint32_t size = 0;
+        for (uint32_t m = 0; m < type.operands.size(); ++m) {
+            auto it = _member_decorations.find(_member_key(struct_id, m));
+            const spv::MemberDecorations* md = (it != _member_decorations.end()) ? &it->second : nullptr;
+            const uint32_t offset = md ? md->offset : size;
+            size = std::max(size, offset + _type_size(type.operands[m], md));
+        }
+        return size;
+    }
+
+    void _reflect_push_constant(const spv::Variable& variable, ShaderReflection& reflection) const {
+        const uint32_t struct_id = _pointee(variable.type);
+        const spv::Type& type = _type(struct_id);
+        if (type.op != spv::OpTypeStruct || type.operands.empty()) return;
+
+        uint32_t begin = UINT32_MAX;
+        for (uint32_t m = 0; m < type.operands.size(); ++m) {
+            auto it = _member_decorations.find(_member_key(struct_id, m));
+            begin = std::min(begin, it != _member_decorations.end() ? it->second.offset : 0u);
+        }
+        const uint32_t end = _struct_size(struct_id, type);
+
+        VkPushConstantRange range{};
+        range.stageFlags = _stages;
+        range.offset = begin;
+        range.size = end - begin;
+        reflection.push_constant_ranges.push_back(range);
+    }
+};
+
+ShaderReflection ReflectSpirv(const uint32_t* p_code, size_t code_size) {
+    return SpirvModule(p_code, code_size).reflect();
+}
+
+ShaderReflection MergeShaderReflections(uint32_t count, const ShaderReflection* p_reflections) {
+    ShaderReflection merged;
+    for (uint32_t i = 0; i < count; ++i) {
+        const ShaderReflection& r = p_reflections[i];
+        merged.stages |= r.stages;
+        merged.entry_points.insert(merged.entry_points.end(), r.entry_points.begin(), r.entry_points.end());
+        if (r.stages & VK_SHADER_STAGE_COMPUTE_BIT) {
+            std::copy(std::begin(r.local_size), std::end(r.local_size), std::begin(merged.local_size));
+        }
+
+        for (const ReflectedBinding& b : r.bindings) {
+            auto it = std::find_if(merged.bindings.begin(), merged.bindings.end(), [&](const ReflectedBinding& m) {
+                return m.set == b.set && m.binding.binding == b.binding.binding;
+            });
+            if (it == merged.bindings.end()) {
+                merged.bindings.push_back(b);
+                continue;
+            }
+            if (it->binding.descriptorType != b.binding.descriptorType) {
+                throw std::runtime_error("descriptor type mismatch between shader stages at set " +
+                    std::to_string(b.set) + " binding " + std::to_string(b.binding.binding));
+            }
+            it->binding.stageFlags |= b.binding.stageFlags;
+            it->binding.descriptorCount = std::max(it->binding.descriptorCount, b.binding.descriptorCount);
+            it->runtime_array = it->runtime_array || b.runtime_array;
+        }
+
+        // identical ranges are shared across stages, differing ones stay per stage
+        for (const VkPushConstantRange& range : r.push_constant_ranges) {
+            auto it = std::find_if(merged.push_constant_ranges.begin(), merged.push_constant_ranges.end(),
+                [&](const VkPushConstantRange& m) { return m.offset == range.offset && m.size == range.size; });
+            if (it != merged.push_constant_ranges.end()) {
+                it->stageFlags |= range.stageFlags;
+            } else {
+                merged.push_constant_ranges.push_back(range);
+            }
+        }
+    }
+
+    std::sort(merged.bindings.begin(), merged.bindings.end(),
+        [](const ReflectedBinding& a, const ReflectedBinding& b) {
+            return a.set != b.set ? a.set < b.set : a.binding.binding < b.binding.binding;
+        });
+    return merged;
+}
+
+}
@@ -0,0 +1,449 @@
+#include "../include/wk/texture_streamer.hpp"
+#include "../include/wk/sync.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+namespace wk {
+
+namespace {
+
+// how many levels ahead of the upload the workers may transcode
+constexpr uint32_t TRANSCODE_LOOKAHEAD = 2;
+
+// a level that fails this often is given up on (see has_failed())
+constexpr uint32_t MAX_TRANSCODE_ATTEMPTS = 3;
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkImageViewType ViewType(const Ktx2File& file) {
+    if (file.is_cube()) {
+        return file.is_array() ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+    }
+    switch (file.image_type()) {
+    case VK_IMAGE_TYPE_1D: return file.is_array() ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+    case VK_IMAGE_TYPE_3D: return VK_IMAGE_VIEW_TYPE_3D;
+    default: return file.is_array() ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    }
+}
+
+// How a level's bytes map onto copy regions: slices (layer, face, depth) of
+// block rows, each row block_count texel blocks wide.
+struct LevelLayout {
+    VkExtent3D extent;
+    VkExtent2D block;
+    uint32_t block_rows;
+    uint32_t slice_count;
+    VkDeviceSize slice_bytes;
+    VkDeviceSize row_bytes;
+    VkDeviceSize block_bytes;
+};
+
+LevelLayout ComputeLevelLayout(const Ktx2File& file, VkFormat format, uint32_t level, VkDeviceSize size) {
+    LevelLayout layout{};
+    layout.extent = file.level_extent(level);
+    layout.block = FormatBlockExtent(format);
+    uint32_t block_count = (layout.extent.width + layout.block.width - 1) / layout.block.width;
+    layout.block_rows = (layout.extent.height + layout.block.height - 1) / layout.block.height;
+    layout.slice_count = file.layer_count() * file.face_count() * layout.extent.depth;
+
+    VkDeviceSize blocks = VkDeviceSize(block_count) * layout.block_rows * layout.slice_count;
+    if (size == 0 || size % blocks != 0) {
+        throw std::runtime_error("ktx2 level size does not match its extent");
+    }
+    layout.block_bytes = size / blocks;
+    layout.row_bytes = layout.block_bytes * block_count;
+    layout.slice_bytes = layout.row_bytes * layout.block_rows;
+    return layout;
+}
+
+// Every row of a level has to fit in one frame's budget, after aligning the
+// buffer offset to a multiple of the block size and of 4.
+void CheckLevel(const Ktx2File& file, VkFormat format, uint32_t level, VkDeviceSize size, VkDeviceSize bytes_per_frame) {
+    LevelLayout layout = ComputeLevelLayout(file, format, level, size);
+    if (layout.row_bytes + layout.block_bytes * 4 > bytes_per_frame) {
+        throw std::runtime_error("texture row does not fit in the streaming budget");
+    }
+}
+
+}
+
+TextureStreamer::TextureStreamer(VkDevice device, VmaAllocator allocator, uint32_t frame_count, VkDeviceSize bytes_per_frame,
+    uint32_t worker_count, TextureTranscoder transcoder)
+    : _device(device), _allocator(allocator), _frame_count(frame_count), _bytes_per_frame(bytes_per_frame)
+{
+    if (frame_count == 0 || bytes_per_frame == 0) {
+        throw std::runtime_error("texture streamer needs at least one frame and a non-zero budget");
+    }
+
+    _staging = Buffer(allocator,
+        BufferCreateInfo{}
+            .set_size(bytes_per_frame * frame_count)
+            .set_usage(VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+            .set_sharing_mode(VK_SHARING_MODE_EXCLUSIVE)
+            .to_vk(),
+        AllocationCreateInfo{}
+            .set_usage(VMA_MEMORY_USAGE_AUTO)
+            .set_flags(VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT)
+            .to_vk()
+    );
+
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(allocator, _staging.allocation(), &info);
+    _p_staging = static_cast<uint8_t*>(info.pMappedData);
+
+    _retired.resize(frame_count);
+
+    _jobs = std::make_shared<Jobs>();
+    _jobs->transcoder = std::move(transcoder);
+    if (_jobs->transcoder.transcode) {
+        for (uint32_t i = 0; i < std::max(worker_count, 1u); ++i) {
+            _workers.emplace_back(&TextureStreamer::_work, std::ref(*_jobs));
+        }
+    }
+}
+
+TextureId TextureStreamer::load(const char* path) {
+    auto source = std::make_shared<Source>();
+    source->file = std::make_unique<Ktx2File>(path);
+    const Ktx2File& file = *source->file;
+
+    Texture texture{};
+    texture.transcoded = file.needs_transcoding();
+    texture.format = file.format();
+    if (texture.transcoded) {
+        if (!_jobs || !_jobs->transcoder.transcode || !_jobs->transcoder.target_format) {
+            throw std::runtime_error("ktx2 texture needs a transcoder");
+        }
+        texture.format = _jobs->transcoder.target_format(file);
+        source->levels.resize(file.level_count());
+        // transcoded levels are checked by the workers as they come in
+        source->format = texture.format;
+        source->bytes_per_frame = _bytes_per_frame;
+    }
+    texture.view_type = ViewType(file);
+    texture.level_count = file.level_count();
+    texture.layer_count = file.layer_count() * file.face_count();
+    texture.resident_level = texture.level_count;
+
+    if (!texture.transcoded) {
+        for (uint32_t level = 0; level < texture.level_count; ++level) {
+            CheckLevel(file, texture.format, level, file.level(level).byte_length, _bytes_per_frame);
+        }
+    }
+
+    texture.image = Image(_allocator,
+        ImageCreateInfo{}
+            .set_flags(file.is_cube() ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0)
+            .set_image_type(file.image_type())
+            .set_format(texture.format)
+            .set_extent(file.extent())
+            .set_mip_levels(texture.level_count)
+            .set_array_layers(texture.layer_count)
+            .set_samples(VK_SAMPLE_COUNT_1_BIT)
+            .set_tiling(VK_IMAGE_TILING_OPTIMAL)
+            .set_usage(VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+            .set_sharing_mode(VK_SHARING_MODE_EXCLUSIVE)
+            .set_initial_layout(VK_IMAGE_LAYOUT_UNDEFINED)
+            .to_vk(),
+        AllocationCreateInfo{}
+            .set_usage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+            .to_vk()
+    );
+    texture.source = std::move(source);
+    texture.alive = true;
+
+    TextureId id;
+    if (!_free_ids.empty()) {
+        id = _free_ids.back();
+        _free_ids.pop_back();
+        _textures[id] = std::move(texture);
+    } else {
+        id = static_cast<TextureId>(_textures.size());
+        _textures.push_back(std::move(texture));
+    }
+    _request_levels(_textures[id]);
+    return id;
+}
+
+void TextureStreamer::update(CommandEncoder& encoder, uint32_t frame_index) {
+    Retired& retired = _retired.at(frame_index);
+    retired.views.clear();
+    retired.images.clear();
+
+    struct Copy {
+        VkImage image;
+        VkBufferImageCopy2 region;
+    };
+    std::vector<VkImageMemoryBarrier2> to_transfer;
+    std::vector<VkImageMemoryBarrier2> to_shader;
+    std::vector<Copy> copies;
+
+    const VkDeviceSize base = VkDeviceSize(frame_index) * _bytes_per_frame;
+    VkDeviceSize cursor = 0;
+    bool budget_left = true;
+
+    while (budget_left) {
+        // smallest pending level first, so every texture gets something to
+        // sample before any texture gets detail
+        Texture* p_next = nullptr;
+        VkDeviceSize next_size = 0;
+        for (Texture& texture : _textures) {
+            if (!texture.alive || texture.resident_level == 0) {
+                continue;
+            }
+            _request_levels(texture);
+            std::span<const uint8_t> data = _level_data(texture, texture.resident_level - 1);
+            if (data.empty()) {
+                continue;
+            }
+            // a level already in flight always goes first
+            VkDeviceSize size = texture.uploaded > 0 ? 0 : data.size();
+            if (!p_next || size < next_size) {
+                p_next = &texture;
+                next_size = size;
+            }
+        }
+        if (!p_next) {
+            break;
+        }
+
+        Texture& texture = *p_next;
+        const uint32_t level = texture.resident_level - 1;
+        std::span<const uint8_t> data = _level_data(texture, level);
+        // cannot throw, the level went through CheckLevel() in load() or _work()
+        LevelLayout layout = ComputeLevelLayout(*texture.source->file, texture.format, level, data.size());
+        // buffer offsets have to be a multiple of the block size and of 4
+        const VkDeviceSize alignment = layout.block_bytes * 4;
+
+        if (texture.uploaded == 0) {
+            to_transfer.push_back(ImageMemoryBarrier2{}
+                .set_src_stage(VK_PIPELINE_STAGE_2_NONE)
+                .set_dst_stage(VK_PIPELINE_STAGE_2_COPY_BIT)
+                .set_src_access(VK_ACCESS_2_NONE)
+                .set_dst_access(VK_ACCESS_2_TRANSFER_WRITE_BIT)
+                .set_old_layout(VK_IMAGE_LAYOUT_UNDEFINED)
+                .set_new_layout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+                .set_image(texture.image.handle())
+                .set_aspect(VK_IMAGE_ASPECT_COLOR_BIT)
+                .set_levels(level, 1)
+                .set_layers(0, texture.layer_count)
+                .to_vk());
+        }
+
+        while (texture.uploaded < data.size()) {
+            uint32_t slice = static_cast<uint32_t>(texture.uploaded / layout.slice_bytes);
+            uint32_t row = static_cast<uint32_t>((texture.uploaded % layout.slice_bytes) / layout.row_bytes);
+
+            // aligned within the whole staging buffer, since base need not be
+            VkDeviceSize offset = AlignUp(base + cursor, alignment) - base;
+            VkDeviceSize space = offset < _bytes_per_frame ? _bytes_per_frame - offset : 0;
+            uint32_t rows = static_cast<uint32_t>(std::min<VkDeviceSize>(layout.block_rows - row, space / layout.row_bytes));
+            if (rows == 0) {
+                budget_left = false;
+                break;
+            }
+
+            VkDeviceSize size = VkDeviceSize(rows) * layout.row_bytes;
+            std::memcpy(_p_staging + base + offset, data.data() + texture.uploaded, size);
+
+            VkBufferImageCopy2 region{};
+            region.sType = VK_STRUCTURE_TYPE_BUFFER_IMAGE_COPY_2;
+            region.bufferOffset = base + offset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level;
+            region.imageSubresource.baseArrayLayer = slice / layout.extent.depth;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = VkOffset3D{ 0, static_cast<int32_t>(row * layout.block.height),
+                static_cast<int32_t>(slice % layout.extent.depth) };
+            region.imageExtent = VkExtent3D{
+                layout.extent.width,
+                std::min(rows * layout.block.height, layout.extent.height - row * layout.block.height),
+                1
+            };
+            copies.push_back(Copy{ texture.image.handle(), region });
+
+            cursor = offset + size;
+            texture.uploaded += size;
+        }
+
+        if (texture.uploaded < data.size()) {
+            continue;
+        }
+
+        to_shader.push_back(ImageMemoryBarrier2{}
+            .set_src_stage(VK_PIPELINE_STAGE_2_COPY_BIT)
+            .set_dst_stage(VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+            .set_src_access(VK_ACCESS_2_TRANSFER_WRITE_BIT)
+            .set_dst_access(VK_ACCESS_2_SHADER_SAMPLED_READ_BIT)
+            .set_old_layout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+            .set_new_layout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+            .set_image(texture.image.handle())
+            .set_aspect(VK_IMAGE_ASPECT_COLOR_BIT)
+            .set_levels(level, 1)
+            .set_layers(0, texture.layer_count)
+            .to_vk());
+
+        texture.resident_level = level;
+        texture.uploaded = 0;
+        if (texture.transcoded) {
+            std::lock_guard<std::mutex> lock(_jobs->mutex);
+            std::vector<uint8_t>().swap(texture.source->levels[level].data);
+        }
+        // the old view may still be in use by frames in flight
+        retired.views.push_back(std::move(texture.view));
+        texture.view = _create_view(texture);
+        if (level == 0) {
+            // fully resident, unmap the file
+            texture.source.reset();
+        }
+    }
+
+    if (copies.empty()) {
+        return;
+    }
+
+    vmaFlushAllocation(_allocator, _staging.allocation(), base, cursor);
+
+    encoder.pipeline_barrier(DependencyInfo{}
+        .set_image_barriers(static_cast<uint32_t>(to_transfer.size()), to_transfer.data())
+        .to_vk());
+    for (const Copy& copy : copies) {
+        VkCopyBufferToImageInfo2 info{};
+        info.sType = VK_STRUCTURE_TYPE_COPY_BUFFER_TO_IMAGE_INFO_2;
+        info.srcBuffer = _staging.handle();
+        info.dstImage = copy.image;
+        info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        info.regionCount = 1;
+        info.pRegions = &copy.region;
+        encoder.copy_buffer_to_image(info);
+    }
+    if (!to_shader.empty()) {
+        encoder.pipeline_barrier(DependencyInfo{}
+            .set_image_barriers(static_cast<uint32_t>(to_shader.size()), to_shader.data())
+            .to_vk());
+    }
+}
+
+void TextureStreamer::release(TextureId id, uint32_t frame_index) {
+    _texture(id);
+    Texture& texture = _textures[id];
+    Retired& retired = _retired.at(frame_index);
+    retired.views.push_back(std::move(texture.view));
+    retired.images.push_back(std::move(texture.image));
+    // pending jobs keep the source alive until they finish
+    texture = Texture{};
+    _free_ids.push_back(id);
+}
+
+std::span<const uint8_t> TextureStreamer::_level_data(const Texture& texture, uint32_t level) const {
+    if (!texture.transcoded) {
+        return texture.source->file->level_data(level);
+    }
+    std::lock_guard<std::mutex> lock(_jobs->mutex);
+    const Source::Level& l = texture.source->levels[level];
+    if (!l.ready) {
+        return {};
+    }
+    // the vector is only touched again by update() once the level is uploaded
+    return std::span<const uint8_t>(l.data.data(), l.data.size());
+}
+
+bool TextureStreamer::has_failed(TextureId id) const {
+    const Texture& texture = _texture(id);
+    if (!texture.transcoded || !texture.source || texture.resident_level == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_jobs->mutex);
+    const Source::Level& l = texture.source->levels[texture.resident_level - 1];
+    return l.failed && l.attempts >= MAX_TRANSCODE_ATTEMPTS;
+}
+
+void TextureStreamer::_request_levels(Texture& texture) {
+    if (!texture.transcoded || !texture.source) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_jobs->mutex);
+    uint32_t last = texture.resident_level > TRANSCODE_LOOKAHEAD ? texture.resident_level - TRANSCODE_LOOKAHEAD : 0;
+    for (uint32_t level = texture.resident_level; level-- > last;) {
+        Source::Level& l = texture.source->levels[level];
+        if (l.requested) {
+            continue;
+        }
+        l.requested = true;
+        _jobs->queue.emplace_back(texture.source, level);
+    }
+    _jobs->cv.notify_all();
+}
+
+ImageView TextureStreamer::_create_view(const Texture& texture) const {
+    // only the resident levels, the rest are still UNDEFINED or TRANSFER_DST
+    return ImageView(_device,
+        ImageViewCreateInfo{}
+            .set_image(texture.image.handle())
+            .set_view_type(texture.view_type)
+            .set_format(texture.format)
+            .set_subresource_range(ImageSubresourceRange::color()
+                .set_base_mip_level(texture.resident_level)
+                .set_level_count(texture.level_count - texture.resident_level)
+                .set_layer_count(texture.layer_count)
+                .to_vk())
+            .to_vk()
+    );
+}
+
+void TextureStreamer::_stop_workers() {
+    if (_jobs) {
+        {
+            std::lock_guard<std::mutex> lock(_jobs->mutex);
+            _jobs->stop = true;
+            _jobs->queue.clear();
+        }
+        _jobs->cv.notify_all();
+    }
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+void TextureStreamer::_work(Jobs& jobs) {
+    while (true) {
+        std::shared_ptr<Source> source;
+        uint32_t level = 0;
+        {
+            std::unique_lock<std::mutex> lock(jobs.mutex);
+            jobs.cv.wait(lock, [&jobs] { return jobs.stop || !jobs.queue.empty(); });
+            if (jobs.stop) {
+                return;
+            }
+            std::tie(source, level) = std::move(jobs.queue.front());
+            jobs.queue.pop_front();
+        }
+
+        std::vector<uint8_t> data;
+        bool failed = false;
+        try {
+            data = jobs.transcoder.transcode(*source->file, level);
+            CheckLevel(*source->file, source->format, level, data.size(), source->bytes_per_frame);
+        } catch (const std::exception&) {
+            // retried by _request_levels; callers see give-ups through has_failed()
+            failed = true;
+        }
+
+        std::lock_guard<std::mutex> lock(jobs.mutex);
+        Source::Level& l = source->levels[level];
+        l.failed = failed || data.empty();
+        l.data = l.failed ? std::vector<uint8_t>() : std::move(data);
+        l.ready = !l.failed;
+        // clearing requested lets _request_levels queue the level again
+        if (l.failed && ++l.attempts < MAX_TRANSCODE_ATTEMPTS) {
+            l.requested = false;
+        }
+    }
+}
+
+} // wk
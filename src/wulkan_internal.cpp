@@ -2,7 +2,9 @@
 
 #include "../include/wk/queue.hpp"
 
+#include <algorithm>
 #include <functional>
+#include <cstring>
 
 namespace wk {
 
@@ -352,4 +354,312 @@ void ImmediateSubmit(VkDevice device, uint32_t queueFamilyIndex,
     vkDestroyCommandPool(device, pool, nullptr);
 }
 
-} // wk
\ No newline at end of file
+DeviceFunctions LoadDeviceFunctions(VkDevice device, uint32_t api_version, const std::vector<const char*>& enabled_extensions) {
+    DeviceFunctions f{};
+    f.api_version = api_version;
+
+    auto is_enabled = [&](const char* extension) {
+        return std::any_of(enabled_extensions.begin(), enabled_extensions.end(),
+            [&](const char* e) { return std::strcmp(e, extension) == 0; });
+    };
+    // shader objects expose the dynamic state commands without the extensions
+    const bool shader_object = is_enabled(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+
+    // Extended dynamic state
+    if (shader_object || is_enabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        f.vkCmdSetCullModeEXT =
+            reinterpret_cast<PFN_vkCmdSetCullModeEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetCullModeEXT"));
+        f.vkCmdSetFrontFaceEXT =
+            reinterpret_cast<PFN_vkCmdSetFrontFaceEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetFrontFaceEXT"));
+        f.vkCmdSetPrimitiveTopologyEXT =
+            reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetPrimitiveTopologyEXT"));
+        f.vkCmdSetViewportWithCountEXT =
+            reinterpret_cast<PFN_vkCmdSetViewportWithCountEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetViewportWithCountEXT"));
+        f.vkCmdSetScissorWithCountEXT =
+            reinterpret_cast<PFN_vkCmdSetScissorWithCountEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetScissorWithCountEXT"));
+        f.vkCmdSetDepthTestEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthTestEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthTestEnableEXT"));
+        f.vkCmdSetDepthWriteEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthWriteEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthWriteEnableEXT"));
+        f.vkCmdSetDepthCompareOpEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthCompareOpEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthCompareOpEXT"));
+        f.vkCmdSetDepthBoundsTestEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthBoundsTestEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthBoundsTestEnableEXT"));
+        f.vkCmdSetStencilTestEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetStencilTestEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetStencilTestEnableEXT"));
+        f.vkCmdSetStencilOpEXT =
+            reinterpret_cast<PFN_vkCmdSetStencilOpEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetStencilOpEXT"));
+    }
+
+    // Extended dynamic state 2
+    if (shader_object || is_enabled(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+        f.vkCmdSetRasterizerDiscardEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetRasterizerDiscardEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetRasterizerDiscardEnableEXT"));
+        f.vkCmdSetDepthBiasEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthBiasEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthBiasEnableEXT"));
+        f.vkCmdSetPrimitiveRestartEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetPrimitiveRestartEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetPrimitiveRestartEnableEXT"));
+        f.vkCmdSetPatchControlPointsEXT =
+            reinterpret_cast<PFN_vkCmdSetPatchControlPointsEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetPatchControlPointsEXT"));
+        f.vkCmdSetLogicOpEXT =
+            reinterpret_cast<PFN_vkCmdSetLogicOpEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetLogicOpEXT"));
+    }
+
+    // Extended dynamic state 3
+    if (shader_object || is_enabled(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+        f.vkCmdSetTessellationDomainOriginEXT =
+            reinterpret_cast<PFN_vkCmdSetTessellationDomainOriginEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetTessellationDomainOriginEXT"));
+        f.vkCmdSetDepthClampEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthClampEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthClampEnableEXT"));
+        f.vkCmdSetPolygonModeEXT =
+            reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetPolygonModeEXT"));
+        f.vkCmdSetRasterizationSamplesEXT =
+            reinterpret_cast<PFN_vkCmdSetRasterizationSamplesEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetRasterizationSamplesEXT"));
+        f.vkCmdSetSampleMaskEXT =
+            reinterpret_cast<PFN_vkCmdSetSampleMaskEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetSampleMaskEXT"));
+        f.vkCmdSetAlphaToCoverageEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetAlphaToCoverageEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetAlphaToCoverageEnableEXT"));
+        f.vkCmdSetAlphaToOneEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetAlphaToOneEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetAlphaToOneEnableEXT"));
+        f.vkCmdSetLogicOpEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetLogicOpEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetLogicOpEnableEXT"));
+        f.vkCmdSetColorBlendEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetColorBlendEnableEXT"));
+        f.vkCmdSetColorBlendEquationEXT =
+            reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetColorBlendEquationEXT"));
+        f.vkCmdSetColorWriteMaskEXT =
+            reinterpret_cast<PFN_vkCmdSetColorWriteMaskEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetColorWriteMaskEXT"));
+        f.vkCmdSetDepthClipEnableEXT =
+            reinterpret_cast<PFN_vkCmdSetDepthClipEnableEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetDepthClipEnableEXT"));
+        f.vkCmdSetLineRasterizationModeEXT =
+            reinterpret_cast<PFN_vkCmdSetLineRasterizationModeEXT>(
+                vkGetDeviceProcAddr(device, "vkCmdSetLineRasterizationModeEXT"));
+    }
+
+    // Shader objects
+    f.vkCreateShadersEXT =
+        reinterpret_cast<PFN_vkCreateShadersEXT>(
+            vkGetDeviceProcAddr(device, "vkCreateShadersEXT"));
+    f.vkDestroyShaderEXT =
+        reinterpret_cast<PFN_vkDestroyShaderEXT>(
+            vkGetDeviceProcAddr(device, "vkDestroyShaderEXT"));
+    f.vkGetShaderBinaryDataEXT =
+        reinterpret_cast<PFN_vkGetShaderBinaryDataEXT>(
+            vkGetDeviceProcAddr(device, "vkGetShaderBinaryDataEXT"));
+    f.vkCmdBindShadersEXT =
+        reinterpret_cast<PFN_vkCmdBindShadersEXT>(
+            vkGetDeviceProcAddr(device, "vkCmdBindShadersEXT"));
+    f.vkCmdSetVertexInputEXT =
+        reinterpret_cast<PFN_vkCmdSetVertexInputEXT>(
+            vkGetDeviceProcAddr(device, "vkCmdSetVertexInputEXT"));
+
+    // Descriptor buffers
+    f.vkGetDescriptorSetLayoutSizeEXT =
+        reinterpret_cast<PFN_vkGetDescriptorSetLayoutSizeEXT>(
+            vkGetDeviceProcAddr(device, "vkGetDescriptorSetLayoutSizeEXT"));
+    f.vkGetDescriptorSetLayoutBindingOffsetEXT =
+        reinterpret_cast<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(
+            vkGetDeviceProcAddr(device, "vkGetDescriptorSetLayoutBindingOffsetEXT"));
+    f.vkGetDescriptorEXT =
+        reinterpret_cast<PFN_vkGetDescriptorEXT>(
+            vkGetDeviceProcAddr(device, "vkGetDescriptorEXT"));
+    f.vkCmdBindDescriptorBuffersEXT =
+        reinterpret_cast<PFN_vkCmdBindDescriptorBuffersEXT>(
+            vkGetDeviceProcAddr(device, "vkCmdBindDescriptorBuffersEXT"));
+    f.vkCmdSetDescriptorBufferOffsetsEXT =
+        reinterpret_cast<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(
+            vkGetDeviceProcAddr(device, "vkCmdSetDescriptorBufferOffsetsEXT"));
+
+    // Push descriptors
+    f.vkCmdPushDescriptorSetKHR =
+        reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR"));
+    f.vkCmdPushDescriptorSetWithTemplateKHR =
+        reinterpret_cast<PFN_vkCmdPushDescriptorSetWithTemplateKHR>(
+            vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetWithTemplateKHR"));
+
+    // Present wait
+    f.vkWaitForPresentKHR =
+        reinterpret_cast<PFN_vkWaitForPresentKHR>(
+            vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+
+    return f;
+}
+
+void QueryExtendedDynamicStateSupport(VkPhysicalDevice physical_device, ExtendedDynamicStateSupport& support) {
+    support.eds1 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT };
+    support.eds2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT };
+    support.eds3 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT };
+    support.extensions.clear();
+    support.p_next = nullptr;
+
+    // the base states of eds1 and eds2 were promoted to core in 1.3
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physical_device, &props);
+    support.core_eds1 = props.apiVersion >= VK_API_VERSION_1_3;
+    support.core_eds2 = props.apiVersion >= VK_API_VERSION_1_3;
+
+    // only chain structs whose extension is present
+    void** tail = &support.p_next;
+    auto append = [&](const char* extension, auto& feature) {
+        if (!IsPhysicalDeviceExtensionSupported(physical_device, { extension })) return;
+        support.extensions.push_back(extension);
+        *tail = &feature;
+        tail = &feature.pNext;
+    };
+    append(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME, support.eds1);
+    append(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME, support.eds2);
+    append(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME, support.eds3);
+
+    if (!support.p_next) return;
+
+    VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    features2.pNext = support.p_next;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+}
+
+bool IsDynamicStateSupported(const ExtendedDynamicStateSupport& support, VkDynamicState state) {
+    const bool eds1 = support.core_eds1 || support.eds1.extendedDynamicState;
+    const bool eds2 = support.core_eds2 || support.eds2.extendedDynamicState2;
+    const VkPhysicalDeviceExtendedDynamicState3FeaturesEXT& eds3 = support.eds3;
+
+    switch (state) {
+        case VK_DYNAMIC_STATE_VIEWPORT:
+        case VK_DYNAMIC_STATE_SCISSOR:
+        case VK_DYNAMIC_STATE_LINE_WIDTH:
+        case VK_DYNAMIC_STATE_DEPTH_BIAS:
+        case VK_DYNAMIC_STATE_BLEND_CONSTANTS:
+        case VK_DYNAMIC_STATE_DEPTH_BOUNDS:
+        case VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK:
+        case VK_DYNAMIC_STATE_STENCIL_WRITE_MASK:
+        case VK_DYNAMIC_STATE_STENCIL_REFERENCE:
+            return true;
+
+        case VK_DYNAMIC_STATE_CULL_MODE:
+        case VK_DYNAMIC_STATE_FRONT_FACE:
+        case VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY:
+        case VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT:
+        case VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT:
+        case VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE:
+        case VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE:
+        case VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE:
+        case VK_DYNAMIC_STATE_DEPTH_COMPARE_OP:
+        case VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE:
+        case VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE:
+        case VK_DYNAMIC_STATE_STENCIL_OP:
+            return eds1;
+
+        case VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE:
+        case VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE:
+        case VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE:
+            return eds2;
+        case VK_DYNAMIC_STATE_LOGIC_OP_EXT:
+            return support.eds2.extendedDynamicState2LogicOp;
+        case VK_DYNAMIC_STATE_PATCH_CONTROL_POINTS_EXT:
+            return support.eds2.extendedDynamicState2PatchControlPoints;
+
+        case VK_DYNAMIC_STATE_TESSELLATION_DOMAIN_ORIGIN_EXT: return eds3.extendedDynamicState3TessellationDomainOrigin;
+        case VK_DYNAMIC_STATE_DEPTH_CLAMP_ENABLE_EXT:         return eds3.extendedDynamicState3DepthClampEnable;
+        case VK_DYNAMIC_STATE_POLYGON_MODE_EXT:               return eds3.extendedDynamicState3PolygonMode;
+        case VK_DYNAMIC_STATE_RASTERIZATION_SAMPLES_EXT:      return eds3.extendedDynamicState3RasterizationSamples;
+        case VK_DYNAMIC_STATE_SAMPLE_MASK_EXT:                return eds3.extendedDynamicState3SampleMask;
+        case VK_DYNAMIC_STATE_ALPHA_TO_COVERAGE_ENABLE_EXT:   return eds3.extendedDynamicState3AlphaToCoverageEnable;
+        case VK_DYNAMIC_STATE_ALPHA_TO_ONE_ENABLE_EXT:        return eds3.extendedDynamicState3AlphaToOneEnable;
+        case VK_DYNAMIC_STATE_LOGIC_OP_ENABLE_EXT:            return eds3.extendedDynamicState3LogicOpEnable;
+        case VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT:         return eds3.extendedDynamicState3ColorBlendEnable;
+        case VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT:       return eds3.extendedDynamicState3ColorBlendEquation;
+        case VK_DYNAMIC_STATE_COLOR_WRITE_MASK_EXT:           return eds3.extendedDynamicState3ColorWriteMask;
+        case VK_DYNAMIC_STATE_DEPTH_CLIP_ENABLE_EXT:          return eds3.extendedDynamicState3DepthClipEnable;
+        case VK_DYNAMIC_STATE_LINE_RASTERIZATION_MODE_EXT:    return eds3.extendedDynamicState3LineRasterizationMode;
+
+        default:
+            return false;
+    }
+}
+
+std::vector<VkDynamicState> FilterSupportedDynamicStates(const ExtendedDynamicStateSupport& support, uint32_t count, const VkDynamicState* p_states) {
+    std::vector<VkDynamicState> states;
+    states.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (IsDynamicStateSupported(support, p_states[i])) {
+            states.push_back(p_states[i]);
+        }
+    }
+    return states;
+}
+
+GraphicsBackend ChooseGraphicsBackend(VkPhysicalDevice physical_device) {
+    if (!IsPhysicalDeviceExtensionSupported(physical_device, { VK_EXT_SHADER_OBJECT_EXTENSION_NAME })) {
+        return GraphicsBackend::Pipeline;
+    }
+
+    VkPhysicalDeviceShaderObjectFeaturesEXT shader_object{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT };
+    VkPhysicalDeviceFeatures2 features2{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+    features2.pNext = &shader_object;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+
+    return shader_object.shaderObject ? GraphicsBackend::ShaderObject : GraphicsBackend::Pipeline;
+}
+
+VkPhysicalDeviceDescriptorBufferPropertiesEXT QueryDescriptorBufferProperties(VkPhysicalDevice physical_device) {
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT props{};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 props2{};
+    props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props2.pNext = &props;
+    vkGetPhysicalDeviceProperties2(physical_device, &props2);
+
+    props.pNext = nullptr;
+    return props;
+}
+
+bool IsPresentWaitSupported(VkPhysicalDevice physical_device) {
+    if (!IsPhysicalDeviceExtensionSupported(physical_device,
+        { VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME })) {
+        return false;
+    }
+
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait{};
+    present_wait.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    VkPhysicalDevicePresentIdFeaturesKHR present_id{};
+    present_id.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    present_id.pNext = &present_wait;
+
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &present_id;
+    vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+
+    return present_id.presentId && present_wait.presentWait;
+}
+
+} // wk
@@ -0,0 +1,34 @@
+#include <wk/shader_pack.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// wkpack <out.wkpack> <shader.spv>...
+// Entries are named after the input file name, e.g. "triangle.vert.spv".
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: wkpack <out.wkpack> <shader.spv>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<wk::ShaderPackSource> sources;
+    for (int i = 2; i < argc; ++i) {
+        wk::ShaderPackSource source;
+        source.name = std::filesystem::path(argv[i]).filename().string();
+        source.code = wk::ReadSpirvShader(argv[i]);
+        if (source.code.empty()) {
+            std::cerr << "wkpack: failed to read " << argv[i] << std::endl;
+            return 1;
+        }
+        sources.push_back(std::move(source));
+    }
+
+    try {
+        wk::WriteShaderPack(argv[1], static_cast<uint32_t>(sources.size()), sources.data());
+    } catch (const std::exception& e) {
+        std::cerr << "wkpack: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}